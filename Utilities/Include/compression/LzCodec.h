@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace utilities
+{
+	/*
+	 * Fast LZ77 byte compressor.
+	 *
+	 * A compressed block is a list of sequences. Each sequence starts with a token byte holding the amount of literals (upper 4 bits)
+	 * and the match length minus 4 (lower 4 bits). A value of 15 means more length bytes follow, each adding up to 255.
+	 * The literals follow the token, then the 16 bit match offset and any extra match length bytes.
+	 * The last sequence only has literals.
+	 *
+	 * Compression favors speed over ratio: matches are found through a single hash table lookup and the search skips ahead faster in data that does not compress.
+	 */
+	class LzCodec
+	{
+	public:
+		//Matches can refer back at most this many bytes.
+		static constexpr std::uint32_t MAX_OFFSET = 65535;
+		static constexpr std::uint32_t MIN_MATCH = 4;
+
+	public:
+		/*
+		 * Get the largest amount of bytes compress can produce for the given input size.
+		 */
+		static constexpr std::size_t getMaxCompressedSize(std::size_t size)
+		{
+			return size + size / 255 + 16;
+		}
+
+		/*
+		 * Compress size bytes from source into destination, which has to fit getMaxCompressedSize(size) bytes.
+		 * Returns the amount of bytes written.
+		 */
+		static std::size_t compress(const std::uint8_t* source, std::size_t size, std::uint8_t* destination);
+
+		/*
+		 * Decompress a block created by compress into destination, which has to be exactly decompressedSize bytes.
+		 * Returns false if the block is corrupt or does not decompress to exactly decompressedSize bytes.
+		 */
+		static bool decompress(const std::uint8_t* source, std::size_t size, std::uint8_t* destination, std::size_t decompressedSize);
+	};
+
+	/*
+	 * Compresses a stream of bytes into a series of LzCodec blocks.
+	 *
+	 * Every block starts with its decompressed size and its stored size, both 32 bit.
+	 * The highest bit of the stored size is set when the block did not compress and is stored as is.
+	 * A decompressed size of 0 marks the end of the stream.
+	 */
+	class LzEncoder
+	{
+	public:
+		//The amount of input bytes compressed together.
+		static constexpr std::uint32_t BLOCK_SIZE = 64 * 1024;
+		static constexpr std::uint32_t STORED_FLAG = 0x80000000u;
+
+	public:
+		/*
+		 * Create an encoder that appends the compressed stream to output.
+		 */
+		explicit LzEncoder(std::vector<std::uint8_t>& output);
+
+		/*
+		 * Add bytes to the stream. Full blocks are compressed right away.
+		 */
+		void write(const void* data, std::size_t size);
+
+		/*
+		 * Compress the remaining bytes and end the stream. Nothing can be written afterwards.
+		 */
+		void finish();
+
+	private:
+		void flushBlock();
+
+	private:
+		std::vector<std::uint8_t>& output;
+		std::vector<std::uint8_t> block;
+		bool finished;
+	};
+
+	/*
+	 * Decompresses a stream created by LzEncoder.
+	 * The compressed stream can be passed in pieces of any size.
+	 */
+	class LzDecoder
+	{
+	public:
+		/*
+		 * Create a decoder that appends the decompressed bytes to output.
+		 */
+		explicit LzDecoder(std::vector<std::uint8_t>& output);
+
+		/*
+		 * Add compressed bytes. Every block that is complete is decompressed.
+		 * Returns false if the stream is corrupt or continues after its end.
+		 */
+		bool write(const void* data, std::size_t size);
+
+		/*
+		 * Returns true once the end of the stream was decoded.
+		 */
+		bool isFinished() const;
+
+	private:
+		std::vector<std::uint8_t>& output;
+
+		//Bytes of a block that is not complete yet.
+		std::vector<std::uint8_t> pending;
+		bool finished;
+	};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TypelessPool.h"
+
+namespace utilities
+{
+	/*
+	 * Occupancy information about a SlabPool.
+	 */
+	struct SlabPoolStats
+	{
+		std::uint32_t slabCount = 0;			//The amount of slabs currently allocated.
+		std::uint32_t slotsPerSlab = 0;			//The amount of blocks that fit in a single slab.
+		std::uint32_t capacity = 0;				//The total amount of blocks that fit in all slabs.
+		std::uint32_t used = 0;					//The amount of blocks currently handed out.
+		std::uint32_t peakUsed = 0;				//The highest amount of blocks that was ever handed out at once.
+		std::uint64_t allocations = 0;			//The total amount of blocks handed out over the lifetime of the pool.
+		std::uint64_t slabAllocations = 0;		//The amount of times a new slab had to be allocated from the system.
+	};
+
+	/*
+	 * Growable pool of fixed size memory blocks.
+	 * Memory is allocated in slabs, each of which is a TypelessPool.
+	 * When all slabs are full a new slab is added, so allocation only fails when the system is out of memory.
+	 * Freed blocks are recycled by later allocations instead of being returned to the system.
+	 *
+	 * This is thread safe.
+	 */
+	class SlabPool
+	{
+		//Deleted functionality
+	public:
+		SlabPool(const SlabPool&) = delete;
+		SlabPool(SlabPool&&) = delete;
+		SlabPool& operator =(const SlabPool&) = delete;
+		SlabPool& operator =(SlabPool&&) = delete;
+
+	public:
+		/*
+		 * Create a pool handing out blocks of blockSize bytes, allocated slotsPerSlab at a time.
+		 * No memory is allocated until the first block is requested.
+		 */
+		SlabPool(std::uint32_t slotsPerSlab, std::uint32_t blockSize);
+
+	public:
+		/*
+		 * Get a block of memory. The memory is not initialized.
+		 */
+		void* allocate();
+
+		/*
+		 * Return a block of memory to the pool.
+		 * The block has to be allocated from this pool.
+		 */
+		void free(void* data);
+
+		/*
+		 * Release all slabs that have no blocks in use, keeping at least minimumSlabs slabs around.
+		 * Returns the amount of slabs released.
+		 */
+		std::uint32_t trim(std::uint32_t minimumSlabs = 0);
+
+		/*
+		 * Get occupancy information about this pool.
+		 */
+		SlabPoolStats getStats() const;
+
+		/*
+		 * Get the size in bytes of the blocks handed out by this pool.
+		 */
+		std::uint32_t getBlockSize() const;
+
+	private:
+		std::vector<std::unique_ptr<TypelessPool>> slabs;
+
+		//Index of a slab that is likely to have free space. Searched from here first.
+		std::size_t currentSlab;
+
+		std::uint32_t slotsPerSlab;
+		std::uint32_t blockSize;
+
+		SlabPoolStats stats;
+
+		mutable std::mutex mutex;
+	};
+}
@@ -67,6 +67,11 @@ namespace utilities
 		*/
 		void free(void* data);
 
+		/*
+		 * Returns true if the given address lies within the memory of this pool.
+		 */
+		bool owns(const void* data) const;
+
 		/*
 			Get the size of the type specified.
 		*/
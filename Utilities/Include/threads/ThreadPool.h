@@ -1,4 +1,7 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <queue>
 #include <thread>
@@ -41,6 +44,13 @@ namespace utilities
 		 */
 		void enqueue(std::function<void()> task);
 
+		/*
+		 * Call function(index, worker) for every index below count, on the calling thread and on the threads in the pool, and return when all calls finished.
+		 * worker is below numThreads() + 1 and differs between calls that run at the same time, so it can pick memory per thread.
+		 * Indices are handed out one at a time, so threads that finish early take over the remaining work.
+		 */
+		void parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& function);
+
 		~ThreadPool();
 	private:
 		//The amount of threads.
@@ -125,6 +135,43 @@ namespace utilities
 		condition.notify_one();
 	}
 
+	inline void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& function)
+	{
+		//Shared with the helpers, which may only start after the calling thread already finished all indices.
+		struct State
+		{
+			std::atomic<std::size_t> next{ 0 };
+			std::atomic<std::uint32_t> working{ 0 };
+			std::atomic<std::size_t> workers{ 0 };
+		};
+		auto state = std::make_shared<State>();
+
+		//A helper only calls the function for an index it took before the calling thread ran out of them, and then it is counted as working.
+		const auto run = [state, count, &function]()
+		{
+			++state->working;
+			const auto worker = state->workers++;
+			for(auto index = state->next++; index < count; index = state->next++)
+			{
+				function(index, worker);
+			}
+			--state->working;
+		};
+
+		const auto helpers = count > 1 ? std::min(size, count - 1) : 0;
+		for(std::size_t i = 0; i < helpers; ++i)
+		{
+			enqueue(run);
+		}
+		run();
+
+		//Helpers that start after this point find no indices left, so only the ones still working are waited for.
+		while(state->working != 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
 	// the destructor joins all threads
 	inline ThreadPool::~ThreadPool()
 	{
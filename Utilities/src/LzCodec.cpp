@@ -0,0 +1,345 @@
+#include "compression/LzCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace utilities
+{
+	namespace
+	{
+		constexpr std::uint32_t HASH_BITS = 12;
+
+		//The last bytes of a block are always literals, so that match copies never have to check for the end.
+		constexpr std::size_t LAST_LITERALS = 5;
+		constexpr std::size_t MATCH_LIMIT = 12;
+
+		std::uint32_t read32(const std::uint8_t* data)
+		{
+			std::uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		std::uint32_t hash(std::uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - HASH_BITS);
+		}
+
+		std::uint8_t* writeLength(std::uint8_t* destination, std::size_t length)
+		{
+			while (length >= 255)
+			{
+				*destination++ = 255;
+				length -= 255;
+			}
+			*destination++ = static_cast<std::uint8_t>(length);
+			return destination;
+		}
+
+		bool readLength(const std::uint8_t*& source, const std::uint8_t* end, std::size_t& length)
+		{
+			std::uint8_t value;
+			do
+			{
+				if (source == end)
+				{
+					return false;
+				}
+				value = *source++;
+				length += value;
+			} while (value == 255);
+			return true;
+		}
+
+		std::uint8_t* writeSequence(std::uint8_t* destination, const std::uint8_t* literals, std::size_t literalCount, std::size_t offset, std::size_t matchLength)
+		{
+			auto* token = destination++;
+			const auto matchCode = matchLength - LzCodec::MIN_MATCH;
+			*token = static_cast<std::uint8_t>((std::min<std::size_t>(literalCount, 15) << 4) | std::min<std::size_t>(matchCode, 15));
+
+			if (literalCount >= 15)
+			{
+				destination = writeLength(destination, literalCount - 15);
+			}
+			std::memcpy(destination, literals, literalCount);
+			destination += literalCount;
+
+			destination[0] = static_cast<std::uint8_t>(offset);
+			destination[1] = static_cast<std::uint8_t>(offset >> 8);
+			destination += 2;
+
+			if (matchCode >= 15)
+			{
+				destination = writeLength(destination, matchCode - 15);
+			}
+			return destination;
+		}
+	}
+
+	std::size_t LzCodec::compress(const std::uint8_t* source, std::size_t size, std::uint8_t* destination)
+	{
+		std::uint32_t table[1 << HASH_BITS] = {};
+		auto* out = destination;
+
+		std::size_t position = 0;
+		std::size_t anchor = 0;
+		const auto limit = size > MATCH_LIMIT ? size - MATCH_LIMIT : 0;
+
+		while (position < limit)
+		{
+			const auto sequence = read32(source + position);
+			const auto slot = hash(sequence);
+			const std::size_t candidate = table[slot];
+			table[slot] = static_cast<std::uint32_t>(position);
+
+			if (candidate >= position || position - candidate > MAX_OFFSET || read32(source + candidate) != sequence)
+			{
+				//Step further the longer nothing matched, so incompressible data is skipped quickly.
+				position += 1 + ((position - anchor) >> 6);
+				continue;
+			}
+
+			//Extend the match forward, then backward over literals that also match.
+			std::size_t length = MIN_MATCH;
+			while (position + length < size - LAST_LITERALS && source[candidate + length] == source[position + length])
+			{
+				++length;
+			}
+
+			auto start = position;
+			auto matchStart = candidate;
+			while (start > anchor && matchStart > 0 && source[start - 1] == source[matchStart - 1])
+			{
+				--start;
+				--matchStart;
+				++length;
+			}
+
+			out = writeSequence(out, source + anchor, start - anchor, start - matchStart, length);
+			position = start + length;
+			anchor = position;
+
+			//Index a position inside the match so the next search has a recent candidate.
+			if (position - 2 < limit)
+			{
+				table[hash(read32(source + position - 2))] = static_cast<std::uint32_t>(position - 2);
+			}
+		}
+
+		//The remaining bytes are literals.
+		const auto literalCount = size - anchor;
+		*out++ = static_cast<std::uint8_t>(std::min<std::size_t>(literalCount, 15) << 4);
+		if (literalCount >= 15)
+		{
+			out = writeLength(out, literalCount - 15);
+		}
+		std::memcpy(out, source + anchor, literalCount);
+		out += literalCount;
+
+		return static_cast<std::size_t>(out - destination);
+	}
+
+	bool LzCodec::decompress(const std::uint8_t* source, std::size_t size, std::uint8_t* destination, std::size_t decompressedSize)
+	{
+		const auto* end = source + size;
+		auto* out = destination;
+		auto* outEnd = destination + decompressedSize;
+
+		while (source < end)
+		{
+			const auto token = *source++;
+
+			std::size_t literalCount = token >> 4;
+			if (literalCount == 15 && !readLength(source, end, literalCount))
+			{
+				return false;
+			}
+			if (static_cast<std::size_t>(end - source) < literalCount || static_cast<std::size_t>(outEnd - out) < literalCount)
+			{
+				return false;
+			}
+			std::memcpy(out, source, literalCount);
+			source += literalCount;
+			out += literalCount;
+
+			//The last sequence has no match.
+			if (source == end)
+			{
+				break;
+			}
+
+			if (end - source < 2)
+			{
+				return false;
+			}
+			const std::size_t offset = source[0] | (static_cast<std::size_t>(source[1]) << 8);
+			source += 2;
+
+			std::size_t length = token & 15;
+			if (length == 15 && !readLength(source, end, length))
+			{
+				return false;
+			}
+			length += MIN_MATCH;
+
+			if (offset == 0 || offset > static_cast<std::size_t>(out - destination) || static_cast<std::size_t>(outEnd - out) < length)
+			{
+				return false;
+			}
+
+			//Matches may overlap the bytes they produce, which repeats the pattern. Only copy in bulk when they do not.
+			const auto* match = out - offset;
+			if (offset >= length)
+			{
+				std::memcpy(out, match, length);
+				out += length;
+			}
+			else
+			{
+				for (std::size_t i = 0; i < length; ++i)
+				{
+					*out++ = *match++;
+				}
+			}
+		}
+
+		return out == outEnd;
+	}
+
+	LzEncoder::LzEncoder(std::vector<std::uint8_t>& output) : output(output), finished(false)
+	{
+	}
+
+	void LzEncoder::write(const void* data, std::size_t size)
+	{
+		const auto* bytes = static_cast<const std::uint8_t*>(data);
+		while (size > 0)
+		{
+			const auto count = std::min<std::size_t>(size, BLOCK_SIZE - block.size());
+			block.insert(block.end(), bytes, bytes + count);
+			bytes += count;
+			size -= count;
+
+			if (block.size() == BLOCK_SIZE)
+			{
+				flushBlock();
+			}
+		}
+	}
+
+	void LzEncoder::finish()
+	{
+		if (finished)
+		{
+			return;
+		}
+
+		flushBlock();
+
+		const std::uint8_t end[8] = {};
+		output.insert(output.end(), end, end + sizeof(end));
+		finished = true;
+	}
+
+	void LzEncoder::flushBlock()
+	{
+		if (block.empty())
+		{
+			return;
+		}
+
+		//Compress straight into the output, and fall back to storing the block when that did not make it smaller.
+		const auto start = output.size();
+		output.resize(start + 8 + LzCodec::getMaxCompressedSize(block.size()));
+		auto storedSize = static_cast<std::uint32_t>(LzCodec::compress(block.data(), block.size(), output.data() + start + 8));
+		if (storedSize >= block.size())
+		{
+			std::memcpy(output.data() + start + 8, block.data(), block.size());
+			storedSize = static_cast<std::uint32_t>(block.size()) | STORED_FLAG;
+		}
+
+		const auto rawSize = static_cast<std::uint32_t>(block.size());
+		std::memcpy(output.data() + start, &rawSize, sizeof(rawSize));
+		std::memcpy(output.data() + start + 4, &storedSize, sizeof(storedSize));
+		output.resize(start + 8 + (storedSize & ~STORED_FLAG));
+
+		block.clear();
+	}
+
+	LzDecoder::LzDecoder(std::vector<std::uint8_t>& output) : output(output), finished(false)
+	{
+	}
+
+	bool LzDecoder::write(const void* data, std::size_t size)
+	{
+		const auto* bytes = static_cast<const std::uint8_t*>(data);
+
+		//Avoid copying when whole blocks are passed at once, which is the common case.
+		const std::uint8_t* current = bytes;
+		const std::uint8_t* end = bytes + size;
+		if (!pending.empty())
+		{
+			pending.insert(pending.end(), bytes, end);
+			current = pending.data();
+			end = pending.data() + pending.size();
+		}
+
+		while (end - current >= 8)
+		{
+			if (finished)
+			{
+				return false;
+			}
+
+			std::uint32_t rawSize, storedSize;
+			std::memcpy(&rawSize, current, sizeof(rawSize));
+			std::memcpy(&storedSize, current + 4, sizeof(storedSize));
+
+			if (rawSize == 0)
+			{
+				finished = true;
+				current += 8;
+				continue;
+			}
+
+			const auto stored = (storedSize & LzEncoder::STORED_FLAG) != 0;
+			storedSize &= ~LzEncoder::STORED_FLAG;
+			if (rawSize > LzEncoder::BLOCK_SIZE || storedSize > LzCodec::getMaxCompressedSize(rawSize) || (stored && storedSize != rawSize))
+			{
+				return false;
+			}
+			if (static_cast<std::size_t>(end - current) - 8 < storedSize)
+			{
+				break;
+			}
+
+			const auto start = output.size();
+			output.resize(start + rawSize);
+			if (stored)
+			{
+				std::memcpy(output.data() + start, current + 8, rawSize);
+			}
+			else if (!LzCodec::decompress(current + 8, storedSize, output.data() + start, rawSize))
+			{
+				output.resize(start);
+				return false;
+			}
+			current += 8 + storedSize;
+		}
+
+		if (current != end && finished)
+		{
+			return false;
+		}
+
+		//Keep the incomplete block for the next call.
+		std::vector<std::uint8_t> remaining(current, end);
+		pending.swap(remaining);
+		return true;
+	}
+
+	bool LzDecoder::isFinished() const
+	{
+		return finished;
+	}
+}
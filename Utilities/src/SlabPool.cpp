@@ -0,0 +1,114 @@
+#include "memory/SlabPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace utilities
+{
+	SlabPool::SlabPool(std::uint32_t slotsPerSlab, std::uint32_t blockSize) : currentSlab(0), slotsPerSlab(slotsPerSlab), blockSize(blockSize)
+	{
+		if (slotsPerSlab == 0 || blockSize == 0)
+		{
+			throw std::runtime_error("Cannot create slab pool with empty slabs.");
+		}
+
+		stats.slotsPerSlab = slotsPerSlab;
+	}
+
+	void* SlabPool::allocate()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		//Find a slab with a free slot, starting at the last slab that had one.
+		std::size_t found = slabs.size();
+		for (std::size_t i = 0; i < slabs.size(); ++i)
+		{
+			const auto index = (currentSlab + i) % slabs.size();
+			if (!slabs[index]->isFull())
+			{
+				found = index;
+				break;
+			}
+		}
+
+		//All slabs are full, so grow.
+		if (found == slabs.size())
+		{
+			slabs.emplace_back(std::make_unique<TypelessPool>(slotsPerSlab, blockSize));
+			++stats.slabAllocations;
+			++stats.slabCount;
+			stats.capacity += slotsPerSlab;
+		}
+
+		currentSlab = found;
+
+		++stats.used;
+		++stats.allocations;
+		stats.peakUsed = std::max(stats.peakUsed, stats.used);
+
+		return slabs[found]->allocate();
+	}
+
+	void SlabPool::free(void* data)
+	{
+		if (data == nullptr)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (std::size_t i = 0; i < slabs.size(); ++i)
+		{
+			if (slabs[i]->owns(data))
+			{
+				slabs[i]->free(data);
+				--stats.used;
+
+				//Prefer refilling this slab so that other slabs can empty out and be trimmed.
+				currentSlab = i;
+				return;
+			}
+		}
+
+		assert(0 && "Trying to free memory that was not allocated from this slab pool!");
+	}
+
+	std::uint32_t SlabPool::trim(std::uint32_t minimumSlabs)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::uint32_t released = 0;
+		auto itr = slabs.begin();
+		while (itr != slabs.end() && slabs.size() > minimumSlabs)
+		{
+			if ((*itr)->getObjectCount() == 0)
+			{
+				itr = slabs.erase(itr);
+				++released;
+			}
+			else
+			{
+				++itr;
+			}
+		}
+
+		stats.slabCount -= released;
+		stats.capacity -= released * slotsPerSlab;
+		currentSlab = 0;
+
+		return released;
+	}
+
+	SlabPoolStats SlabPool::getStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+	std::uint32_t SlabPool::getBlockSize() const
+	{
+		return blockSize;
+	}
+}
@@ -41,7 +41,7 @@ namespace utilities
 
 	bool TypelessPool::isFull() const
 	{
-		return objectCount < size;
+		return objectCount >= size;
 	}
 
 	std::uint32_t TypelessPool::getObjectCount() const
@@ -116,6 +116,12 @@ namespace utilities
 		--objectCount;
 	}
 
+	bool TypelessPool::owns(const void* data) const
+	{
+		const auto* address = static_cast<const std::uint8_t*>(data);
+		return address >= pool && address < pool + (static_cast<std::uint64_t>(size) * static_cast<std::uint64_t>(typeSize));
+	}
+
 	std::uint16_t TypelessPool::getTypeSize() const
 	{
 		return typeSize;
@@ -0,0 +1,209 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <compression/LzCodec.h>
+
+#include "Utility.h"
+#include "VoxelData.h"
+
+namespace voxl
+{
+    /*
+     * Compression for the voxels of a single chunk, used both for region files and chunk packets.
+     *
+     * The voxels are first turned into a palette of unique values and runs of equal palette indices, walking the chunk in voxel index order.
+     * Terrain is mostly horizontal layers, so this order produces long runs.
+     * The result is then compressed with LzCodec, which picks up patterns that repeat across rows such as trees and caves.
+     *
+     * Layout before LZ compression: u16 palette size, the palette as raw 32 bit values, then the runs.
+     * Each run is a variable length run length minus one (7 bits per byte, low bits first), followed by a u8 palette index when the palette has at most 256 entries or a u16 index otherwise.
+     */
+    class ChunkCodec
+    {
+    public:
+        //Worst case: every voxel unique, so a full palette and a 1 byte run length plus a 2 byte index per voxel.
+        static constexpr std::size_t MAX_RUN_SIZE = 2 + CHUNK_SIZE_CUBED * sizeof(VoxelData) + CHUNK_SIZE_CUBED * 3;
+
+        //Worst case size of an encoded chunk: the runs stored uncompressed in one block, plus the block header and end of stream marker.
+        static constexpr std::size_t MAX_ENCODED_SIZE = MAX_RUN_SIZE + 16;
+
+    public:
+        /*
+         * Append the CHUNK_SIZE_CUBED voxels of a chunk to an LZ stream.
+         * Several chunks can be written to the same stream and read back one after the other with DecodeRuns.
+         */
+        static void Encode(const VoxelData* a_Voxels, utilities::LzEncoder& a_Encoder)
+        {
+            std::vector<std::uint8_t> runs;
+            EncodeRuns(a_Voxels, runs);
+            a_Encoder.write(runs.data(), runs.size());
+        }
+
+        /*
+         * Encode a single chunk into a complete stream appended to a_Output.
+         */
+        static void Encode(const VoxelData* a_Voxels, std::vector<std::uint8_t>& a_Output)
+        {
+            utilities::LzEncoder encoder(a_Output);
+            Encode(a_Voxels, encoder);
+            encoder.finish();
+        }
+
+        /*
+         * Decode a stream holding a single chunk into CHUNK_SIZE_CUBED voxels.
+         * Returns false if the data is corrupt. a_Voxels may be partially written in that case.
+         */
+        static bool Decode(const std::uint8_t* a_Data, std::size_t a_Size, VoxelData* a_Voxels)
+        {
+            std::vector<std::uint8_t> runs;
+            utilities::LzDecoder decoder(runs);
+            if(!decoder.write(a_Data, a_Size) || !decoder.isFinished())
+            {
+                return false;
+            }
+
+            const auto* end = runs.data() + runs.size();
+            return DecodeRuns(runs.data(), end, a_Voxels) == end;
+        }
+
+        /*
+         * Convert voxels into the palette and run representation, appended to a_Output.
+         */
+        static void EncodeRuns(const VoxelData* a_Voxels, std::vector<std::uint8_t>& a_Output)
+        {
+            //Build the palette in order of first appearance.
+            std::vector<std::uint32_t> palette;
+            std::vector<std::uint16_t> indices(CHUNK_SIZE_CUBED);
+            std::unordered_map<std::uint32_t, std::uint16_t> lookup;
+
+            std::uint32_t previousKey = 0;
+            std::uint16_t previousIndex = 0;
+            for(std::uint32_t i = 0; i < CHUNK_SIZE_CUBED; ++i)
+            {
+                std::uint32_t key;
+                std::memcpy(&key, &a_Voxels[i], sizeof(key));
+
+                //Neighbours are usually equal, so skip the lookup in that case.
+                if(i != 0 && key == previousKey)
+                {
+                    indices[i] = previousIndex;
+                    continue;
+                }
+
+                const auto found = lookup.emplace(key, static_cast<std::uint16_t>(palette.size()));
+                if(found.second)
+                {
+                    palette.push_back(key);
+                }
+                previousKey = key;
+                previousIndex = found.first->second;
+                indices[i] = previousIndex;
+            }
+
+            const auto paletteSize = static_cast<std::uint16_t>(palette.size());
+            const auto wideIndices = palette.size() > 256;
+            const auto start = a_Output.size();
+            a_Output.resize(start + sizeof(paletteSize) + palette.size() * sizeof(std::uint32_t));
+            std::memcpy(a_Output.data() + start, &paletteSize, sizeof(paletteSize));
+            std::memcpy(a_Output.data() + start + sizeof(paletteSize), palette.data(), palette.size() * sizeof(std::uint32_t));
+
+            std::uint32_t i = 0;
+            while(i < CHUNK_SIZE_CUBED)
+            {
+                std::uint32_t run = 1;
+                while(i + run < CHUNK_SIZE_CUBED && indices[i + run] == indices[i])
+                {
+                    ++run;
+                }
+
+                auto length = run - 1;
+                while(length >= 0x80)
+                {
+                    a_Output.push_back(static_cast<std::uint8_t>(length | 0x80));
+                    length >>= 7;
+                }
+                a_Output.push_back(static_cast<std::uint8_t>(length));
+
+                a_Output.push_back(static_cast<std::uint8_t>(indices[i]));
+                if(wideIndices)
+                {
+                    a_Output.push_back(static_cast<std::uint8_t>(indices[i] >> 8));
+                }
+                i += run;
+            }
+        }
+
+        /*
+         * Convert one chunk in the palette and run representation back into voxels.
+         * Returns a pointer past the chunk, or nullptr if the data is truncated or invalid.
+         */
+        static const std::uint8_t* DecodeRuns(const std::uint8_t* a_Data, const std::uint8_t* a_End, VoxelData* a_Voxels)
+        {
+            if(a_End - a_Data < 2)
+            {
+                return nullptr;
+            }
+
+            std::uint16_t paletteSize;
+            std::memcpy(&paletteSize, a_Data, sizeof(paletteSize));
+            a_Data += sizeof(paletteSize);
+            if(paletteSize == 0 || paletteSize > CHUNK_SIZE_CUBED || static_cast<std::size_t>(a_End - a_Data) < paletteSize * sizeof(VoxelData))
+            {
+                return nullptr;
+            }
+
+            const auto* palette = a_Data;
+            a_Data += paletteSize * sizeof(VoxelData);
+            const auto wideIndices = paletteSize > 256;
+
+            std::uint32_t i = 0;
+            while(i < CHUNK_SIZE_CUBED)
+            {
+                std::uint32_t length = 0;
+                std::uint32_t shift = 0;
+                std::uint8_t byte;
+                do
+                {
+                    if(a_Data == a_End || shift > 14)
+                    {
+                        return nullptr;
+                    }
+                    byte = *a_Data++;
+                    length |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+                    shift += 7;
+                } while(byte & 0x80);
+
+                const std::size_t indexSize = wideIndices ? 2 : 1;
+                if(static_cast<std::size_t>(a_End - a_Data) < indexSize)
+                {
+                    return nullptr;
+                }
+                std::uint32_t index = a_Data[0];
+                if(wideIndices)
+                {
+                    index |= static_cast<std::uint32_t>(a_Data[1]) << 8;
+                }
+                a_Data += indexSize;
+
+                const auto run = length + 1;
+                if(index >= paletteSize || run > CHUNK_SIZE_CUBED - i)
+                {
+                    return nullptr;
+                }
+
+                VoxelData value;
+                std::memcpy(&value, palette + index * sizeof(VoxelData), sizeof(VoxelData));
+                for(std::uint32_t j = 0; j < run; ++j)
+                {
+                    a_Voxels[i + j] = value;
+                }
+                i += run;
+            }
+
+            return a_Data;
+        }
+    };
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+#include "Utility.h"
+
+namespace voxl
+{
+    /*
+     * Counter-based random number stream for world generation.
+     *
+     * The stream is fully determined by the world seed, the chunk coordinates and a stage chosen by the generator.
+     * Value n of the stream is a hash of that key and n, so it does not depend on any earlier draws, on other chunks or on the thread it is computed on.
+     * Generators should use this instead of global or stateful random number generators, so that a world is identical no matter in which order or on how many threads its chunks are generated.
+     *
+     * Use a different stage for every independent use within a generator, so that adding draws to one does not shift the values of the others.
+     */
+    class ChunkRandom
+    {
+    public:
+        ChunkRandom(std::uint64_t a_Seed, const glm::ivec3& a_Chunk, std::uint32_t a_Stage) : m_Counter(0)
+        {
+            auto key = Mix64(a_Seed + GOLDEN_GAMMA);
+            key = Mix64(key ^ ((static_cast<std::uint64_t>(static_cast<std::uint32_t>(a_Chunk.x)) << 32) | static_cast<std::uint32_t>(a_Chunk.y)));
+            key = Mix64(key ^ ((static_cast<std::uint64_t>(static_cast<std::uint32_t>(a_Chunk.z)) << 32) | a_Stage));
+            m_Key = key;
+        }
+
+        /*
+         * Get value a_Counter of the stream without advancing it.
+         */
+        std::uint64_t At(std::uint64_t a_Counter) const
+        {
+            return Mix64(m_Key + (a_Counter + 1) * GOLDEN_GAMMA);
+        }
+
+        /*
+         * Get the next 64 random bits.
+         */
+        std::uint64_t NextUInt64()
+        {
+            return At(m_Counter++);
+        }
+
+        /*
+         * Get the next 32 random bits.
+         */
+        std::uint32_t NextUInt32()
+        {
+            return static_cast<std::uint32_t>(NextUInt64() >> 32);
+        }
+
+        /*
+         * Get a number in the range [0, 1).
+         */
+        float NextFloat()
+        {
+            return static_cast<float>(NextUInt64() >> 40) * (1.0f / 16777216.0f);
+        }
+
+        /*
+         * Get a uniformly distributed integer in the range [a_Min, a_Max].
+         */
+        std::int32_t NextInt(std::int32_t a_Min, std::int32_t a_Max)
+        {
+            const auto range = static_cast<std::uint64_t>(static_cast<std::int64_t>(a_Max) - a_Min) + 1;
+
+            //Scale a 32 bit value into the range, and reject the few values that would make low results more likely.
+            auto product = static_cast<std::uint64_t>(NextUInt32()) * range;
+            if(static_cast<std::uint32_t>(product) < range)
+            {
+                const auto threshold = static_cast<std::uint32_t>((0x100000000ull - range) % range);
+                while(static_cast<std::uint32_t>(product) < threshold)
+                {
+                    product = static_cast<std::uint64_t>(NextUInt32()) * range;
+                }
+            }
+            return static_cast<std::int32_t>(a_Min + static_cast<std::int64_t>(product >> 32));
+        }
+
+        /*
+         * Returns true with the given probability.
+         */
+        bool NextChance(float a_Probability)
+        {
+            return NextFloat() < a_Probability;
+        }
+
+        /*
+         * Get an independent stream derived from this one, for example one per structure placed in the chunk.
+         * The result only depends on this stream's key and a_Stream, not on how far this stream has advanced.
+         */
+        ChunkRandom Fork(std::uint32_t a_Stream) const
+        {
+            return ChunkRandom(Mix64(m_Key ^ Mix64(a_Stream + GOLDEN_GAMMA)));
+        }
+
+        /*
+         * Get the amount of values drawn so far.
+         */
+        std::uint64_t GetCounter() const
+        {
+            return m_Counter;
+        }
+
+    private:
+        static constexpr std::uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+        explicit ChunkRandom(std::uint64_t a_Key) : m_Key(a_Key), m_Counter(0)
+        {
+
+        }
+
+    private:
+        std::uint64_t m_Key;
+        std::uint64_t m_Counter;
+    };
+}
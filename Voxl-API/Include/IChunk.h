@@ -16,6 +16,16 @@ namespace voxl
         READY
     };
 
+    /*
+     * The way a chunk stores its voxels in memory.
+     */
+    enum class ChunkStorage
+    {
+        FLAT,       //Every voxel is stored as a full VoxelData in one array.
+        PALETTE,    //Every unique voxel is stored once in a palette, and voxels are bit-packed indices into that palette.
+        UNIFORM     //Every voxel has the same value, which is stored once.
+    };
+
     /*
      * Interface detailing a chunk containing voxel data.
      * The size of a chunk is defined in Utility.h which also offers some utility functions to access the data in a chunk.
@@ -46,14 +56,64 @@ namespace voxl
 
         /*
          * Get a pointer to the array of voxels in this chunk.
+         * Returns nullptr when the chunk is not stored as a flat array. Use the accessors below in that case.
          */
         virtual VoxelData* GetVoxelData() = 0;
 
         /*
          * Get a const pointer to the array of voxels in this chunk.
+         * Returns nullptr when the chunk is not stored as a flat array. Use the accessors below in that case.
          */
         virtual VoxelData const* GetVoxelData() const = 0;
 
+        /*
+         * Get the voxel at the given index, regardless of how the chunk is stored.
+         * Use GetVoxelIndex to convert local coordinates to an index.
+         */
+        virtual VoxelData GetVoxel(std::uint32_t a_Index) const = 0;
+
+        /*
+         * Set the voxel at the given index, regardless of how the chunk is stored.
+         */
+        virtual void SetVoxel(std::uint32_t a_Index, const VoxelData& a_Data) = 0;
+
+        /*
+         * Copy all CHUNK_SIZE_CUBED voxels of this chunk into a_Destination.
+         */
+        virtual void GetVoxels(VoxelData* a_Destination) const = 0;
+
+        /*
+         * Overwrite all CHUNK_SIZE_CUBED voxels of this chunk with the voxels in a_Source.
+         */
+        virtual void SetVoxels(const VoxelData* a_Source) = 0;
+
+        /*
+         * Set every voxel in this chunk to the given value.
+         * This stores the chunk as UNIFORM.
+         */
+        virtual void Fill(const VoxelData& a_Data) = 0;
+
+        /*
+         * Get the way this chunk currently stores its voxels.
+         */
+        virtual ChunkStorage GetStorage() const = 0;
+
+        /*
+         * Convert the chunk to the given storage type.
+         * Chunks can only be converted to UNIFORM when all voxels are equal.
+         */
+        virtual void SetStorage(ChunkStorage a_Storage) = 0;
+
+        /*
+         * Convert the chunk to the storage type that uses the least memory for its current contents.
+         */
+        virtual void Compact() = 0;
+
+        /*
+         * Get the amount of memory in bytes used to store the voxels in this chunk.
+         */
+        virtual std::size_t GetMemoryUsage() const = 0;
+
         /*
          * Save the chunk for the given world.
          */
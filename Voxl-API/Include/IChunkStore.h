@@ -6,6 +6,47 @@
 
 namespace voxl
 {
+    /*
+     * Iterator over the chunks in a chunk store.
+     * Chunk stores keep their chunks in a contiguous array of owning pointers.
+     * This walks that array linearly and dereferences to the chunk itself.
+     */
+    template<typename T>
+    class ChunkIterator
+    {
+    public:
+        ChunkIterator(const std::unique_ptr<IChunk>* a_Current = nullptr) : m_Current(a_Current) {}
+
+        T& operator*() const
+        {
+            return **m_Current;
+        }
+
+        T* operator->() const
+        {
+            return m_Current->get();
+        }
+
+        ChunkIterator& operator++()
+        {
+            ++m_Current;
+            return *this;
+        }
+
+        bool operator==(const ChunkIterator& a_Other) const
+        {
+            return m_Current == a_Other.m_Current;
+        }
+
+        bool operator!=(const ChunkIterator& a_Other) const
+        {
+            return m_Current != a_Other.m_Current;
+        }
+
+    private:
+        const std::unique_ptr<IChunk>* m_Current;
+    };
+
     /*
      * ChunkStore stores chunks of the given type.
      * Functionality to iterate over the chunks is provided in the form of iterators.
@@ -14,8 +55,8 @@ namespace voxl
     {
     public:
         //used to iterate over chunks.
-        typedef IChunk* iterator;
-        typedef const IChunk* const_iterator;
+        typedef ChunkIterator<IChunk> iterator;
+        typedef ChunkIterator<const IChunk> const_iterator;
 
     public:
         virtual ~IChunkStore() = default;
@@ -49,6 +90,7 @@ namespace voxl
 
     public:
         //Iterators to allow range based for loops to iterater over the internal data.
+        //Loading or unloading chunks invalidates these iterators.
         virtual iterator begin() = 0;
         virtual iterator end() = 0;
         virtual const_iterator begin() const = 0;
@@ -4,6 +4,7 @@
 
 
 #include "ConnectionState.h"
+#include "PacketSerialization.h"
 
 namespace voxl
 {
@@ -44,18 +45,33 @@ namespace voxl
         virtual std::string GetIp() = 0;
 
         /*
-        * Send a packet to the client.
-        */
-        virtual void SendPacket(const IPacket& a_Data, size_t a_Size) = 0;
+         * Get a buffer of a_Size bytes to write the next packet into, or nullptr when nothing can be sent.
+         * The packet is sent on a_Channel by EndPacket, which has to be called before the next packet is started.
+         * Connections may hold on to packets and send them together with later ones, see ReadMessage.
+         */
+        virtual std::uint8_t* BeginPacket(std::size_t a_Size, std::uint8_t a_Channel) = 0;
+
+        /*
+         * Send the packet written into the buffer returned by BeginPacket.
+         */
+        virtual void EndPacket() = 0;
 
         /*
          * Send a packet to the client with type awareness.
+         * The fields of the packet are written straight into the send buffer, see PacketSerialization.h.
          */
         template<typename T>
-        void SendTypedPacket(const T& a_Data)
+        void SendTypedPacket(const T& a_Data, std::uint8_t a_Channel = 0)
         {
             static_assert(std::is_base_of_v<IPacket, T>, "Can only send templated packet with a class derived from Packet.");
-            SendPacket(a_Data, sizeof(T));
+            const auto size = GetPacketSize(a_Data);
+            auto* buffer = BeginPacket(size, a_Channel);
+            if(buffer != nullptr)
+            {
+                PacketWriter writer(buffer, size);
+                WritePacket(writer, a_Data);
+                EndPacket();
+            }
         }
     };
 }
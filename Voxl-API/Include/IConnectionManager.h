@@ -50,5 +50,10 @@ namespace voxl
          * Disconnect all clients.
          */
         virtual void DisconnectClients() = 0;
+
+        /*
+         * Send the packets that were collected for every client during the tick. Called at the end of every tick.
+         */
+        virtual void FlushClientConnections() = 0;
     };
 }
@@ -1,4 +1,7 @@
 #pragma once
+#include <type_traits>
+
+#include "PacketSerialization.h"
 
 namespace voxl
 {
@@ -14,9 +17,10 @@ namespace voxl
         virtual ~IPacketHandler() = default;
 
         /*
-         * Resolve a packet.
+         * Read the fields of a packet whose type was already read from a_Reader, and resolve it.
+         * Returns false when the packet is malformed or could not be handled.
          */
-        virtual bool Resolve(IPacket& a_Data, IConnection* a_Sender) = 0;
+        virtual bool Resolve(PacketReader& a_Reader, IConnection* a_Sender) = 0;
     };
 
     /*
@@ -35,10 +39,14 @@ namespace voxl
         /*
          * Internal conversion function.
          */
-        bool Resolve(IPacket& a_Data, IConnection* a_Sender) final override
+        bool Resolve(PacketReader& a_Reader, IConnection* a_Sender) final override
         {
-            auto* derived = static_cast<T*>(&a_Data);
-            return OnResolve(*derived, a_Sender);
+            T packet;
+            if(!ReadPacket(a_Reader, packet))
+            {
+                return false;
+            }
+            return OnResolve(packet, a_Sender);
         }
     };
 }
\ No newline at end of file
@@ -7,7 +7,7 @@ namespace voxl
     enum class PacketType;
     class IPacketHandler;
     class IConnection;
-    struct IPacket;
+    class PacketReader;
 
     class IPacketManager
     {
@@ -16,10 +16,10 @@ namespace voxl
 
         /*
          * Resolve a packet.
-         * This looks up the PacketHandler instance that was registered for this packet type.
+         * This looks up the PacketHandler instance that was registered for this packet type, which reads the rest of the packet from a_Reader.
          * When no sender is available, nullptr can be passed.
          */
-        virtual bool Resolve(PacketType a_Type, IPacket& a_Data, IConnection* a_Sender) = 0;
+        virtual bool Resolve(PacketType a_Type, PacketReader& a_Reader, IConnection* a_Sender) = 0;
 
         /*
          * Register a specific packet to be handled by a specific class.
@@ -0,0 +1,25 @@
+#pragma once
+#include <glm/vec3.hpp>
+
+#include "VoxelData.h"
+
+namespace voxl
+{
+    /*
+     * Passed to IWorldGenerator::Populate to place voxels that do not fit in the chunk being populated, like trees on its border.
+     */
+    class IPopulateContext
+    {
+    public:
+        virtual ~IPopulateContext() = default;
+
+        /*
+         * Set the voxel at the given world voxel coordinates.
+         *
+         * Voxels in the chunk being populated are set immediately.
+         * Voxels in other chunks are queued and set once that chunk is populated or loaded, which may be much later.
+         * A queued voxel only replaces a voxel with a lower id, or the same id and lower metadata, so that the outcome does not depend on the order in which chunks are populated.
+         */
+        virtual void SetVoxel(const glm::ivec3& a_Position, const VoxelData& a_Data) = 0;
+    };
+}
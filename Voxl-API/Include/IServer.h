@@ -5,6 +5,11 @@
 
 #include "logging/Logger.h"
 
+namespace utilities
+{
+    class ThreadPool;
+}
+
 #define GAMEMODES_FOLDER "gamemodes"
 
 namespace voxl
@@ -45,6 +50,24 @@ namespace voxl
 
         //The port to listen at.
         std::uint32_t port = 28280;
+
+        //Every chunk that changes is saved within this many seconds. 0 disables autosaving.
+        std::uint32_t autosaveInterval = 300;
+
+        //Maximum amount of chunks autosaved per tick.
+        std::uint32_t autosaveChunksPerTick = 32;
+
+        //Maximum time spent autosaving per tick in microseconds. 0 means no limit.
+        std::uint32_t autosaveMicrosPerTick = 2000;
+
+        //Maximum bytes of chunks sent to a single client per tick. Less is sent when the client can not keep up.
+        std::uint32_t chunkSendBytesPerTick = 64 * 1024;
+
+        //Maximum bytes of chunks sent to all clients together per tick, shared evenly. 0 means no limit.
+        std::uint32_t chunkSendTotalBytesPerTick = 256 * 1024;
+
+        //Distance in voxels between climate samples of the default world generator. Worlds keep the value they were created with.
+        std::uint32_t climateSpacing = 4;
     };
 
     /*
@@ -97,6 +120,11 @@ namespace voxl
          */
         virtual void RegisterGameMode(const std::string& a_Name, std::shared_ptr<IGameMode>& a_GameMode) = 0;
 
+        /*
+         * Get the registry containing all voxel types.
+         */
+        virtual VoxelRegistry& GetVoxelRegistry() = 0;
+
         /*
          * Get the world generator registered with the given name.
          * If no world generator exists with that name, nullptr is returned.
@@ -148,5 +176,10 @@ namespace voxl
          * Get a reference to the servers connection manager.
          */
         virtual IConnectionManager& GetConnectionManager() = 0;
+
+        /*
+         * Get the thread pool used for background work such as saving chunks.
+         */
+        virtual utilities::ThreadPool& GetThreadPool() = 0;
     };
 }
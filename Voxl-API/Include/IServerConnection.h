@@ -8,8 +8,8 @@
 
 namespace voxl
 {
-    struct IPacket;
     class IPacketManager;
+    class PacketReader;
 
     /*
      * An interface to handle a connection from client to server.
@@ -38,8 +38,8 @@ namespace voxl
          * Wait for a specific packet.
          * This will discard other packets.
          * If no packets have been received before the timeout time is reached, false is returned.
-         * If a packet was received, true is returned and the registered callback will be executed.
+         * If a packet was received, true is returned and the registered callback will be executed with a reader positioned after the packet type.
          */
-        virtual bool WaitForPacket(PacketType a_Type, std::uint32_t a_TimeOutMillis, std::function<void(IPacket* a_Packet)> a_OnReceive) = 0;
+        virtual bool WaitForPacket(PacketType a_Type, std::uint32_t a_TimeOutMillis, std::function<void(PacketReader& a_Reader)> a_OnReceive) = 0;
     };
 }
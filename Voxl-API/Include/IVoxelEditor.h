@@ -1,17 +1,50 @@
 #pragma once
+#include <cstdint>
 #include <functional>
+#include <vector>
 #include <glm/glm.hpp>
 
+#include "Utility.h"
+#include "VoxelData.h"
+
 namespace voxl
 {
-    struct VoxelData;
     class IChunkStore;
 
+    /*
+     * Where a voxel update comes from. When updates from several sources hit the same voxel in one tick, only the one with the highest priority is applied.
+     * Between updates of the same priority, the one queued last wins.
+     */
+    enum class EditPriority : std::uint8_t
+    {
+        POPULATION = 0, //Structures that the population of a neighbouring chunk placed in this one. These only fill empty voxels, so they never replace anything.
+        PHYSICS = 1,    //Simulated changes such as falling or flowing voxels, which are simply computed again next tick.
+        PLAYER = 2,     //Voxels placed or broken by players.
+        SCRIPT = 3      //Plugins and commands, which have to be able to overrule players, for example to protect an area.
+    };
+
+    /*
+     * The final value of a voxel that was changed in a tick.
+     */
+    struct VoxelChange
+    {
+        glm::ivec3 position;
+        VoxelData data;
+    };
+
     /*
      * VoxelEditor allows the world to be changed.
      */
     class IVoxelEditor
     {
+    public:
+        /*
+         * Function used to edit the part of a region inside a single chunk.
+         * It receives the world coordinates of the chunk's first voxel, the first and last local coordinates of the part that is inside the region,
+         * and all voxels of the chunk as a flat array indexed with GetVoxelIndex. It returns true when it changed any voxel.
+         */
+        using ChunkFunction = std::function<bool(const glm::ivec3& a_ChunkOrigin, const glm::uvec3& a_Min, const glm::uvec3& a_Max, VoxelData* a_Voxels)>;
+
     public:
         virtual ~IVoxelEditor() = default;
 
@@ -22,16 +55,67 @@ namespace voxl
          */
         virtual void QueueUpdates(const glm::ivec3& a_Start, const glm::ivec3& a_End, const std::function<bool(const glm::ivec3&, VoxelData&)>& a_Function) = 0;
 
+        /*
+         * Queue an edit of a region that is applied one chunk at a time, see ChunkFunction.
+         * The function is only called for chunks that are loaded when the changes are applied.
+         */
+        virtual void QueueChunkUpdates(const glm::ivec3& a_Start, const glm::ivec3& a_End, const ChunkFunction& a_Function) = 0;
+
+        /*
+         * Queue setting every voxel in a region to the same value.
+         * Chunks that are completely inside the region are stored as uniform chunks.
+         */
+        virtual void QueueFill(const glm::ivec3& a_Start, const glm::ivec3& a_End, const VoxelData& a_Data) = 0;
+
         /*
          * Queue a voxel update.
+         * Of all updates queued for the same voxel before the next apply, only one is applied, see EditPriority.
+         * Region edits are applied after all single updates, so they always overwrite them.
+         * The light level of a_Data is ignored, the voxel keeps its light until the world relights it.
          */
-        virtual void QueueUpdate(const glm::ivec3& a_Position, const VoxelData& a_Data) = 0;
+        virtual void QueueUpdate(const glm::ivec3& a_Position, const VoxelData& a_Data, EditPriority a_Priority = EditPriority::SCRIPT) = 0;
 
         /*
          * Apply all pending changes to the chunks in the given ChunkStore.
-         * Updates to chunks that aren't loaded will cause the chunk to be loaded and altered.
-         * The chunk is then saved again afterward.
+         * Single updates to chunks that aren't loaded will cause the chunk to be loaded and altered.
+         * The chunk is then saved again afterward, like any other changed chunk.
          */
         virtual void ApplyPendingChanges(IChunkStore& a_ChunkStore) = 0;
+
+        /*
+         * Get the voxels changed by single updates in the last call to ApplyPendingChanges, one entry per voxel with its final value.
+         * Updates that did not change the voxel are left out, and so are voxels in chunks returned by GetEditedChunks.
+         */
+        virtual const std::vector<VoxelChange>& GetAppliedChanges() const = 0;
+
+        /*
+         * Get the coordinates of the chunks changed by region edits in the last call to ApplyPendingChanges.
+         * These can change too many voxels to list separately, so the chunks should be sent again as a whole.
+         */
+        virtual const std::vector<glm::ivec3>& GetEditedChunks() const = 0;
+
+        /*
+         * Queue an edit of a region that passes contiguous rows of voxels along the x axis to a_Function.
+         * a_Function is called as bool(const glm::ivec3& a_Position, VoxelData* a_Row, std::uint32_t a_Count), with the world coordinates of the first voxel in the row,
+         * and returns true when it changed any voxel. It is called directly from a loop, so it can be inlined and vectorized.
+         */
+        template<typename Function>
+        void QueueRowUpdates(const glm::ivec3& a_Start, const glm::ivec3& a_End, Function a_Function)
+        {
+            QueueChunkUpdates(a_Start, a_End, [a_Function](const glm::ivec3& a_ChunkOrigin, const glm::uvec3& a_Min, const glm::uvec3& a_Max, VoxelData* a_Voxels) mutable
+            {
+                const auto count = a_Max.x - a_Min.x + 1;
+                bool changed = false;
+                for(auto y = a_Min.y; y <= a_Max.y; ++y)
+                {
+                    for(auto z = a_Min.z; z <= a_Max.z; ++z)
+                    {
+                        auto* row = a_Voxels + GetVoxelIndex(glm::uvec3(a_Min.x, y, z));
+                        changed |= a_Function(a_ChunkOrigin + glm::ivec3(a_Min.x, y, z), row, count);
+                    }
+                }
+                return changed;
+            });
+        }
     };
 }
@@ -32,6 +32,10 @@ namespace voxl
         std::uint64_t seed = 0;                     //Seed used for world generation.
         std::string generator = "default";          //World generator name.
         std::uint32_t renderDistance = 10;          //The radius around players at which chunks should load.
+        std::uint32_t chunksPerSlab = 256;          //The amount of chunks the chunk memory pool grows by at once.
+        bool compressChunks = true;                 //When true, chunks are palette compressed and encoded with ChunkCodec when saved.
+        std::uint32_t chunkMemoryBudget = 512;      //The amount of memory in MB that loaded chunks may use before unused chunks are unloaded. 0 means no limit.
+        std::uint32_t climateSpacing = 0;           //Climate sample spacing of the default generator the world was created with. 0 until it is recorded.
     };
 
     class IWorld
@@ -46,8 +50,15 @@ namespace voxl
 
         /*
          * Save the world to file.
+         * When a_Async is true, changed chunks are copied on the calling thread and written on the server thread pool.
+         * The world keeps ticking in the meantime. Use IsSaving to see when the save has finished.
          */
-        virtual void Save() = 0;
+        virtual void Save(bool a_Async) = 0;
+
+        /*
+         * Returns true while an asynchronous save is still writing chunks.
+         */
+        virtual bool IsSaving() const = 0;
 
         /*
          * Unload the world from memory.
@@ -90,6 +101,12 @@ namespace voxl
          */
         virtual IVoxelEditor& GetVoxelEditor() = 0;
 
+        /*
+         * Get the y of the highest voxel that blocks or dims light at the given x and z, taking only loaded chunks into account.
+         * Returns INT32_MIN when none of the loaded chunks in that column contain such a voxel.
+         */
+        virtual std::int32_t GetSurfaceHeight(std::int32_t a_X, std::int32_t a_Z) const = 0;
+
         /*
          * Get the settings for this world.
          */
@@ -5,10 +5,12 @@
 namespace voxl
 {
     class IChunk;
+    class IPopulateContext;
 
     /*
      * Interface used for world generation.
      * The world generators should be stateless as they can be shared by multiple worlds.
+     * Chunks are generated on multiple threads in no particular order, so any randomness should come from ChunkRandom to keep worlds reproducible.
      */
     class IWorldGenerator
     {
@@ -23,8 +25,9 @@ namespace voxl
 
         /*
          * Populate an already generated chunk using a seed.
+         * All neighbouring chunks are generated, but they can not be accessed. Voxels placed outside the chunk go through a_Context.
          */
-        virtual void Populate(const std::uint64_t a_Seed, IChunk& a_Chunk) = 0;
+        virtual void Populate(const std::uint64_t a_Seed, IChunk& a_Chunk, IPopulateContext& a_Context) = 0;
 
         /*
          * Get the name of this world generator.
@@ -0,0 +1,495 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+#include "VoxelData.h"
+
+namespace voxl
+{
+    /*
+     * Version of the wire format. Clients send it when authenticating, and the server refuses clients with another version.
+     * Increase this whenever the fields of a packet or the way they are encoded change.
+     */
+    constexpr std::uint16_t PROTOCOL_VERSION = 2;
+
+    /*
+     * Bytes that are sent as they are, prefixed with their length.
+     * Views in received packets point into the network buffer, so they are only valid while the packet is being resolved.
+     */
+    struct ByteView
+    {
+        const std::uint8_t* data = nullptr;
+        std::uint32_t size = 0;
+    };
+
+    /*
+     * Writes values in little endian order into a buffer that is large enough for them, see GetPacketSize.
+     */
+    class PacketWriter
+    {
+    public:
+        PacketWriter(std::uint8_t* a_Buffer, std::size_t a_Size) : m_Position(a_Buffer), m_End(a_Buffer + a_Size)
+        {
+
+        }
+
+        /*
+         * Reserve the next a_Size bytes of the buffer and return them.
+         */
+        std::uint8_t* Take(std::size_t a_Size)
+        {
+            assert(static_cast<std::size_t>(m_End - m_Position) >= a_Size && "Packet written past its size.");
+            auto* position = m_Position;
+            m_Position += a_Size;
+            return position;
+        }
+
+        /*
+         * Get the amount of bytes that are not written yet.
+         */
+        std::size_t GetRemaining() const
+        {
+            return static_cast<std::size_t>(m_End - m_Position);
+        }
+
+    private:
+        std::uint8_t* m_Position;
+        std::uint8_t* m_End;
+    };
+
+    /*
+     * Reads values in little endian order from a received buffer without copying it.
+     * Reading past the end fails instead, after which every read fails and returns zeroes.
+     */
+    class PacketReader
+    {
+    public:
+        PacketReader(const std::uint8_t* a_Data, std::size_t a_Size) : m_Position(a_Data), m_End(a_Data + a_Size), m_Failed(false)
+        {
+
+        }
+
+        /*
+         * Get the next a_Size bytes of the buffer, or nullptr when fewer are left.
+         */
+        const std::uint8_t* Take(std::size_t a_Size)
+        {
+            if(m_Failed || static_cast<std::size_t>(m_End - m_Position) < a_Size)
+            {
+                m_Failed = true;
+                return nullptr;
+            }
+
+            const auto* position = m_Position;
+            m_Position += a_Size;
+            return position;
+        }
+
+        /*
+         * Get the amount of bytes that are not read yet.
+         */
+        std::size_t GetRemaining() const
+        {
+            return static_cast<std::size_t>(m_End - m_Position);
+        }
+
+        /*
+         * Returns true when a read went past the end of the buffer, or a value was invalid.
+         */
+        bool HasFailed() const
+        {
+            return m_Failed;
+        }
+
+        /*
+         * Mark the packet as invalid.
+         */
+        void Fail()
+        {
+            m_Failed = true;
+        }
+
+    private:
+        const std::uint8_t* m_Position;
+        const std::uint8_t* m_End;
+        bool m_Failed;
+    };
+
+    /*
+     * How a field type is sent. Specialized for every type that can be used in a packet.
+     * GetSize returns the exact amount of bytes Write uses for a value, and Read returns false when the value could not be read.
+     */
+    template<typename T, typename = void>
+    struct WireFormat;
+
+    /*
+     * The integer type an integer or enumeration is stored as.
+     */
+    template<typename T, bool = std::is_enum_v<T>>
+    struct WireInteger
+    {
+        using Type = std::make_unsigned_t<T>;
+    };
+
+    template<typename T>
+    struct WireInteger<T, true>
+    {
+        using Type = std::make_unsigned_t<std::underlying_type_t<T>>;
+    };
+
+    /*
+     * Integers and enumerations, stored with the size of their type.
+     */
+    template<typename T>
+    struct WireFormat<T, std::enable_if_t<(std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_enum_v<T>>>
+    {
+        using Bits = typename WireInteger<T>::Type;
+
+        static constexpr std::size_t GetSize(const T&)
+        {
+            return sizeof(Bits);
+        }
+
+        static void Write(PacketWriter& a_Writer, const T& a_Value)
+        {
+            auto* out = a_Writer.Take(sizeof(Bits));
+            const auto bits = static_cast<Bits>(a_Value);
+            for(std::size_t i = 0; i < sizeof(Bits); ++i)
+            {
+                out[i] = static_cast<std::uint8_t>(bits >> (i * 8));
+            }
+        }
+
+        static bool Read(PacketReader& a_Reader, T& a_Value)
+        {
+            const auto* in = a_Reader.Take(sizeof(Bits));
+            if(in == nullptr)
+            {
+                return false;
+            }
+
+            Bits bits = 0;
+            for(std::size_t i = 0; i < sizeof(Bits); ++i)
+            {
+                bits |= static_cast<Bits>(static_cast<Bits>(in[i]) << (i * 8));
+            }
+            a_Value = static_cast<T>(bits);
+            return true;
+        }
+    };
+
+    template<>
+    struct WireFormat<bool>
+    {
+        static constexpr std::size_t GetSize(const bool&)
+        {
+            return 1;
+        }
+
+        static void Write(PacketWriter& a_Writer, const bool& a_Value)
+        {
+            *a_Writer.Take(1) = a_Value ? 1 : 0;
+        }
+
+        static bool Read(PacketReader& a_Reader, bool& a_Value)
+        {
+            const auto* in = a_Reader.Take(1);
+            if(in == nullptr || *in > 1)
+            {
+                a_Reader.Fail();
+                return false;
+            }
+            a_Value = *in != 0;
+            return true;
+        }
+    };
+
+    /*
+     * Floats are sent as their IEEE 754 bits.
+     */
+    template<>
+    struct WireFormat<float>
+    {
+        static constexpr std::size_t GetSize(const float&)
+        {
+            return sizeof(std::uint32_t);
+        }
+
+        static void Write(PacketWriter& a_Writer, const float& a_Value)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &a_Value, sizeof(bits));
+            WireFormat<std::uint32_t>::Write(a_Writer, bits);
+        }
+
+        static bool Read(PacketReader& a_Reader, float& a_Value)
+        {
+            std::uint32_t bits;
+            if(!WireFormat<std::uint32_t>::Read(a_Reader, bits))
+            {
+                return false;
+            }
+            std::memcpy(&a_Value, &bits, sizeof(bits));
+            return true;
+        }
+    };
+
+    /*
+     * Fixed size arrays, sent element by element.
+     */
+    template<typename T, std::size_t N>
+    struct WireFormat<T[N], std::enable_if_t<!std::is_same_v<T, char>>>
+    {
+        static std::size_t GetSize(const T(&a_Value)[N])
+        {
+            std::size_t size = 0;
+            for(const auto& element : a_Value)
+            {
+                size += WireFormat<T>::GetSize(element);
+            }
+            return size;
+        }
+
+        static void Write(PacketWriter& a_Writer, const T(&a_Value)[N])
+        {
+            for(const auto& element : a_Value)
+            {
+                WireFormat<T>::Write(a_Writer, element);
+            }
+        }
+
+        static bool Read(PacketReader& a_Reader, T(&a_Value)[N])
+        {
+            for(auto& element : a_Value)
+            {
+                if(!WireFormat<T>::Read(a_Reader, element))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    /*
+     * Null terminated strings in char arrays. Only the characters before the terminator are sent, prefixed with their count.
+     */
+    template<std::size_t N>
+    struct WireFormat<char[N]>
+    {
+        static_assert(N <= 0xFFFF, "String fields are limited to 65535 characters.");
+
+        static std::size_t GetLength(const char(&a_Value)[N])
+        {
+            std::size_t length = 0;
+            while(length < N - 1 && a_Value[length] != '\0')
+            {
+                ++length;
+            }
+            return length;
+        }
+
+        static std::size_t GetSize(const char(&a_Value)[N])
+        {
+            return sizeof(std::uint16_t) + GetLength(a_Value);
+        }
+
+        static void Write(PacketWriter& a_Writer, const char(&a_Value)[N])
+        {
+            const auto length = GetLength(a_Value);
+            WireFormat<std::uint16_t>::Write(a_Writer, static_cast<std::uint16_t>(length));
+            std::memcpy(a_Writer.Take(length), a_Value, length);
+        }
+
+        static bool Read(PacketReader& a_Reader, char(&a_Value)[N])
+        {
+            std::uint16_t length;
+            if(!WireFormat<std::uint16_t>::Read(a_Reader, length))
+            {
+                return false;
+            }
+
+            //Room is needed for the terminator.
+            if(length >= N)
+            {
+                a_Reader.Fail();
+                return false;
+            }
+
+            const auto* in = a_Reader.Take(length);
+            if(in == nullptr)
+            {
+                return false;
+            }
+            std::memcpy(a_Value, in, length);
+            a_Value[length] = '\0';
+            return true;
+        }
+    };
+
+    template<>
+    struct WireFormat<VoxelData>
+    {
+        static constexpr std::size_t GetSize(const VoxelData&)
+        {
+            return sizeof(std::uint16_t) + 2;
+        }
+
+        static void Write(PacketWriter& a_Writer, const VoxelData& a_Value)
+        {
+            WireFormat<std::uint16_t>::Write(a_Writer, a_Value.id);
+            WireFormat<std::uint8_t>::Write(a_Writer, a_Value.metaData);
+            WireFormat<std::uint8_t>::Write(a_Writer, a_Value.lightLevel);
+        }
+
+        static bool Read(PacketReader& a_Reader, VoxelData& a_Value)
+        {
+            return WireFormat<std::uint16_t>::Read(a_Reader, a_Value.id) && WireFormat<std::uint8_t>::Read(a_Reader, a_Value.metaData) && WireFormat<std::uint8_t>::Read(a_Reader, a_Value.lightLevel);
+        }
+    };
+
+    template<>
+    struct WireFormat<ByteView>
+    {
+        static std::size_t GetSize(const ByteView& a_Value)
+        {
+            return sizeof(std::uint32_t) + a_Value.size;
+        }
+
+        static void Write(PacketWriter& a_Writer, const ByteView& a_Value)
+        {
+            WireFormat<std::uint32_t>::Write(a_Writer, a_Value.size);
+            if(a_Value.size != 0)
+            {
+                std::memcpy(a_Writer.Take(a_Value.size), a_Value.data, a_Value.size);
+            }
+        }
+
+        static bool Read(PacketReader& a_Reader, ByteView& a_Value)
+        {
+            if(!WireFormat<std::uint32_t>::Read(a_Reader, a_Value.size))
+            {
+                return false;
+            }
+            a_Value.data = a_Reader.Take(a_Value.size);
+            return a_Value.data != nullptr;
+        }
+    };
+
+    /*
+     * Network packets hold one or more messages, each prefixed with its length so that small messages can be sent together.
+     * Lengths below LONG_MESSAGE take two bytes. Longer messages store LONG_MESSAGE followed by a 32 bit length.
+     */
+    constexpr std::uint16_t LONG_MESSAGE = 0xFFFF;
+
+    /*
+     * Get the amount of bytes in front of a message of a_Size bytes.
+     */
+    constexpr std::size_t GetMessageHeaderSize(std::size_t a_Size)
+    {
+        return a_Size < LONG_MESSAGE ? sizeof(std::uint16_t) : sizeof(std::uint16_t) + sizeof(std::uint32_t);
+    }
+
+    /*
+     * Write the length in front of a message of a_Size bytes.
+     */
+    inline void WriteMessageHeader(PacketWriter& a_Writer, std::size_t a_Size)
+    {
+        if(a_Size < LONG_MESSAGE)
+        {
+            WireFormat<std::uint16_t>::Write(a_Writer, static_cast<std::uint16_t>(a_Size));
+            return;
+        }
+        WireFormat<std::uint16_t>::Write(a_Writer, LONG_MESSAGE);
+        WireFormat<std::uint32_t>::Write(a_Writer, static_cast<std::uint32_t>(a_Size));
+    }
+
+    /*
+     * Take the next message from a received packet, and point a_Message at it.
+     * Returns false when no messages are left, or the packet is malformed, in which case a_Packet has failed.
+     */
+    inline bool ReadMessage(PacketReader& a_Packet, PacketReader& a_Message)
+    {
+        if(a_Packet.GetRemaining() == 0 || a_Packet.HasFailed())
+        {
+            return false;
+        }
+
+        std::uint16_t shortSize;
+        std::uint32_t size = 0;
+        if(!WireFormat<std::uint16_t>::Read(a_Packet, shortSize))
+        {
+            return false;
+        }
+        size = shortSize;
+        if(shortSize == LONG_MESSAGE && !WireFormat<std::uint32_t>::Read(a_Packet, size))
+        {
+            return false;
+        }
+
+        const auto* data = a_Packet.Take(size);
+        if(data == nullptr)
+        {
+            return false;
+        }
+        a_Message = PacketReader(data, size);
+        return true;
+    }
+
+    /*
+     * The type of the member a pointer to member refers to.
+     */
+    template<typename T>
+    struct MemberType;
+
+    template<typename T, typename Class>
+    struct MemberType<T Class::*>
+    {
+        using Type = T;
+    };
+
+    template<typename T>
+    using FieldFormat = WireFormat<typename MemberType<T>::Type>;
+
+    /*
+     * Get the amount of bytes a packet takes on the wire: its type, followed by the fields listed by its GetFields function.
+     */
+    template<typename T>
+    std::size_t GetPacketSize(const T& a_Packet)
+    {
+        return 1 + std::apply([&a_Packet](auto... a_Fields)
+        {
+            return (std::size_t(0) + ... + FieldFormat<decltype(a_Fields)>::GetSize(a_Packet.*a_Fields));
+        }, T::GetFields());
+    }
+
+    /*
+     * Write a packet into a writer with room for GetPacketSize bytes.
+     */
+    template<typename T>
+    void WritePacket(PacketWriter& a_Writer, const T& a_Packet)
+    {
+        static_assert(static_cast<int>(T::TYPE) <= 0xFF, "Packet types are sent as a single byte.");
+        WireFormat<std::uint8_t>::Write(a_Writer, static_cast<std::uint8_t>(T::TYPE));
+        std::apply([&a_Writer, &a_Packet](auto... a_Fields)
+        {
+            (FieldFormat<decltype(a_Fields)>::Write(a_Writer, a_Packet.*a_Fields), ...);
+        }, T::GetFields());
+    }
+
+    /*
+     * Read the fields of a packet whose type was already read. Fails unless the fields use exactly the remaining bytes.
+     */
+    template<typename T>
+    bool ReadPacket(PacketReader& a_Reader, T& a_Packet)
+    {
+        const auto read = std::apply([&a_Reader, &a_Packet](auto... a_Fields)
+        {
+            return (true && ... && FieldFormat<decltype(a_Fields)>::Read(a_Reader, a_Packet.*a_Fields));
+        }, T::GetFields());
+        return read && !a_Reader.HasFailed() && a_Reader.GetRemaining() == 0;
+    }
+}
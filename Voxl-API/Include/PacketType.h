@@ -1,4 +1,7 @@
 #pragma once
+#include <tuple>
+
+#include "PacketSerialization.h"
 #include "VoxelData.h"
 
 #include "Utility.h"
@@ -26,12 +29,30 @@ namespace voxl
 
         CHAT_MESSAGE,       //A chat message
 
+        CHUNK_UNIFORM_DATA, //A chunk in which every voxel is the same.
+
         //UNKNOWN packet is always the last one to determine the amount of packets.
         UNKNOWN,
     };
 
+    /*
+     * Read the type of a received packet. Returns false for empty packets and unknown types.
+     */
+    inline bool ReadPacketType(PacketReader& a_Reader, PacketType& a_Type)
+    {
+        std::uint8_t type;
+        if(!WireFormat<std::uint8_t>::Read(a_Reader, type) || type >= static_cast<std::uint8_t>(PacketType::UNKNOWN))
+        {
+            return false;
+        }
+        a_Type = static_cast<PacketType>(type);
+        return true;
+    }
+
     /*
      * Base packet class used for polymorphic passing in functions.
+     * Packets are never sent as they are laid out in memory. Every packet lists the fields that are sent in a static GetFields function,
+     * which returns a tuple of pointers to members, see PacketSerialization.h.
      */
     struct IPacket
     {
@@ -46,6 +67,7 @@ namespace voxl
     template<PacketType T>
     struct PacketBase : public IPacket
     {
+        static constexpr PacketType TYPE = T;
         PacketBase() : IPacket(T) {}
     };
 
@@ -55,9 +77,15 @@ namespace voxl
      */
     struct Packet_Authenticate : public PacketBase<PacketType::AUTHENTICATE>
     {
-        char name[255];         //Username
+        std::uint16_t protocolVersion = PROTOCOL_VERSION;   //Wire format used by the client.
+        char name[255];                                     //Username
 
         //TODO encryption and keys for verification.
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_Authenticate::protocolVersion, &Packet_Authenticate::name);
+        }
     };
 
     /*
@@ -66,6 +94,11 @@ namespace voxl
     struct Packet_AuthenticationResponse : public PacketBase<PacketType::AUTHENTICATION_RESPONSE>
     {
         bool accepted;
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_AuthenticationResponse::accepted);
+        }
     };
 
     /*
@@ -81,6 +114,11 @@ namespace voxl
 
         //The message.
         char message[255];
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_ChatMessage::timeStamp, &Packet_ChatMessage::sender, &Packet_ChatMessage::message);
+        }
     };
 
     /*
@@ -104,6 +142,12 @@ namespace voxl
             unsigned uints[16];
             unsigned short uShorts[32];
         };
+
+        //The union is sent as its 32 bit view, which covers all of it.
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_Request::requested, &Packet_Request::uints);
+        }
     };
 
     /*
@@ -111,10 +155,13 @@ namespace voxl
      */
     struct Packet_VoxelInfo : public PacketBase<PacketType::VOXEL_INFO>
     {
-        /*
-         * The size of the 
-         */
-        size_t size;
+        //The contents of the file.
+        ByteView json;
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_VoxelInfo::json);
+        }
     };
 
     /*
@@ -124,6 +171,11 @@ namespace voxl
     {
         //The coordinates of the chunk.
         int coordinates[3];
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_ChunkSubscribe::coordinates);
+        }
     };
 
     /*
@@ -133,18 +185,45 @@ namespace voxl
     {
         //The coordinates of the chunk.
         int coordinates[3];
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_ChunkUnsubscribe::coordinates);
+        }
     };
 
     /*
-     * All voxel data from within a chunk.
+     * All voxel data from within a chunk, encoded with ChunkCodec.
      */
     struct Packet_ChunkVoxelData : public PacketBase<PacketType::CHUNK_VOXEL_DATA>
     {
         //The coordinates of the chunk.
         int coordinates[3];
 
-        //The actual chunk data.
-        VoxelData data[CHUNK_SIZE_CUBED];
+        //The encoded chunk data.
+        ByteView data;
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_ChunkVoxelData::coordinates, &Packet_ChunkVoxelData::data);
+        }
+    };
+
+    /*
+     * Sent instead of Packet_ChunkVoxelData when every voxel in a chunk has the same value.
+     */
+    struct Packet_ChunkUniformData : public PacketBase<PacketType::CHUNK_UNIFORM_DATA>
+    {
+        //The coordinates of the chunk.
+        int coordinates[3];
+
+        //The value of every voxel in the chunk.
+        VoxelData data;
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_ChunkUniformData::coordinates, &Packet_ChunkUniformData::data);
+        }
     };
 
     struct Packet_VoxelUpdate : public PacketBase<PacketType::VOXEL_UPDATE>
@@ -154,5 +233,10 @@ namespace voxl
 
         //The updated data.
         VoxelData data;
+
+        static constexpr auto GetFields()
+        {
+            return std::make_tuple(&Packet_VoxelUpdate::coordinatesBlock, &Packet_VoxelUpdate::data);
+        }
     };
 }
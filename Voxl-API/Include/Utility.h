@@ -35,6 +35,42 @@ namespace voxl
         return coords;
     }
 
+    /*
+     * Pack chunk coordinates into a single 64 bit key.
+     * Every axis is stored in 21 bits, which allows chunk coordinates in the range [-2^20, 2^20 - 1].
+     * The highest bit is never set, so ~0 can safely be used as an "empty" key.
+     */
+    constexpr inline std::uint64_t PackChunkCoordinates(const glm::ivec3& a_Coordinates)
+    {
+        constexpr std::uint64_t mask = (1ull << 21) - 1;
+        return ((static_cast<std::uint64_t>(a_Coordinates.x) & mask) << 42) | ((static_cast<std::uint64_t>(a_Coordinates.y) & mask) << 21) | (static_cast<std::uint64_t>(a_Coordinates.z) & mask);
+    }
+
+    /*
+     * Convert a key created with PackChunkCoordinates back into chunk coordinates.
+     */
+    constexpr inline glm::ivec3 UnpackChunkCoordinates(std::uint64_t a_Key)
+    {
+        //Shift each 21 bit value to the top of a 32 bit integer, then shift back to sign extend it.
+        constexpr std::uint64_t mask = (1ull << 21) - 1;
+        glm::ivec3 coords{};
+        coords.x = static_cast<std::int32_t>(static_cast<std::uint32_t>(((a_Key >> 42) & mask) << 11)) >> 11;
+        coords.y = static_cast<std::int32_t>(static_cast<std::uint32_t>(((a_Key >> 21) & mask) << 11)) >> 11;
+        coords.z = static_cast<std::int32_t>(static_cast<std::uint32_t>((a_Key & mask) << 11)) >> 11;
+        return coords;
+    }
+
+    /*
+     * Mix the bits of a 64 bit value with the SplitMix64 finalizer, which turns inputs that differ in a single bit into unrelated outputs.
+     * Used for hash tables keyed by packed chunk coordinates, and to derive random streams and seeds in world generation.
+     */
+    constexpr inline std::uint64_t Mix64(std::uint64_t a_Value)
+    {
+        a_Value = (a_Value ^ (a_Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        a_Value = (a_Value ^ (a_Value >> 27)) * 0x94D049BB133111EBull;
+        return a_Value ^ (a_Value >> 31);
+    }
+
     /*
      * Convert a chunk position to world coordinates.
      */
@@ -70,4 +106,16 @@ namespace voxl
         a_Block.y = static_cast<std::int32_t>(a_Coordinates.y) - (a_Chunk.y * static_cast<std::int32_t>(CHUNK_SIZE));
         a_Block.z = static_cast<std::int32_t>(a_Coordinates.z) - (a_Chunk.z * static_cast<std::int32_t>(CHUNK_SIZE));
     }
+
+    /*
+     * Retrieve the chunk coordinates and the voxel index within that chunk from integer voxel coordinates.
+     * Negative coordinates are rounded down, so voxel -1 lies in chunk -1.
+     */
+    constexpr inline void VoxelToChunk(const glm::ivec3& a_Voxel, glm::ivec3& a_Chunk, std::uint32_t& a_Index)
+    {
+        a_Chunk.x = (a_Voxel.x < 0 ? a_Voxel.x - (CHUNK_SIZE - 1) : a_Voxel.x) / CHUNK_SIZE;
+        a_Chunk.y = (a_Voxel.y < 0 ? a_Voxel.y - (CHUNK_SIZE - 1) : a_Voxel.y) / CHUNK_SIZE;
+        a_Chunk.z = (a_Voxel.z < 0 ? a_Voxel.z - (CHUNK_SIZE - 1) : a_Voxel.z) / CHUNK_SIZE;
+        a_Index = GetVoxelIndex(glm::uvec3(a_Voxel - a_Chunk * CHUNK_SIZE));
+    }
 }
\ No newline at end of file
@@ -10,6 +10,6 @@ namespace voxl
     {
         std::uint16_t id = 0;           //The ID of the block type at this voxel.
         std::uint8_t metaData = 0;      //The metadata of the voxel.
-        std::uint8_t lightLevel = 0;    //The light level at this voxel.
+        std::uint8_t lightLevel = 0;    //The light level at this voxel. Block light in the low four bits, sky light in the high four bits.
     };
 }
\ No newline at end of file
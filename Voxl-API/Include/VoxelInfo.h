@@ -16,6 +16,7 @@ namespace voxl
         std::uint8_t passThroughSpeed = 255;        //The speed at which one can pass through this block's substance if collision is disabled. 0 is the slowest and 255 is the fastest.
         std::uint8_t strength = 1;                  //The strength of this block which determines how fast it breaks when under stress.
         std::uint8_t emissiveLight = 0;             //The amount of light emitted by this block. When 0, no light is emitted and when 255 the most light is emitted.
+        std::uint8_t opacity = 15;                  //The amount of light levels lost when light enters this block, from 0 to 15. Light always loses at least one level per block, 15 blocks all light.
 
         //Graphics related settings used to display this voxel client-sided.
         struct
@@ -35,6 +35,22 @@ namespace voxl
             return info;
         }
 
+        /*
+         * Get the amount of voxel types this registry has space for. Valid IDs are below this number.
+         */
+        inline std::uint32_t GetMaximumEntries() const
+        {
+            return m_MaximumEntries;
+        }
+
+        /*
+         * Returns true when a voxel type was registered with the given ID.
+         */
+        inline bool IsRegistered(std::uint32_t a_Id) const
+        {
+            return a_Id < m_MaximumEntries && m_VoxelTypes[a_Id].id == a_Id;
+        }
+
         inline bool Register(const VoxelInfo& a_Information)
         {
             assert(a_Information.id < m_MaximumEntries && "Voxel registry isn't large enough to store an ID that high.");
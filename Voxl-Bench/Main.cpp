@@ -0,0 +1,568 @@
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ChunkCodec.h>
+#include <IChunk.h>
+#include <IWorld.h>
+#include <Utility.h>
+#include <VoxelRegistry.h>
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+#include <threads/ThreadPool.h>
+#include <time/Timer.h>
+
+#include "Chunk.h"
+#include "ChunkStore.h"
+#include "DefaultWorldGenerator.h"
+#include "HeightmapStore.h"
+#include "LightEngine.h"
+#include "Noise.h"
+#include "VoxelEditor.h"
+#include "VoxelJournal.h"
+
+namespace
+{
+    //Seed used for all generated terrain and random numbers.
+    constexpr std::uint64_t SEED = 42;
+
+    //Voxel types of the benchmark world. Air and stone are the ones the default generator places.
+    constexpr std::uint16_t AIR = voxl::DefaultWorldGenerator::AIR;
+    constexpr std::uint16_t STONE = voxl::DefaultWorldGenerator::STONE;
+    constexpr std::uint16_t TORCH = 2;
+    constexpr std::uint16_t WATER = 3;
+
+    //Journals of the voxel editor benchmark are written here.
+    const std::string JOURNAL_DIRECTORY = "bench/journal/";
+
+    //Results of work that is only done to be timed are added here, so that the compiler cannot remove it.
+    volatile std::uint64_t g_Sink = 0;
+
+    /*
+     * Get the chunks from a_Min up to but not including a_Max, in a fixed order.
+     */
+    std::vector<glm::ivec3> GetChunks(const glm::ivec3& a_Min, const glm::ivec3& a_Max)
+    {
+        std::vector<glm::ivec3> chunks;
+        for(int y = a_Min.y; y < a_Max.y; ++y)
+        {
+            for(int z = a_Min.z; z < a_Max.z; ++z)
+            {
+                for(int x = a_Min.x; x < a_Max.x; ++x)
+                {
+                    chunks.emplace_back(x, y, z);
+                }
+            }
+        }
+        return chunks;
+    }
+
+    /*
+     * Get the voxel types of the benchmark world. Created once, as the light engine and heightmaps copy what they need when they are created.
+     */
+    voxl::VoxelRegistry& GetRegistry()
+    {
+        static voxl::VoxelRegistry registry = []()
+        {
+            voxl::VoxelRegistry types(4);
+
+            voxl::VoxelInfo air;
+            air.name = "Air";
+            air.id = AIR;
+            air.collision = false;
+            air.opacity = 0;
+            types.Register(air);
+
+            voxl::VoxelInfo stone;
+            stone.name = "Stone";
+            stone.id = STONE;
+            types.Register(stone);
+
+            voxl::VoxelInfo torch;
+            torch.name = "Torch";
+            torch.id = TORCH;
+            torch.collision = false;
+            torch.emissiveLight = 255;
+            torch.opacity = 0;
+            types.Register(torch);
+
+            voxl::VoxelInfo water;
+            water.name = "Water";
+            water.id = WATER;
+            water.collision = false;
+            water.opacity = 2;
+            types.Register(water);
+
+            return types;
+        }();
+        return registry;
+    }
+
+    /*
+     * Generated and lit chunks with everything needed to edit and relight them, the way World ticks them.
+     */
+    class BenchWorld
+    {
+    public:
+        explicit BenchWorld(utilities::ThreadPool* a_ThreadPool) : m_ChunkStore(voxl::WorldSettings().chunksPerSlab), m_Heightmaps(GetRegistry()), m_LightEngine(GetRegistry(), a_ThreadPool), m_VoxelEditor(nullptr, a_ThreadPool)
+        {
+
+        }
+
+        /*
+         * Generate the terrain of the given chunks without population and light them all. Returns the milliseconds spent lighting.
+         */
+        float Generate(const std::vector<glm::ivec3>& a_Chunks)
+        {
+            voxl::DefaultWorldGenerator generator;
+            for(const auto& coordinates : a_Chunks)
+            {
+                auto chunk = std::make_unique<voxl::Chunk>(coordinates, m_ChunkStore);
+                generator.Generate(SEED, *chunk);
+                auto* loaded = m_ChunkStore.LoadChunk(std::move(chunk));
+                m_Heightmaps.AddChunk(m_ChunkStore, *loaded, m_HeightChanges);
+            }
+
+            utilities::Timer timer;
+            for(const auto& coordinates : a_Chunks)
+            {
+                m_LightEngine.QueueChunk(coordinates);
+            }
+            Relight();
+            return timer.measure(utilities::TimeUnit::MILLIS);
+        }
+
+        /*
+         * Apply the queued voxel updates and relight around them.
+         */
+        void Tick()
+        {
+            m_VoxelEditor.ApplyPendingChanges(m_ChunkStore);
+            for(const auto& change : m_VoxelEditor.GetAppliedChanges())
+            {
+                m_Heightmaps.UpdateVoxel(m_ChunkStore, change.position, m_HeightChanges);
+                m_LightEngine.QueueVoxel(change.position);
+            }
+            for(const auto& coordinates : m_VoxelEditor.GetEditedChunks())
+            {
+                auto* chunk = m_ChunkStore.GetChunk(coordinates);
+                if(chunk != nullptr)
+                {
+                    m_Heightmaps.UpdateChunk(m_ChunkStore, *chunk, m_HeightChanges);
+                }
+                m_LightEngine.QueueChunk(coordinates);
+            }
+            Relight();
+        }
+
+        /*
+         * Get the voxel at a position, or air outside the generated chunks.
+         */
+        voxl::VoxelData GetVoxel(const glm::ivec3& a_Position)
+        {
+            glm::ivec3 coordinates;
+            std::uint32_t index;
+            voxl::VoxelToChunk(a_Position, coordinates, index);
+            auto* chunk = m_ChunkStore.GetChunk(coordinates);
+            return chunk != nullptr ? chunk->GetVoxel(index) : voxl::VoxelData();
+        }
+
+        voxl::ChunkStore& GetChunkStore()
+        {
+            return m_ChunkStore;
+        }
+
+        voxl::VoxelEditor& GetVoxelEditor()
+        {
+            return m_VoxelEditor;
+        }
+
+    private:
+        void Relight()
+        {
+            for(const auto& change : m_HeightChanges)
+            {
+                m_LightEngine.QueueHeightChange(change);
+            }
+            m_HeightChanges.clear();
+            m_LightEngine.Update(m_ChunkStore, m_Heightmaps);
+        }
+
+    private:
+        voxl::ChunkStore m_ChunkStore;
+        voxl::HeightmapStore m_Heightmaps;
+        voxl::LightEngine m_LightEngine;
+        voxl::VoxelEditor m_VoxelEditor;
+        std::vector<voxl::HeightChange> m_HeightChanges;
+    };
+
+    void PrintHeader(const std::string& a_Name)
+    {
+        std::cout << std::endl << "== " << a_Name << std::endl;
+    }
+
+    /*
+     * Insert 20k chunks (50x8x50) into a ChunkStore, look them up in random order, iterate over them and erase half of them.
+     */
+    void BenchChunkStore()
+    {
+        static constexpr std::uint32_t LOOKUP_ROUNDS = 10;
+        static constexpr std::uint32_t ITERATE_ROUNDS = 100;
+
+        PrintHeader("ChunkStore");
+        auto chunks = GetChunks(glm::ivec3(0), glm::ivec3(50, 8, 50));
+        voxl::ChunkStore store(voxl::WorldSettings().chunksPerSlab);
+
+        utilities::Timer timer;
+        for(const auto& coordinates : chunks)
+        {
+            store.LoadChunk(std::make_unique<voxl::Chunk>(coordinates, store));
+        }
+        const auto insert = timer.measure(utilities::TimeUnit::MILLIS);
+
+        std::shuffle(chunks.begin(), chunks.end(), std::mt19937_64(SEED));
+        std::uint64_t found = 0;
+        timer.reset();
+        for(std::uint32_t round = 0; round < LOOKUP_ROUNDS; ++round)
+        {
+            for(const auto& coordinates : chunks)
+            {
+                found += store.GetChunk(coordinates) != nullptr;
+            }
+        }
+        const auto hit = timer.measure(utilities::TimeUnit::MICROS) * 1000.0f / (LOOKUP_ROUNDS * chunks.size());
+
+        timer.reset();
+        for(std::uint32_t round = 0; round < LOOKUP_ROUNDS; ++round)
+        {
+            for(const auto& coordinates : chunks)
+            {
+                found += store.GetChunk(coordinates + glm::ivec3(0, 100, 0)) != nullptr;
+            }
+        }
+        const auto miss = timer.measure(utilities::TimeUnit::MICROS) * 1000.0f / (LOOKUP_ROUNDS * chunks.size());
+
+        timer.reset();
+        for(std::uint32_t round = 0; round < ITERATE_ROUNDS; ++round)
+        {
+            for(auto& chunk : store)
+            {
+                found += static_cast<std::uint64_t>(chunk.GetChunkCoordinates().x);
+            }
+        }
+        const auto iterate = timer.measure(utilities::TimeUnit::MILLIS);
+
+        const auto erased = chunks.size() / 2;
+        timer.reset();
+        for(std::size_t i = 0; i < erased; ++i)
+        {
+            store.UnloadChunk(chunks[i]);
+        }
+        const auto erase = timer.measure(utilities::TimeUnit::MILLIS);
+        g_Sink = g_Sink + found;
+
+        std::cout << "insert " << chunks.size() << ": " << insert << " ms" << std::endl;
+        std::cout << "lookup hit: " << hit << " ns/op, lookup miss: " << miss << " ns/op" << std::endl;
+        std::cout << "iterate " << chunks.size() << " chunks x" << ITERATE_ROUNDS << ": " << iterate << " ms" << std::endl;
+        std::cout << "erase " << erased << ": " << erase << " ms" << std::endl;
+    }
+
+    /*
+     * Compare the size and the random read and write speed of flat and palette chunks, for chunks with more and more unique values.
+     */
+    void BenchPalette()
+    {
+        static constexpr std::uint32_t ACCESSES = 1 << 20;
+
+        PrintHeader("Palette vs flat");
+        std::cout << "unique values   flat B   palette B   read flat/palette ns   palette write ns" << std::endl;
+
+        voxl::ChunkStore store(1);
+        std::mt19937 random(static_cast<std::uint32_t>(SEED));
+        std::vector<std::uint32_t> indices(ACCESSES);
+        for(auto& index : indices)
+        {
+            index = random() % CHUNK_SIZE_CUBED;
+        }
+
+        for(const std::uint32_t unique : { 4u, 14u, 62u, 300u, 2000u })
+        {
+            std::vector<voxl::VoxelData> voxels(CHUNK_SIZE_CUBED);
+            for(auto& voxel : voxels)
+            {
+                voxel.id = static_cast<std::uint16_t>(random() % unique);
+            }
+
+            voxl::Chunk flat(glm::ivec3(0), store);
+            flat.SetVoxels(voxels.data());
+            voxl::Chunk palette(glm::ivec3(1, 0, 0), store);
+            palette.SetVoxels(voxels.data());
+            palette.SetStorage(voxl::ChunkStorage::PALETTE);
+
+            const auto read = [&indices](voxl::Chunk& a_Chunk)
+            {
+                std::uint64_t sum = 0;
+                utilities::Timer timer;
+                for(const auto index : indices)
+                {
+                    sum += a_Chunk.GetVoxel(index).id;
+                }
+                g_Sink = g_Sink + sum;
+                return timer.measure(utilities::TimeUnit::MICROS) * 1000.0f / ACCESSES;
+            };
+            const auto flatRead = read(flat);
+            const auto paletteRead = read(palette);
+
+            std::cout << std::setw(13) << unique << std::setw(9) << flat.GetMemoryUsage();
+            if(palette.GetStorage() != voxl::ChunkStorage::PALETTE)
+            {
+                std::cout << "   stays flat" << std::endl;
+                continue;
+            }
+            std::cout << std::setw(12) << palette.GetMemoryUsage() << std::setw(14) << flatRead << " / " << paletteRead;
+
+            //Write values that are already in the palette, so that the width of the indices stays the same.
+            utilities::Timer timer;
+            for(std::uint32_t i = 0; i < ACCESSES; ++i)
+            {
+                palette.SetVoxel(indices[i], voxels[indices[ACCESSES - 1 - i]]);
+            }
+            std::cout << std::setw(16) << timer.measure(utilities::TimeUnit::MICROS) * 1000.0f / ACCESSES << std::endl;
+        }
+    }
+
+    /*
+     * Encode and decode generated and lit terrain with ChunkCodec.
+     */
+    void BenchCodec(utilities::ThreadPool& a_ThreadPool)
+    {
+        PrintHeader("ChunkCodec");
+        BenchWorld world(&a_ThreadPool);
+        const auto chunks = GetChunks(glm::ivec3(0), glm::ivec3(8, 5, 8));
+        world.Generate(chunks);
+
+        std::vector<std::vector<voxl::VoxelData>> voxels;
+        for(const auto& coordinates : chunks)
+        {
+            voxels.emplace_back(CHUNK_SIZE_CUBED);
+            world.GetChunkStore().GetChunk(coordinates)->GetVoxels(voxels.back().data());
+        }
+
+        std::vector<std::vector<std::uint8_t>> encoded(chunks.size());
+        utilities::Timer timer;
+        for(std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            voxl::ChunkCodec::Encode(voxels[i].data(), encoded[i]);
+        }
+        const auto encode = timer.measure(utilities::TimeUnit::MICROS);
+
+        std::vector<voxl::VoxelData> decoded(CHUNK_SIZE_CUBED);
+        auto exact = true;
+        float decode = 0.0f;
+        std::size_t encodedBytes = 0;
+        for(std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            timer.reset();
+            exact = voxl::ChunkCodec::Decode(encoded[i].data(), encoded[i].size(), decoded.data()) && exact;
+            decode += timer.measure(utilities::TimeUnit::MICROS);
+            exact = exact && std::equal(decoded.begin(), decoded.end(), voxels[i].begin(), [](const voxl::VoxelData& a_Left, const voxl::VoxelData& a_Right)
+            {
+                return a_Left.id == a_Right.id && a_Left.metaData == a_Right.metaData && a_Left.lightLevel == a_Right.lightLevel;
+            });
+            encodedBytes += encoded[i].size();
+        }
+
+        const auto rawBytes = chunks.size() * CHUNK_SIZE_CUBED * sizeof(voxl::VoxelData);
+        std::cout << chunks.size() << " chunks, " << rawBytes / (1024.0f * 1024.0f) << " MB raw" << std::endl;
+        std::cout << "ratio " << static_cast<float>(rawBytes) / encodedBytes << " (" << encodedBytes / chunks.size() << " bytes/chunk avg)" << std::endl;
+        std::cout << "encode " << rawBytes / encode << " MB/s, decode " << rawBytes / decode << " MB/s" << std::endl;
+        std::cout << (exact ? "round trips exact" : "ROUND TRIP MISMATCH") << std::endl;
+    }
+
+    /*
+     * Generate 2048 chunks (16x8x16) with every noise kernel the CPU supports.
+     */
+    void BenchNoise()
+    {
+        PrintHeader("Noise kernels");
+        const auto chunks = GetChunks(glm::ivec3(0), glm::ivec3(16, 8, 16));
+        const std::pair<voxl::NoiseKernel, const char*> kernels[] = { { voxl::NoiseKernel::SCALAR, "scalar" }, { voxl::NoiseKernel::SSE41, "sse4.1" }, { voxl::NoiseKernel::AVX2, "avx2" } };
+
+        std::uint64_t firstHash = 0;
+        for(const auto& kernel : kernels)
+        {
+            if(kernel.first > voxl::FractalNoise::GetFastestKernel())
+            {
+                std::cout << kernel.second << " not supported" << std::endl;
+                continue;
+            }
+
+            voxl::DefaultGeneratorSettings settings;
+            settings.kernel = kernel.first;
+            voxl::DefaultWorldGenerator generator(settings);
+            voxl::ChunkStore store(voxl::WorldSettings().chunksPerSlab);
+            std::vector<std::unique_ptr<voxl::Chunk>> generated;
+
+            utilities::Timer timer;
+            for(const auto& coordinates : chunks)
+            {
+                generated.push_back(std::make_unique<voxl::Chunk>(coordinates, store));
+                generator.Generate(SEED, *generated.back());
+            }
+            const auto seconds = timer.measure(utilities::TimeUnit::SECONDS);
+
+            std::uint64_t hash = 0;
+            std::vector<voxl::VoxelData> voxels(CHUNK_SIZE_CUBED);
+            for(const auto& chunk : generated)
+            {
+                chunk->GetVoxels(voxels.data());
+                for(const auto& voxel : voxels)
+                {
+                    hash = voxl::Mix64(hash ^ voxel.id);
+                }
+            }
+            if(firstHash == 0)
+            {
+                firstHash = hash;
+            }
+
+            std::cout << kernel.second << " " << static_cast<std::uint32_t>(chunks.size() / seconds) << " chunks/s" << (hash == firstHash ? "" : ", VOXELS DIFFER FROM SCALAR") << std::endl;
+        }
+    }
+
+    /*
+     * Apply 1M voxel updates to 1024 loaded chunks (16x4x16), spread uniformly or in blasts of 10x10x10 voxels. Best of 3.
+     */
+    void BenchVoxelEditor(utilities::ThreadPool& a_ThreadPool)
+    {
+        static constexpr std::uint32_t EDITS = 1000000;
+        static constexpr std::uint32_t BLAST_SIZE = 10;
+        static constexpr std::uint32_t RUNS = 3;
+
+        PrintHeader("VoxelEditor");
+        const auto chunks = GetChunks(glm::ivec3(0), glm::ivec3(16, 4, 16));
+        const auto extent = glm::ivec3(16, 4, 16) * CHUNK_SIZE;
+
+        const auto run = [&](bool a_Journal, bool a_Clustered)
+        {
+            float best = 0.0f;
+            for(std::uint32_t i = 0; i < RUNS; ++i)
+            {
+                std::filesystem::remove_all(JOURNAL_DIRECTORY);
+                auto journal = a_Journal ? std::make_unique<voxl::VoxelJournal>(JOURNAL_DIRECTORY) : nullptr;
+                voxl::VoxelEditor editor(journal.get(), &a_ThreadPool);
+                voxl::ChunkStore store(voxl::WorldSettings().chunksPerSlab);
+                voxl::VoxelData stone;
+                stone.id = STONE;
+                for(const auto& coordinates : chunks)
+                {
+                    auto chunk = std::make_unique<voxl::Chunk>(coordinates, store);
+                    chunk->Fill(stone);
+                    store.LoadChunk(std::move(chunk));
+                }
+
+                std::mt19937 random(static_cast<std::uint32_t>(SEED + i));
+                voxl::VoxelData data;
+                utilities::Timer timer;
+                if(a_Clustered)
+                {
+                    for(std::uint32_t blast = 0; blast < EDITS / (BLAST_SIZE * BLAST_SIZE * BLAST_SIZE); ++blast)
+                    {
+                        const glm::ivec3 corner(random() % (extent.x - BLAST_SIZE), random() % (extent.y - BLAST_SIZE), random() % (extent.z - BLAST_SIZE));
+                        data.id = static_cast<std::uint16_t>(random() % 4);
+                        for(std::uint32_t index = 0; index < BLAST_SIZE * BLAST_SIZE * BLAST_SIZE; ++index)
+                        {
+                            editor.QueueUpdate(corner + glm::ivec3(index % BLAST_SIZE, index / (BLAST_SIZE * BLAST_SIZE), (index / BLAST_SIZE) % BLAST_SIZE), data);
+                        }
+                    }
+                }
+                else
+                {
+                    for(std::uint32_t edit = 0; edit < EDITS; ++edit)
+                    {
+                        data.id = static_cast<std::uint16_t>(random() % 4);
+                        editor.QueueUpdate(glm::ivec3(random() % extent.x, random() % extent.y, random() % extent.z), data);
+                    }
+                }
+                editor.ApplyPendingChanges(store);
+                const auto time = timer.measure(utilities::TimeUnit::MILLIS);
+                best = i == 0 ? time : std::min(best, time);
+            }
+            std::filesystem::remove_all(JOURNAL_DIRECTORY);
+            return best;
+        };
+
+        std::cout << "uniform random, no journal: " << run(false, false) << " ms" << std::endl;
+        std::cout << "uniform random, journal:    " << run(true, false) << " ms" << std::endl;
+        std::cout << "1000 clustered blasts:      " << run(false, true) << " ms" << std::endl;
+    }
+
+    /*
+     * Light 8x4x8 chunks of terrain from scratch, then place and remove torches and dig out stone with different amounts of edits per tick.
+     */
+    void BenchLight(utilities::ThreadPool& a_ThreadPool)
+    {
+        static constexpr std::uint32_t EDITS = 4096;
+
+        PrintHeader("LightEngine");
+        BenchWorld world(&a_ThreadPool);
+        const auto chunks = GetChunks(glm::ivec3(0), glm::ivec3(8, 4, 8));
+        const auto lighting = world.Generate(chunks);
+        std::cout << "full light: " << lighting / chunks.size() << " ms per chunk" << std::endl;
+
+        //Stay a light radius away from the border, so that every edit is relit through loaded chunks.
+        const auto margin = static_cast<int>(voxl::LightEngine::MAX_LIGHT);
+        const auto extent = glm::ivec3(8, 4, 8) * CHUNK_SIZE - 2 * margin;
+        std::mt19937 random(static_cast<std::uint32_t>(SEED));
+
+        for(const std::uint32_t perTick : { 1u, 16u, 256u })
+        {
+            utilities::Timer timer;
+            for(std::uint32_t tick = 0; tick < EDITS / perTick; ++tick)
+            {
+                for(std::uint32_t edit = 0; edit < perTick; ++edit)
+                {
+                    const auto position = glm::ivec3(margin) + glm::ivec3(random() % extent.x, random() % extent.y, random() % extent.z);
+                    auto data = world.GetVoxel(position);
+                    data.id = data.id == AIR ? TORCH : (data.id == TORCH ? WATER : AIR);
+                    world.GetVoxelEditor().QueueUpdate(position, data);
+                }
+                world.Tick();
+            }
+            std::cout << perTick << " edits per tick: " << static_cast<std::uint32_t>(EDITS / timer.measure(utilities::TimeUnit::SECONDS)) << " edits/s" << std::endl;
+        }
+    }
+}
+
+/*
+ * Benchmarks for the server's chunk storage, codec, generation, voxel editor and light engine.
+ * Arguments: [threads], the amount of threads in the pool used by the voxel editor and light engine. All cores by default.
+ */
+int main(int argc, char** argv)
+{
+    utilities::Logger logger("logs/Bench.txt");
+    logger.setConsoleLogging(true);
+    utilities::ServiceLocator<utilities::Logger>::setService(&logger);
+
+    auto threads = std::max(1u, std::thread::hardware_concurrency());
+    if(argc > 1)
+    {
+        threads = static_cast<std::uint32_t>(std::max(1, std::atoi(argv[1])));
+    }
+    utilities::ThreadPool threadPool(threads);
+    std::cout << "Running on " << threads << " threads." << std::endl;
+
+    BenchChunkStore();
+    BenchPalette();
+    BenchCodec(threadPool);
+    BenchNoise();
+    BenchVoxelEditor(threadPool);
+    BenchLight(threadPool);
+    return 0;
+}
@@ -110,9 +110,9 @@ namespace voxl
 
         //Wait for for voxel data packet to arrive and then process it.
         std::cout << "Attempting to retrieve voxel info..." << std::endl;
-        if (m_ServerConnection->WaitForPacket(PacketType::VOXEL_INFO, 6000, [&](IPacket* a_Packet)
+        if (m_ServerConnection->WaitForPacket(PacketType::VOXEL_INFO, 6000, [&](PacketReader& a_Reader)
         {
-            voxelInfoHandler->Resolve(*a_Packet, m_ServerConnection.get());
+            voxelInfoHandler->Resolve(a_Reader, m_ServerConnection.get());
         }))
         {
             std::cout << "Voxel info retrieved and parsed successfully!" << std::endl;
@@ -26,6 +26,53 @@ namespace voxl
         return nullptr;
     }
 
+    VoxelData ClientChunk::GetVoxel(std::uint32_t a_Index) const
+    {
+        //TODO
+        return VoxelData();
+    }
+
+    void ClientChunk::SetVoxel(std::uint32_t a_Index, const VoxelData& a_Data)
+    {
+        //TODO
+    }
+
+    void ClientChunk::GetVoxels(VoxelData* a_Destination) const
+    {
+        //TODO
+    }
+
+    void ClientChunk::SetVoxels(const VoxelData* a_Source)
+    {
+        //TODO
+    }
+
+    void ClientChunk::Fill(const VoxelData& a_Data)
+    {
+        //TODO
+    }
+
+    ChunkStorage ClientChunk::GetStorage() const
+    {
+        return ChunkStorage::FLAT;
+    }
+
+    void ClientChunk::SetStorage(ChunkStorage a_Storage)
+    {
+        //TODO
+    }
+
+    void ClientChunk::Compact()
+    {
+        //TODO
+    }
+
+    std::size_t ClientChunk::GetMemoryUsage() const
+    {
+        //TODO
+        return 0;
+    }
+
     void ClientChunk::Save(IWorld& a_World)
     {
     }
@@ -10,6 +10,15 @@ namespace voxl
         ChunkState GetState() override;
         VoxelData* GetVoxelData() override;
         VoxelData const* GetVoxelData() const override;
+        VoxelData GetVoxel(std::uint32_t a_Index) const override;
+        void SetVoxel(std::uint32_t a_Index, const VoxelData& a_Data) override;
+        void GetVoxels(VoxelData* a_Destination) const override;
+        void SetVoxels(const VoxelData* a_Source) override;
+        void Fill(const VoxelData& a_Data) override;
+        ChunkStorage GetStorage() const override;
+        void SetStorage(ChunkStorage a_Storage) override;
+        void Compact() override;
+        std::size_t GetMemoryUsage() const override;
         void Save(IWorld& a_World) override;
         void Unload(IWorld& a_World) override;
         bool IsDirty() override;
@@ -1,6 +1,7 @@
 #include "ClientPacketManager.h"
 
 
+#include <cassert>
 #include <iostream>
 #include <string>
 
@@ -16,12 +17,22 @@ namespace voxl
         m_Handlers.resize(static_cast<size_t>(PacketType::UNKNOWN) + 1);
     }
 
-    bool ClientPacketManager::Resolve(PacketType a_Type, IPacket& a_Data, IConnection* a_Sender)
+    bool ClientPacketManager::Resolve(PacketType a_Type, PacketReader& a_Reader, IConnection* a_Sender)
     {
+        assert(static_cast<size_t>(a_Type) < m_Handlers.size());
         auto* found = m_Handlers[static_cast<size_t>(a_Type)].get();
         if (found != nullptr)
         {
-            return found->Resolve(a_Data, a_Sender);
+            if (found->Resolve(a_Reader, a_Sender))
+            {
+                return true;
+            }
+
+            if (a_Reader.HasFailed() || a_Reader.GetRemaining() != 0)
+            {
+                std::cout << "Warning: Packet of type " << std::to_string((int)a_Type) << " is malformed." << std::endl;
+            }
+            return false;
         }
 
         std::cout << "Warning: Packet of type " << std::to_string((int)a_Type) << " is not handled." << std::endl;
@@ -1,9 +1,26 @@
 #include "PacketHandler_ChunkVoxelData.h"
 
+#include <vector>
+
+#include <ChunkCodec.h>
+
 namespace voxl
 {
     bool PacketHandler_ChunkVoxelData::OnResolve(Packet_ChunkVoxelData& a_Data, IConnection* a_Sender)
     {
-        //TODO Send the voxel data to the server. 
+        if(a_Data.data.size > ChunkCodec::MAX_ENCODED_SIZE)
+        {
+            return false;
+        }
+
+        //The encoded data is decoded straight from the received packet.
+        std::vector<VoxelData> voxels(CHUNK_SIZE_CUBED);
+        if(!ChunkCodec::Decode(a_Data.data.data, a_Data.data.size, voxels.data()))
+        {
+            return false;
+        }
+
+        //TODO Store the voxels in the client chunk at a_Data.coordinates.
+        return true;
     }
 }
@@ -32,8 +32,9 @@ namespace voxl
         {
             m_State = VoxelInfoReceiveState::PROCESSING;
 
-            char* start = reinterpret_cast<char*>(&a_Data) + sizeof(Packet_VoxelInfo);
-            char* end = start + a_Data.size;
+            //The file is read straight from the received packet.
+            const char* start = reinterpret_cast<const char*>(a_Data.json.data);
+            const char* end = start + a_Data.json.size;
 
             //Iterate over the array.
             nlohmann::json file = nlohmann::json::parse(start, end, nullptr, false, false);
@@ -8,7 +8,7 @@
 
 namespace voxl
 {
-    ServerConnection::ServerConnection(std::uint32_t a_TimeOutMillis) : m_Server(nullptr), m_Client(nullptr), m_State(ConnectionState::DISCONNECTED), m_StartTime(0), m_TimeOutMillis(a_TimeOutMillis)
+    ServerConnection::ServerConnection(std::uint32_t a_TimeOutMillis) : m_Server(nullptr), m_Packet(nullptr), m_Channel(0), m_Client(nullptr), m_State(ConnectionState::DISCONNECTED), m_StartTime(0), m_TimeOutMillis(a_TimeOutMillis)
     {
 
     }
@@ -83,14 +83,40 @@ namespace voxl
         return std::string(ip);
     }
 
-    void ServerConnection::SendPacket(const IPacket& a_Data, size_t a_Size)
+    std::uint8_t* ServerConnection::BeginPacket(std::size_t a_Size, std::uint8_t a_Channel)
     {
-        //Send the packet if connected still.
-        if (m_State == ConnectionState::CONNECTED)
+        assert(m_Packet == nullptr && "Packet started before the previous one was sent.");
+
+        //Only send the packet if connected still.
+        if (m_State != ConnectionState::CONNECTED)
         {
-            ENetPacket* packet = enet_packet_create(&a_Data, a_Size, ENET_PACKET_FLAG_RELIABLE);
-            enet_peer_send(m_Server, 0, packet);
+            return nullptr;
+        }
+
+        //The client sends little, so every packet is a frame with a single message.
+        const auto headerSize = GetMessageHeaderSize(a_Size);
+        m_Packet = enet_packet_create(nullptr, headerSize + a_Size, ENET_PACKET_FLAG_RELIABLE);
+        if (m_Packet == nullptr)
+        {
+            return nullptr;
         }
+
+        PacketWriter writer(m_Packet->data, headerSize);
+        WriteMessageHeader(writer, a_Size);
+        m_Channel = a_Channel;
+        return m_Packet->data + headerSize;
+    }
+
+    void ServerConnection::EndPacket()
+    {
+        assert(m_Packet != nullptr && "No packet was started.");
+
+        //ENet takes ownership of the packet, unless it could not be queued.
+        if (enet_peer_send(m_Server, m_Channel, m_Packet) != 0)
+        {
+            enet_packet_destroy(m_Packet);
+        }
+        m_Packet = nullptr;
     }
 
     bool ServerConnection::Connect(const std::string& a_Ip, std::uint32_t a_Port, const Packet_Authenticate& a_Authentication)
@@ -112,17 +138,27 @@ namespace voxl
         {
             m_StartTime = std::chrono::high_resolution_clock::now().time_since_epoch().count();
 
-            //Authenticate with the authentication packet.
-            ENetPacket* packet = enet_packet_create(&a_Authentication, sizeof(Packet_Authenticate), ENET_PACKET_FLAG_RELIABLE);
+            //Authenticate with the authentication packet. Written directly, as packets are only sent through BeginPacket once connected.
+            const auto size = GetPacketSize(a_Authentication);
+            const auto headerSize = GetMessageHeaderSize(size);
+            ENetPacket* packet = enet_packet_create(nullptr, headerSize + size, ENET_PACKET_FLAG_RELIABLE);
+            PacketWriter writer(packet->data, headerSize + size);
+            WriteMessageHeader(writer, size);
+            WritePacket(writer, a_Authentication);
             enet_peer_send(m_Server, 0, packet);
 
             //Wait for a response packet.
             ENetEvent authenticationResponse;
             if(enet_host_service(m_Client, &authenticationResponse, m_TimeOutMillis) && authenticationResponse.type == ENET_EVENT_TYPE_RECEIVE)
             {
-                //See if the authentication succeeded or not.
-                IPacket* responsePacket = reinterpret_cast<IPacket*>(authenticationResponse.packet->data);
-                if (responsePacket->type == PacketType::AUTHENTICATION_RESPONSE && static_cast<Packet_AuthenticationResponse*>(responsePacket)->accepted)
+                //See if the authentication succeeded or not. The response is the first message of the frame.
+                PacketReader frame(authenticationResponse.packet->data, authenticationResponse.packet->dataLength);
+                PacketReader reader(nullptr, 0);
+                PacketType type;
+                Packet_AuthenticationResponse response;
+                const bool accepted = ReadMessage(frame, reader) && ReadPacketType(reader, type) && type == PacketType::AUTHENTICATION_RESPONSE && ReadPacket(reader, response) && response.accepted;
+                enet_packet_destroy(authenticationResponse.packet);
+                if (accepted)
                 {
                     m_State = ConnectionState::CONNECTED;
                     return true;
@@ -172,9 +208,17 @@ namespace voxl
             break;
             case ENET_EVENT_TYPE_RECEIVE:
             {
-                IPacket* packet = reinterpret_cast<IPacket*>(event.packet->data);
-
-                m_PacketManager->Resolve(packet->type, *packet, this);
+                //The server sends all messages of a tick in one frame. They are read in place, and dropped when their type is not known.
+                PacketReader frame(event.packet->data, event.packet->dataLength);
+                PacketReader reader(nullptr, 0);
+                while (ReadMessage(frame, reader))
+                {
+                    PacketType type;
+                    if (ReadPacketType(reader, type))
+                    {
+                        m_PacketManager->Resolve(type, reader, this);
+                    }
+                }
                 enet_packet_destroy(event.packet);
             }
             break;
@@ -192,7 +236,7 @@ namespace voxl
     }
 
     bool ServerConnection::WaitForPacket(PacketType a_Type, std::uint32_t a_TimeOutMillis,
-        std::function<void(IPacket* a_Packet)> a_OnReceive)
+        std::function<void(PacketReader& a_Reader)> a_OnReceive)
     {
         //Process events from the server.
         ENetEvent event;
@@ -216,16 +260,33 @@ namespace voxl
             break;
             case ENET_EVENT_TYPE_RECEIVE:
             {
-                IPacket* packet = reinterpret_cast<IPacket*>(event.packet->data);
+                PacketReader frame(event.packet->data, event.packet->dataLength);
+                PacketReader reader(nullptr, 0);
+                bool received = false;
+                while (ReadMessage(frame, reader))
+                {
+                    PacketType type;
+                    if (!ReadPacketType(reader, type))
+                    {
+                        continue;
+                    }
 
-                //Packet of the right type received, run the executable and then free the memory.
-                if (packet->type == a_Type)
+                    //Packet of the right type received, run the executable. Messages sent after it in the same frame are handled as usual.
+                    if (!received && type == a_Type)
+                    {
+                        a_OnReceive(reader);
+                        received = true;
+                    }
+                    else if (received)
+                    {
+                        m_PacketManager->Resolve(type, reader, this);
+                    }
+                }
+                enet_packet_destroy(event.packet);
+                if (received)
                 {
-                    a_OnReceive(packet);
-                    enet_packet_destroy(event.packet);
                     return true;
                 }
-                enet_packet_destroy(event.packet);
             }
             break;
             //Server has disconnected so I guess this is it :(
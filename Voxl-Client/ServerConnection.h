@@ -27,13 +27,19 @@ namespace voxl
         std::uint64_t GetLastResponse() override;
         std::uint64_t GetConnectionStartTime() override;
         std::string GetIp() override;
-        void SendPacket(const IPacket& a_Data, size_t a_Size) override;
+        std::uint8_t* BeginPacket(std::size_t a_Size, std::uint8_t a_Channel) override;
+        void EndPacket() override;
         bool Connect(const std::string& a_Ip, std::uint32_t a_Port, const Packet_Authenticate& a_Authentication) override;
         IPacketManager& GetPacketManager() override;
         void ProcessPackets() override;
-        bool WaitForPacket(PacketType a_Type, std::uint32_t a_TimeOutMillis, std::function<void(IPacket* a_Packet)> a_OnReceive) override;
+        bool WaitForPacket(PacketType a_Type, std::uint32_t a_TimeOutMillis, std::function<void(PacketReader& a_Reader)> a_OnReceive) override;
     private:
         ENetPeer* m_Server;
+
+        //The packet between BeginPacket and EndPacket, and the channel it is sent on.
+        ENetPacket* m_Packet;
+        std::uint8_t m_Channel;
+
         ENetHost* m_Client;
         ConnectionState m_State;
         std::unique_ptr<IPacketManager> m_PacketManager;
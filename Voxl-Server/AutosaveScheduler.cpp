@@ -0,0 +1,159 @@
+#include "AutosaveScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+#include <time/Timer.h>
+
+#include "Chunk.h"
+#include "ChunkStore.h"
+#include "PendingWriteStore.h"
+#include "RegionStorage.h"
+#include "VoxelJournal.h"
+
+namespace voxl
+{
+    AutosaveScheduler::AutosaveScheduler(std::uint32_t a_CycleSeconds, std::uint32_t a_MaxChunksPerTick, std::uint32_t a_MaxMicrosPerTick, VoxelJournal* a_Journal) : m_CycleSeconds(a_CycleSeconds), m_MaxChunksPerTick(std::max(1u, a_MaxChunksPerTick)), m_MaxMicrosPerTick(a_MaxMicrosPerTick), m_CycleRemaining(a_CycleSeconds),
+        m_Journal(a_Journal), m_CheckpointSegment(0), m_Checkpointing(false), m_CheckpointFailed(false)
+    {
+
+    }
+
+    std::uint32_t AutosaveScheduler::Tick(double a_DeltaTime, ChunkStore& a_ChunkStore, RegionStorage& a_RegionStorage, PendingWriteStore& a_PendingWrites, bool a_Compress)
+    {
+        if(m_CycleSeconds <= 0.0)
+        {
+            return 0;
+        }
+
+        //Start a new cycle with everything that became dirty during the last one.
+        m_CycleRemaining -= a_DeltaTime;
+        if(m_CycleRemaining <= 0.0)
+        {
+            if(!m_Pending.empty())
+            {
+                utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Warning, "Autosave could not keep up, " + std::to_string(m_Pending.size()) + " chunks carried over to the next cycle. Consider raising the autosave budget.");
+            }
+
+            //Saved pending writes of regions without loaded chunks can be read back from disk when they are needed, so they do not stay in memory.
+            a_PendingWrites.Release(a_ChunkStore);
+
+            m_Dirty.clear();
+            a_ChunkStore.TakeDirtyChunks(m_Dirty);
+            m_Pending.insert(m_Pending.end(), m_Dirty.begin(), m_Dirty.end());
+            m_CycleRemaining += m_CycleSeconds;
+            if(m_CycleRemaining <= 0.0)
+            {
+                m_CycleRemaining = m_CycleSeconds;
+            }
+
+            //Every change logged so far is in a chunk that is either saved already or queued now. Chunks that failed before are queued again as well.
+            if(m_Journal != nullptr)
+            {
+                m_CheckpointSegment = m_Journal->Rotate();
+                m_Checkpointing = true;
+                m_CheckpointFailed = false;
+            }
+        }
+
+        if(m_Pending.empty())
+        {
+            FinishCheckpoint(a_RegionStorage);
+            return 0;
+        }
+
+        //A chunk saved without the writes it placed elsewhere would lose them in a crash. Only regions that changed are written.
+        if(!a_PendingWrites.Save(false))
+        {
+            return 0;
+        }
+
+        //Spread the remaining chunks evenly over the remaining ticks of the cycle.
+        const auto share = static_cast<double>(m_Pending.size()) * std::min(1.0, a_DeltaTime / m_CycleRemaining);
+        const auto target = std::min<std::size_t>(m_MaxChunksPerTick, std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(share))));
+
+        utilities::Timer timer;
+        std::uint32_t saved = 0;
+        while(saved < target && !m_Pending.empty())
+        {
+            if(m_MaxMicrosPerTick > 0 && saved > 0 && timer.measure(utilities::TimeUnit::MICROS) >= static_cast<float>(m_MaxMicrosPerTick))
+            {
+                break;
+            }
+
+            const auto key = m_Pending.front();
+            m_Pending.pop_front();
+
+            //Skip chunks that were unloaded or already saved by a full save.
+            auto* chunk = static_cast<Chunk*>(a_ChunkStore.GetChunk(UnpackChunkCoordinates(key)));
+            if(chunk == nullptr || !chunk->IsDirty())
+            {
+                continue;
+            }
+
+            if(a_Compress)
+            {
+                chunk->Compact();
+            }
+
+            m_Data.clear();
+            chunk->Serialize(m_Data);
+            if(a_Compress)
+            {
+                Chunk::CompactSerialized(m_Data);
+            }
+            chunk->SetDirty(false);
+            if(!a_RegionStorage.SaveChunkData(chunk->GetChunkCoordinates(), m_Data.data(), m_Data.size()))
+            {
+                //Try again next cycle.
+                chunk->SetDirty(true);
+                m_CheckpointFailed = true;
+            }
+            ++saved;
+        }
+
+        if(m_Pending.empty())
+        {
+            FinishCheckpoint(a_RegionStorage);
+        }
+        return saved;
+    }
+
+    void AutosaveScheduler::Clear()
+    {
+        m_Pending.clear();
+        m_CycleRemaining = m_CycleSeconds;
+        m_Checkpointing = false;
+    }
+
+    std::size_t AutosaveScheduler::GetPendingCount() const
+    {
+        return m_Pending.size();
+    }
+
+    void AutosaveScheduler::InvalidateCheckpoint()
+    {
+        m_CheckpointFailed = true;
+    }
+
+    void AutosaveScheduler::FinishCheckpoint(RegionStorage& a_RegionStorage)
+    {
+        if(!m_Checkpointing)
+        {
+            return;
+        }
+        m_Checkpointing = false;
+
+        //The failed chunks are dirty again and get queued by the next cycle, whose checkpoint removes these segments.
+        if(m_CheckpointFailed)
+        {
+            return;
+        }
+
+        //The changes in the old segments may only be dropped once the chunks holding them reached the disk. This happens once per cycle.
+        a_RegionStorage.Flush();
+        m_Journal->DeleteBefore(m_CheckpointSegment);
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace voxl
+{
+    class ChunkStore;
+    class PendingWriteStore;
+    class RegionStorage;
+    class VoxelJournal;
+
+    /*
+     * Saves dirty chunks a few at a time, spread out over a fixed cycle.
+     *
+     * At the start of each cycle, all chunks that became dirty since the previous cycle are queued.
+     * Every tick a share of the queue is saved, sized so that the queue is empty by the end of the cycle.
+     * The amount of chunks and the time spent per tick are capped so that saving never causes a tick spike.
+     * Chunks that could not be saved within the cycle carry over to the next one.
+     *
+     * Every cycle also checkpoints the journal: it is rotated when the cycle starts, and once every chunk that was dirty at that point is saved,
+     * the region files are flushed and the older segments are deleted. This keeps the journal from growing between full saves.
+     */
+    class AutosaveScheduler
+    {
+    public:
+        /*
+         * a_CycleSeconds is the time within which every dirty chunk should be saved. 0 disables autosaving.
+         * a_MaxChunksPerTick and a_MaxMicrosPerTick bound the work done in a single tick.
+         * a_Journal is checkpointed every cycle, it may be nullptr.
+         */
+        AutosaveScheduler(std::uint32_t a_CycleSeconds, std::uint32_t a_MaxChunksPerTick, std::uint32_t a_MaxMicrosPerTick, VoxelJournal* a_Journal = nullptr);
+
+        /*
+         * Save the share of dirty chunks that is due this tick.
+         * The writes that population placed in chunks that are not loaded are saved first, as the chunks that placed them may be among the saved ones.
+         * Returns the amount of chunks that were written.
+         */
+        std::uint32_t Tick(double a_DeltaTime, ChunkStore& a_ChunkStore, RegionStorage& a_RegionStorage, PendingWriteStore& a_PendingWrites, bool a_Compress);
+
+        /*
+         * Forget all queued chunks. Used when all chunks were just saved or unloaded.
+         */
+        void Clear();
+
+        /*
+         * Get the amount of chunks still queued for saving in the current cycle.
+         */
+        std::size_t GetPendingCount() const;
+
+        /*
+         * Keep the journal segments of the current cycle, because a chunk with changes in them failed to save outside of the scheduler.
+         */
+        void InvalidateCheckpoint();
+
+    private:
+        /*
+         * Delete the journal segments from before the cycle started, if every chunk of the cycle was saved.
+         */
+        void FinishCheckpoint(RegionStorage& a_RegionStorage);
+
+    private:
+        double m_CycleSeconds;
+        std::uint32_t m_MaxChunksPerTick;
+        std::uint32_t m_MaxMicrosPerTick;
+
+        //Time left in the current cycle.
+        double m_CycleRemaining;
+
+        //Packed coordinates of the chunks to save in this cycle.
+        std::deque<std::uint64_t> m_Pending;
+
+        //The segment the journal was rotated to when the cycle started, and whether a chunk of the cycle failed to save.
+        VoxelJournal* m_Journal;
+        std::uint32_t m_CheckpointSegment;
+        bool m_Checkpointing;
+        bool m_CheckpointFailed;
+
+        //Scratch buffers reused between ticks.
+        std::vector<std::uint64_t> m_Dirty;
+        std::vector<std::uint8_t> m_Data;
+    };
+}
@@ -1,10 +1,26 @@
 #include "Chunk.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+
+#include <ChunkCodec.h>
+#include <memory/SlabPool.h>
+
+#include "ChunkStore.h"
+#include "World.h"
+
 namespace voxl
 {
-    Chunk::Chunk(const glm::ivec3& a_Coordinates) : m_Coordinates(a_Coordinates)
+    Chunk::Chunk(const glm::ivec3& a_Coordinates, ChunkStore& a_Store) : m_Store(a_Store), m_DataPool(a_Store.GetDataPool()), m_Storage(ChunkStorage::UNIFORM), m_Data(nullptr), m_Uniform(), m_Coordinates(a_Coordinates), m_State(ChunkState::LOADING), m_Dirty(false), m_Subscribers(0), m_LastUsed(0), m_Saving(false), m_Resident(false), m_ReportedUsage(0)
     {
-        
+        assert(m_DataPool.getBlockSize() == sizeof(VoxelData) * CHUNK_SIZE_CUBED && "Chunk data pool has the wrong block size!");
+    }
+
+    Chunk::~Chunk()
+    {
+        FreeData();
     }
 
     glm::ivec3 Chunk::GetChunkCoordinates()
@@ -12,24 +28,221 @@ namespace voxl
         return m_Coordinates;
     }
 
+    void Chunk::Tick(float a_DeltaTime)
+    {
+
+    }
+
     ChunkState Chunk::GetState()
     {
         return m_State;
     }
 
+    void Chunk::SetState(ChunkState a_State)
+    {
+        m_State = a_State;
+    }
+
     VoxelData* Chunk::GetVoxelData()
     {
-        return m_Data;
+        return m_Storage == ChunkStorage::FLAT ? m_Data : nullptr;
     }
 
     VoxelData const* Chunk::GetVoxelData() const
     {
-        return m_Data;
+        return m_Storage == ChunkStorage::FLAT ? m_Data : nullptr;
     }
 
-    void Chunk::Save(IWorld& a_World)
+    VoxelData Chunk::GetVoxel(std::uint32_t a_Index) const
+    {
+        assert(a_Index < CHUNK_SIZE_CUBED);
+        if(m_Storage == ChunkStorage::FLAT)
+        {
+            return m_Data[a_Index];
+        }
+        if(m_Storage == ChunkStorage::UNIFORM)
+        {
+            return m_Uniform;
+        }
+        return m_Palette.Get(a_Index);
+    }
+
+    void Chunk::SetVoxel(std::uint32_t a_Index, const VoxelData& a_Data)
+    {
+        assert(a_Index < CHUNK_SIZE_CUBED);
+
+        //Writing the value that is already there neither needs more storage nor leaves anything to save.
+        const auto current = GetVoxel(a_Index);
+        if(std::memcmp(&current, &a_Data, sizeof(VoxelData)) == 0)
+        {
+            return;
+        }
+
+        if(m_Storage == ChunkStorage::UNIFORM)
+        {
+            ExpandUniform();
+        }
+        else if(m_Storage == ChunkStorage::PALETTE)
+        {
+            SetDirty(true);
+            if(m_Palette.Set(a_Index, a_Data))
+            {
+                UpdateMemoryUsage();
+                return;
+            }
+
+            //Too many unique values for the palette, continue as a flat array.
+            SetStorage(ChunkStorage::FLAT);
+        }
+        m_Data[a_Index] = a_Data;
+        SetDirty(true);
+        UpdateMemoryUsage();
+    }
+
+    void Chunk::GetVoxels(VoxelData* a_Destination) const
+    {
+        if(m_Storage == ChunkStorage::FLAT)
+        {
+            std::memcpy(a_Destination, m_Data, sizeof(VoxelData) * CHUNK_SIZE_CUBED);
+        }
+        else if(m_Storage == ChunkStorage::UNIFORM)
+        {
+            std::fill_n(a_Destination, CHUNK_SIZE_CUBED, m_Uniform);
+        }
+        else
+        {
+            m_Palette.Unpack(a_Destination);
+        }
+    }
+
+    void Chunk::SetVoxels(const VoxelData* a_Source)
+    {
+        SetDirty(true);
+        if(m_Storage == ChunkStorage::UNIFORM)
+        {
+            m_Storage = ChunkStorage::FLAT;
+            AllocateData();
+        }
+        else if(m_Storage == ChunkStorage::PALETTE)
+        {
+            if(m_Palette.Build(a_Source))
+            {
+                UpdateMemoryUsage();
+                return;
+            }
+
+            //Build failed and cleared the palette.
+            m_Storage = ChunkStorage::FLAT;
+            AllocateData();
+        }
+        std::memcpy(m_Data, a_Source, sizeof(VoxelData) * CHUNK_SIZE_CUBED);
+        UpdateMemoryUsage();
+    }
+
+    void Chunk::Fill(const VoxelData& a_Data)
+    {
+        StoreUniform(a_Data);
+        SetDirty(true);
+        UpdateMemoryUsage();
+    }
+
+    ChunkStorage Chunk::GetStorage() const
+    {
+        return m_Storage;
+    }
+
+    void Chunk::SetStorage(ChunkStorage a_Storage)
+    {
+        if(a_Storage == m_Storage)
+        {
+            return;
+        }
+
+        if(a_Storage == ChunkStorage::UNIFORM)
+        {
+            //Only possible when every voxel has the same value.
+            const auto first = GetVoxel(0);
+            for(std::uint32_t i = 1; i < CHUNK_SIZE_CUBED; ++i)
+            {
+                const auto voxel = GetVoxel(i);
+                if(std::memcmp(&voxel, &first, sizeof(VoxelData)) != 0)
+                {
+                    return;
+                }
+            }
+            StoreUniform(first);
+            UpdateMemoryUsage();
+            return;
+        }
+
+        if(m_Storage == ChunkStorage::UNIFORM)
+        {
+            ExpandUniform();
+        }
+
+        if(a_Storage == ChunkStorage::FLAT && m_Storage == ChunkStorage::PALETTE)
+        {
+            AllocateData();
+            m_Palette.Unpack(m_Data);
+            m_Palette.Clear();
+            m_Storage = ChunkStorage::FLAT;
+        }
+        else if(a_Storage == ChunkStorage::PALETTE && m_Storage == ChunkStorage::FLAT)
+        {
+            //Chunks with too many unique voxels stay flat.
+            if(m_Palette.Build(m_Data))
+            {
+                FreeData();
+                m_Storage = ChunkStorage::PALETTE;
+            }
+        }
+        UpdateMemoryUsage();
+    }
+
+    void Chunk::Compact()
     {
+        if(m_Storage == ChunkStorage::FLAT)
+        {
+            if(IsUniform(m_Data))
+            {
+                StoreUniform(m_Data[0]);
+                UpdateMemoryUsage();
+                return;
+            }
+            SetStorage(ChunkStorage::PALETTE);
+        }
+        else if(m_Storage == ChunkStorage::PALETTE)
+        {
+            //Rebuild to drop palette entries that are no longer used and narrow the indices.
+            std::vector<VoxelData> voxels(CHUNK_SIZE_CUBED);
+            m_Palette.Unpack(voxels.data());
+            m_Palette.Build(voxels.data());
 
+            //A single remaining value does not need a palette at all.
+            if(m_Palette.GetPaletteSize() == 1)
+            {
+                StoreUniform(voxels[0]);
+            }
+            UpdateMemoryUsage();
+        }
+    }
+
+    std::size_t Chunk::GetMemoryUsage() const
+    {
+        if(m_Storage == ChunkStorage::FLAT)
+        {
+            return sizeof(Chunk) + sizeof(VoxelData) * CHUNK_SIZE_CUBED;
+        }
+        if(m_Storage == ChunkStorage::UNIFORM)
+        {
+            return sizeof(Chunk);
+        }
+        return sizeof(Chunk) - sizeof(VoxelPalette) + m_Palette.GetMemoryUsage();
+    }
+
+    void Chunk::Save(IWorld& a_World)
+    {
+        static_cast<World&>(a_World).GetRegionStorage().SaveChunk(*this, a_World.GetSettings().compressChunks);
     }
 
     void Chunk::Unload(IWorld& a_World)
@@ -44,6 +257,293 @@ namespace voxl
 
     void Chunk::SetDirty(bool a_Dirty)
     {
-        m_Dirty = a_Dirty;
+        if(!a_Dirty)
+        {
+            m_Dirty = false;
+            return;
+        }
+
+        //Only report the first change, so the store sees every chunk at most once until it is saved.
+        if(!m_Dirty.exchange(true))
+        {
+            m_Store.MarkDirty(m_Coordinates);
+        }
+    }
+
+    void Chunk::Serialize(std::vector<std::uint8_t>& a_Output) const
+    {
+        //The storage type comes first so that uniform chunks only cost a few bytes.
+        a_Output.push_back(static_cast<std::uint8_t>(m_Storage));
+
+        if(m_Storage == ChunkStorage::UNIFORM)
+        {
+            const auto start = a_Output.size();
+            a_Output.resize(start + sizeof(VoxelData));
+            std::memcpy(a_Output.data() + start, &m_Uniform, sizeof(VoxelData));
+        }
+        else if(m_Storage == ChunkStorage::FLAT)
+        {
+            const auto start = a_Output.size();
+            a_Output.resize(start + sizeof(VoxelData) * CHUNK_SIZE_CUBED);
+            std::memcpy(a_Output.data() + start, m_Data, sizeof(VoxelData) * CHUNK_SIZE_CUBED);
+        }
+        else
+        {
+            m_Palette.Serialize(a_Output);
+        }
+    }
+
+    bool Chunk::Deserialize(const std::uint8_t* a_Data, std::size_t a_Size)
+    {
+        if(a_Size < 1)
+        {
+            return false;
+        }
+
+        const auto* data = a_Data + 1;
+        const auto* end = a_Data + a_Size;
+        const auto storage = static_cast<ChunkStorage>(a_Data[0]);
+
+        if(a_Data[0] == SERIALIZED_ENCODED)
+        {
+            std::vector<VoxelData> voxels(CHUNK_SIZE_CUBED);
+            if(!ChunkCodec::Decode(data, a_Size - 1, voxels.data()))
+            {
+                return false;
+            }
+
+            //Encoded chunks were compacted when saved, so keep them compact in memory too.
+            VoxelPalette palette;
+            if(IsUniform(voxels.data()))
+            {
+                StoreUniform(voxels[0]);
+            }
+            else if(palette.Build(voxels.data()))
+            {
+                FreeData();
+                m_Palette = std::move(palette);
+                m_Storage = ChunkStorage::PALETTE;
+            }
+            else
+            {
+                if(m_Storage != ChunkStorage::FLAT)
+                {
+                    m_Palette.Clear();
+                    m_Storage = ChunkStorage::FLAT;
+                    AllocateData();
+                }
+                std::memcpy(m_Data, voxels.data(), sizeof(VoxelData) * CHUNK_SIZE_CUBED);
+            }
+        }
+        else if(storage == ChunkStorage::UNIFORM)
+        {
+            if(end - data < static_cast<std::ptrdiff_t>(sizeof(VoxelData)))
+            {
+                return false;
+            }
+            VoxelData value;
+            std::memcpy(&value, data, sizeof(VoxelData));
+            StoreUniform(value);
+        }
+        else if(storage == ChunkStorage::FLAT)
+        {
+            if(end - data < static_cast<std::ptrdiff_t>(sizeof(VoxelData) * CHUNK_SIZE_CUBED))
+            {
+                return false;
+            }
+            //The old contents are overwritten entirely, so there is no need to expand them first.
+            if(m_Storage != ChunkStorage::FLAT)
+            {
+                m_Palette.Clear();
+                m_Storage = ChunkStorage::FLAT;
+                AllocateData();
+            }
+            std::memcpy(m_Data, data, sizeof(VoxelData) * CHUNK_SIZE_CUBED);
+        }
+        else if(storage == ChunkStorage::PALETTE)
+        {
+            //Read into a separate palette first so that the chunk is untouched when the data is invalid.
+            VoxelPalette palette;
+            if(!palette.Deserialize(data, end))
+            {
+                return false;
+            }
+            FreeData();
+            m_Palette = std::move(palette);
+            m_Storage = ChunkStorage::PALETTE;
+        }
+        else
+        {
+            return false;
+        }
+
+        UpdateMemoryUsage();
+        return true;
+    }
+
+    void Chunk::AddSubscriber()
+    {
+        ++m_Subscribers;
+    }
+
+    void Chunk::RemoveSubscriber()
+    {
+        assert(m_Subscribers > 0 && "Chunk has no subscribers to remove!");
+        --m_Subscribers;
+    }
+
+    std::uint32_t Chunk::GetSubscriberCount() const
+    {
+        return m_Subscribers;
+    }
+
+    void Chunk::SetLastUsed(std::uint64_t a_Clock)
+    {
+        m_LastUsed = a_Clock;
+    }
+
+    std::uint64_t Chunk::GetLastUsed() const
+    {
+        return m_LastUsed;
+    }
+
+    void Chunk::SetSaving(bool a_Saving)
+    {
+        m_Saving = a_Saving;
+    }
+
+    bool Chunk::IsSaving() const
+    {
+        return m_Saving;
+    }
+
+    void Chunk::SetResident(bool a_Resident)
+    {
+        if(a_Resident == m_Resident)
+        {
+            return;
+        }
+
+        m_Resident = a_Resident;
+        if(a_Resident)
+        {
+            m_ReportedUsage = GetMemoryUsage();
+            m_Store.AddMemoryUsage(m_ReportedUsage);
+        }
+        else
+        {
+            m_Store.RemoveMemoryUsage(m_ReportedUsage);
+            m_ReportedUsage = 0;
+        }
+    }
+
+    void Chunk::UpdateMemoryUsage()
+    {
+        if(!m_Resident)
+        {
+            return;
+        }
+
+        //Only storage changes and palette growth change the usage, so most calls report nothing.
+        const auto usage = GetMemoryUsage();
+        if(usage > m_ReportedUsage)
+        {
+            m_Store.AddMemoryUsage(usage - m_ReportedUsage);
+        }
+        else if(usage < m_ReportedUsage)
+        {
+            m_Store.RemoveMemoryUsage(m_ReportedUsage - usage);
+        }
+        m_ReportedUsage = usage;
+    }
+
+    void Chunk::CompactSerialized(std::vector<std::uint8_t>& a_Data)
+    {
+        if(a_Data.empty())
+        {
+            return;
+        }
+
+        //The voxels follow the storage byte, so they are not aligned.
+        std::vector<VoxelData> voxels(CHUNK_SIZE_CUBED);
+        if(a_Data.size() == 1 + sizeof(VoxelData) * CHUNK_SIZE_CUBED && a_Data[0] == static_cast<std::uint8_t>(ChunkStorage::FLAT))
+        {
+            std::memcpy(voxels.data(), a_Data.data() + 1, sizeof(VoxelData) * CHUNK_SIZE_CUBED);
+        }
+        else if(a_Data[0] == static_cast<std::uint8_t>(ChunkStorage::PALETTE))
+        {
+            VoxelPalette palette;
+            const auto* data = a_Data.data() + 1;
+            if(!palette.Deserialize(data, a_Data.data() + a_Data.size()))
+            {
+                return;
+            }
+            palette.Unpack(voxels.data());
+        }
+        else
+        {
+            return;
+        }
+
+        if(IsUniform(voxels.data()))
+        {
+            a_Data.resize(1 + sizeof(VoxelData));
+            a_Data[0] = static_cast<std::uint8_t>(ChunkStorage::UNIFORM);
+            std::memcpy(a_Data.data() + 1, voxels.data(), sizeof(VoxelData));
+            return;
+        }
+
+        std::vector<std::uint8_t> encoded;
+        encoded.push_back(SERIALIZED_ENCODED);
+        ChunkCodec::Encode(voxels.data(), encoded);
+        if(encoded.size() < a_Data.size())
+        {
+            a_Data.swap(encoded);
+        }
+    }
+
+    void Chunk::StoreUniform(const VoxelData& a_Data)
+    {
+        FreeData();
+        m_Palette.Clear();
+        m_Uniform = a_Data;
+        m_Storage = ChunkStorage::UNIFORM;
+    }
+
+    void Chunk::ExpandUniform()
+    {
+        assert(m_Storage == ChunkStorage::UNIFORM);
+
+        //Recycled buffers contain data of the previous chunk, so overwrite everything.
+        AllocateData();
+        std::uninitialized_fill_n(m_Data, CHUNK_SIZE_CUBED, m_Uniform);
+        m_Storage = ChunkStorage::FLAT;
+    }
+
+    bool Chunk::IsUniform(const VoxelData* a_Voxels)
+    {
+        for(std::uint32_t i = 1; i < CHUNK_SIZE_CUBED; ++i)
+        {
+            if(std::memcmp(&a_Voxels[i], &a_Voxels[0], sizeof(VoxelData)) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Chunk::AllocateData()
+    {
+        assert(m_Data == nullptr);
+        m_Data = static_cast<VoxelData*>(m_DataPool.allocate());
+    }
+
+    void Chunk::FreeData()
+    {
+        if(m_Data != nullptr)
+        {
+            m_DataPool.free(m_Data);
+            m_Data = nullptr;
+        }
     }
 }
@@ -1,28 +1,169 @@
 #pragma once
 
+#include <atomic>
+#include <vector>
+
 #include <IChunk.h>
 #include <VoxelData.h>
 
+#include "VoxelPalette.h"
+
+namespace utilities
+{
+    class SlabPool;
+}
+
 namespace voxl
 {
+    class ChunkStore;
+
     class Chunk : public IChunk
     {
     public:
-        explicit Chunk(const glm::ivec3& a_Coordinates);
+        /*
+         * Create a chunk at the given coordinates.
+         * The chunk starts out UNIFORM with default voxels, so no voxel memory is used until it is written to.
+         * Flat voxel data is taken from the store's pool and returned to it when no longer needed.
+         * The store is told when the chunk becomes dirty so that it can be saved.
+         */
+        Chunk(const glm::ivec3& a_Coordinates, ChunkStore& a_Store);
+        ~Chunk() override;
+
+        Chunk(const Chunk&) = delete;
+        Chunk& operator=(const Chunk&) = delete;
 
         glm::ivec3 GetChunkCoordinates() override;
+        void Tick(float a_DeltaTime) override;
         ChunkState GetState() override;
+        void SetState(ChunkState a_State) override;
         VoxelData* GetVoxelData() override;
         VoxelData const* GetVoxelData() const override;
+        VoxelData GetVoxel(std::uint32_t a_Index) const override;
+        void SetVoxel(std::uint32_t a_Index, const VoxelData& a_Data) override;
+        void GetVoxels(VoxelData* a_Destination) const override;
+        void SetVoxels(const VoxelData* a_Source) override;
+        void Fill(const VoxelData& a_Data) override;
+        ChunkStorage GetStorage() const override;
+        void SetStorage(ChunkStorage a_Storage) override;
+        void Compact() override;
+        std::size_t GetMemoryUsage() const override;
         void Save(IWorld& a_World) override;
         void Unload(IWorld& a_World) override;
         bool IsDirty() override;
         void SetDirty(bool a_Dirty) override;
 
+        /*
+         * Append the voxels of this chunk to a_Output in their current storage format.
+         * Uniform chunks only write a single voxel.
+         */
+        void Serialize(std::vector<std::uint8_t>& a_Output) const;
+
+        /*
+         * Replace the voxels of this chunk with data written by Serialize.
+         * Returns false if the data is truncated or invalid. The chunk is left unchanged in that case.
+         */
+        bool Deserialize(const std::uint8_t* a_Data, std::size_t a_Size);
+
+        /*
+         * Rewrite serialized FLAT or PALETTE chunk data as UNIFORM data, or encode it with ChunkCodec when that is smaller.
+         * This does not touch any chunk, so it can run on another thread than the one that serialized the data.
+         */
+        static void CompactSerialized(std::vector<std::uint8_t>& a_Data);
+
+        /*
+         * Register a client that wants updates about this chunk. Chunks with subscribers stay in memory.
+         */
+        void AddSubscriber();
+
+        /*
+         * Remove a client that no longer wants updates about this chunk.
+         */
+        void RemoveSubscriber();
+
+        /*
+         * Get the amount of clients subscribed to this chunk.
+         */
+        std::uint32_t GetSubscriberCount() const;
+
+        /*
+         * Set or get the residency clock value at which this chunk was last used.
+         */
+        void SetLastUsed(std::uint64_t a_Clock);
+        std::uint64_t GetLastUsed() const;
+
+        /*
+         * Set while a snapshot of the chunk is being written by an asynchronous save.
+         * The chunk is marked clean when the snapshot is taken, but the region file only has its data once the save finished, so it must not be unloaded before.
+         */
+        void SetSaving(bool a_Saving);
+        bool IsSaving() const;
+
+        /*
+         * Called by the store when the chunk is added to or removed from it.
+         * Resident chunks keep the memory usage total of the store up to date whenever their storage changes.
+         */
+        void SetResident(bool a_Resident);
+
+    public:
+        //Leading byte of serialized data encoded with ChunkCodec, written instead of the storage type.
+        static constexpr std::uint8_t SERIALIZED_ENCODED = 0x80;
+
     private:
-        VoxelData m_Data[CHUNK_SIZE_CUBED];
+        /*
+         * Switch to UNIFORM storage with the given value, freeing all other voxel memory.
+         * Unlike Fill this does not mark the chunk as dirty.
+         */
+        void StoreUniform(const VoxelData& a_Data);
+
+        /*
+         * Expand a UNIFORM chunk into a flat array filled with the uniform value.
+         */
+        void ExpandUniform();
+
+        /*
+         * Returns true if all CHUNK_SIZE_CUBED voxels in a_Voxels are equal.
+         */
+        static bool IsUniform(const VoxelData* a_Voxels);
+
+        /*
+         * Report the difference between the current memory usage and the last reported one to the store, if resident.
+         */
+        void UpdateMemoryUsage();
+
+        /*
+         * Take a flat voxel buffer from the pool. The contents are undefined.
+         */
+        void AllocateData();
+
+        /*
+         * Return the flat voxel buffer to the pool.
+         */
+        void FreeData();
+
+    private:
+        ChunkStore& m_Store;
+        utilities::SlabPool& m_DataPool;
+        ChunkStorage m_Storage;
+
+        //Flat voxel data, only valid when the storage is FLAT.
+        VoxelData* m_Data;
+
+        //Palette compressed voxel data, only valid when the storage is PALETTE.
+        VoxelPalette m_Palette;
+
+        //The value of every voxel, only valid when the storage is UNIFORM.
+        VoxelData m_Uniform;
+
         glm::ivec3 m_Coordinates;
         ChunkState m_State;
-        bool m_Dirty;
+        std::atomic<bool> m_Dirty;
+
+        std::uint32_t m_Subscribers;
+        std::uint64_t m_LastUsed;
+        bool m_Saving;
+
+        //Whether the chunk is in the store, and the memory usage that the store last heard of.
+        bool m_Resident;
+        std::size_t m_ReportedUsage;
     };
-}
\ No newline at end of file
+}
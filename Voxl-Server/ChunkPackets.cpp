@@ -0,0 +1,56 @@
+#include "ChunkPackets.h"
+
+#include <vector>
+
+#include <ChunkCodec.h>
+#include <IChunk.h>
+#include <IConnection.h>
+#include <IVoxelEditor.h>
+#include <PacketType.h>
+
+namespace voxl
+{
+    std::uint64_t SendChunk(IChunk& a_Chunk, IConnection& a_Connection)
+    {
+        const auto coordinates = a_Chunk.GetChunkCoordinates();
+
+        if(a_Chunk.GetStorage() == ChunkStorage::UNIFORM)
+        {
+            Packet_ChunkUniformData packet;
+            packet.coordinates[0] = coordinates.x;
+            packet.coordinates[1] = coordinates.y;
+            packet.coordinates[2] = coordinates.z;
+            packet.data = a_Chunk.GetVoxel(0);
+            a_Connection.SendTypedPacket(packet);
+            return GetPacketSize(packet);
+        }
+
+        //Reused between chunks, the encoded data is copied into the send buffer.
+        thread_local std::vector<VoxelData> voxels(CHUNK_SIZE_CUBED);
+        thread_local std::vector<std::uint8_t> encoded;
+        a_Chunk.GetVoxels(voxels.data());
+        encoded.clear();
+        ChunkCodec::Encode(voxels.data(), encoded);
+
+        Packet_ChunkVoxelData packet;
+        packet.coordinates[0] = coordinates.x;
+        packet.coordinates[1] = coordinates.y;
+        packet.coordinates[2] = coordinates.z;
+        packet.data = ByteView{ encoded.data(), static_cast<std::uint32_t>(encoded.size()) };
+        a_Connection.SendTypedPacket(packet);
+        return GetPacketSize(packet);
+    }
+
+    void SendVoxelUpdates(const std::vector<VoxelChange>& a_Changes, IConnection& a_Connection)
+    {
+        Packet_VoxelUpdate packet;
+        for(const auto& change : a_Changes)
+        {
+            packet.coordinatesBlock[0] = change.position.x;
+            packet.coordinatesBlock[1] = change.position.y;
+            packet.coordinatesBlock[2] = change.position.z;
+            packet.data = change.data;
+            a_Connection.SendTypedPacket(packet);
+        }
+    }
+}
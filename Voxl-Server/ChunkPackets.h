@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace voxl
+{
+    class IChunk;
+    class IConnection;
+    struct VoxelChange;
+
+    /*
+     * Send the voxels of a chunk to a connection.
+     * Uniform chunks are sent as a single voxel, all other chunks as the full voxel array.
+     * Returns the size of the packet in bytes.
+     */
+    std::uint64_t SendChunk(IChunk& a_Chunk, IConnection& a_Connection);
+
+    /*
+     * Send a Packet_VoxelUpdate for every change to a connection.
+     */
+    void SendVoxelUpdates(const std::vector<VoxelChange>& a_Changes, IConnection& a_Connection);
+}
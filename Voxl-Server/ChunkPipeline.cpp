@@ -0,0 +1,288 @@
+#include "ChunkPipeline.h"
+
+#include <chrono>
+#include <thread>
+
+#include <IWorldGenerator.h>
+#include <Utility.h>
+#include <threads/ThreadPool.h>
+
+#include "Chunk.h"
+#include "ChunkStore.h"
+#include "PendingWriteStore.h"
+#include "RegionStorage.h"
+
+namespace voxl
+{
+    ChunkPipeline::ChunkPipeline(utilities::ThreadPool& a_ThreadPool, ChunkStore& a_ChunkStore, RegionStorage& a_RegionStorage, PendingWriteStore& a_PendingWrites, std::shared_ptr<IWorldGenerator> a_Generator, std::uint64_t a_Seed) :
+        m_ThreadPool(a_ThreadPool), m_ChunkStore(a_ChunkStore), m_RegionStorage(a_RegionStorage), m_PendingWrites(a_PendingWrites), m_Generator(std::move(a_Generator)), m_Seed(a_Seed), m_GeneratedBytes(0), m_RunningJobs(0)
+    {
+
+    }
+
+    ChunkPipeline::~ChunkPipeline()
+    {
+        //Jobs refer to chunks owned by the entries.
+        WaitForJobs();
+    }
+
+    void ChunkPipeline::Request(const glm::ivec3& a_Coordinates)
+    {
+        if(m_ChunkStore.GetChunk(a_Coordinates) != nullptr)
+        {
+            return;
+        }
+
+        const auto key = PackChunkCoordinates(a_Coordinates);
+        const auto found = m_Entries.find(key);
+        if(found == m_Entries.end())
+        {
+            Start(key, a_Coordinates, true);
+            return;
+        }
+
+        //Generated for a neighbour before, now it is wanted itself.
+        auto& entry = found->second;
+        if(!entry.populate)
+        {
+            entry.populate = true;
+            if(entry.stage == Stage::GENERATED)
+            {
+                TryPopulate(key, entry);
+            }
+        }
+    }
+
+    std::uint32_t ChunkPipeline::Update(std::vector<glm::ivec3>* a_Generated)
+    {
+        std::vector<std::pair<std::uint64_t, Result>> completed;
+        {
+            std::lock_guard<std::mutex> lock(m_CompletedMutex);
+            completed.swap(m_Completed);
+        }
+
+        std::uint32_t published = 0;
+        for(const auto& result : completed)
+        {
+            auto& entry = m_Entries.at(result.first);
+            const auto coordinates = UnpackChunkCoordinates(result.first);
+
+            if(result.second == Result::GENERATED)
+            {
+                entry.stage = Stage::GENERATED;
+                m_GeneratedBytes += entry.chunk->GetMemoryUsage();
+                if(entry.populate)
+                {
+                    TryPopulate(result.first, entry);
+                }
+                WakeNeighbours(coordinates);
+                continue;
+            }
+
+            //Loaded and populated chunks are done. Chunks loaded from disk were populated before they were saved.
+            //Writes to neighbours are delivered even if this chunk is dropped below, as they are the same for every copy of it.
+            m_PendingWrites.Add(m_ChunkStore, entry.writes);
+            auto chunk = std::move(entry.chunk);
+            m_Entries.erase(result.first);
+
+            //The chunk may have been loaded directly in the meantime, and that copy could already be changed.
+            //Chunks waiting for this one to load use the copy in the store instead.
+            if(m_ChunkStore.GetChunk(coordinates) != nullptr)
+            {
+                if(result.second == Result::LOADED)
+                {
+                    WakeNeighbours(coordinates);
+                }
+                continue;
+            }
+
+            //Add what the population of neighbours placed in this chunk before it was populated or loaded.
+            m_PendingWrites.Apply(*chunk);
+
+            chunk->SetState(ChunkState::READY);
+            const auto dirty = chunk->IsDirty();
+            m_ChunkStore.LoadChunk(std::move(chunk));
+            ++published;
+
+            //The chunk became dirty before it was in the store, so the store may have dropped it from its dirty list.
+            if(dirty)
+            {
+                m_ChunkStore.MarkDirty(coordinates);
+            }
+
+            if(result.second == Result::LOADED)
+            {
+                WakeNeighbours(coordinates);
+            }
+            else if(a_Generated != nullptr)
+            {
+                a_Generated->push_back(coordinates);
+            }
+        }
+
+        return published;
+    }
+
+    void ChunkPipeline::WaitForJobs()
+    {
+        while(m_RunningJobs != 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::size_t ChunkPipeline::DiscardUnrequested(const std::function<bool(const glm::ivec3&)>& a_Predicate)
+    {
+        std::size_t discarded = 0;
+        for(auto itr = m_Entries.begin(); itr != m_Entries.end();)
+        {
+            //Chunks that are still loading have a job referring to them.
+            const auto& entry = itr->second;
+            if(!entry.populate && entry.stage == Stage::GENERATED && a_Predicate(UnpackChunkCoordinates(itr->first)))
+            {
+                m_GeneratedBytes -= entry.chunk->GetMemoryUsage();
+                itr = m_Entries.erase(itr);
+                ++discarded;
+            }
+            else
+            {
+                ++itr;
+            }
+        }
+        return discarded;
+    }
+
+    std::size_t ChunkPipeline::GetPendingCount() const
+    {
+        return m_Entries.size();
+    }
+
+    bool ChunkPipeline::IsRequested(const glm::ivec3& a_Coordinates) const
+    {
+        const auto found = m_Entries.find(PackChunkCoordinates(a_Coordinates));
+        return found != m_Entries.end() && found->second.populate;
+    }
+
+    std::uint64_t ChunkPipeline::GetMemoryUsage() const
+    {
+        return m_GeneratedBytes;
+    }
+
+    void ChunkPipeline::Start(std::uint64_t a_Key, const glm::ivec3& a_Coordinates, bool a_Populate)
+    {
+        auto& entry = m_Entries[a_Key];
+        entry.chunk = std::make_unique<Chunk>(a_Coordinates, m_ChunkStore);
+        entry.stage = Stage::LOADING;
+        entry.populate = a_Populate;
+
+        auto* chunk = entry.chunk.get();
+        ++m_RunningJobs;
+        m_ThreadPool.enqueue([this, a_Key, chunk]()
+        {
+            if(m_RegionStorage.LoadChunk(*chunk))
+            {
+                Complete(a_Key, Result::LOADED);
+                return;
+            }
+
+            chunk->SetState(ChunkState::GENERATING);
+            m_Generator->Generate(m_Seed, *chunk);
+
+            //New chunks have to be saved, even if the generator only filled them.
+            chunk->SetDirty(true);
+            Complete(a_Key, Result::GENERATED);
+        });
+    }
+
+    void ChunkPipeline::TryPopulate(std::uint64_t a_Key, Entry& a_Entry)
+    {
+        const auto coordinates = UnpackChunkCoordinates(a_Key);
+
+        //Chunks in the store are READY, so they count as generated.
+        bool complete = true;
+        for(int y = -1; y <= 1; ++y)
+        {
+            for(int z = -1; z <= 1; ++z)
+            {
+                for(int x = -1; x <= 1; ++x)
+                {
+                    if(x == 0 && y == 0 && z == 0)
+                    {
+                        continue;
+                    }
+
+                    const auto neighbour = coordinates + glm::ivec3(x, y, z);
+                    if(m_ChunkStore.GetChunk(neighbour) != nullptr)
+                    {
+                        continue;
+                    }
+
+                    const auto neighbourKey = PackChunkCoordinates(neighbour);
+                    const auto found = m_Entries.find(neighbourKey);
+                    if(found == m_Entries.end())
+                    {
+                        Start(neighbourKey, neighbour, false);
+                        complete = false;
+                    }
+                    else if(found->second.stage == Stage::LOADING)
+                    {
+                        complete = false;
+                    }
+                }
+            }
+        }
+
+        if(!complete)
+        {
+            m_Waiting.insert(a_Key);
+            return;
+        }
+
+        m_Waiting.erase(a_Key);
+        m_GeneratedBytes -= a_Entry.chunk->GetMemoryUsage();
+        a_Entry.stage = Stage::POPULATING;
+
+        auto* chunk = a_Entry.chunk.get();
+        auto* writes = &a_Entry.writes;
+        ++m_RunningJobs;
+        m_ThreadPool.enqueue([this, a_Key, chunk, writes]()
+        {
+            chunk->SetState(ChunkState::POPULATING);
+            PopulateContext context(*chunk, *writes);
+            m_Generator->Populate(m_Seed, *chunk, context);
+            Complete(a_Key, Result::POPULATED);
+        });
+    }
+
+    void ChunkPipeline::WakeNeighbours(const glm::ivec3& a_Coordinates)
+    {
+        if(m_Waiting.empty())
+        {
+            return;
+        }
+
+        for(int y = -1; y <= 1; ++y)
+        {
+            for(int z = -1; z <= 1; ++z)
+            {
+                for(int x = -1; x <= 1; ++x)
+                {
+                    const auto key = PackChunkCoordinates(a_Coordinates + glm::ivec3(x, y, z));
+                    if(m_Waiting.count(key) != 0)
+                    {
+                        TryPopulate(key, m_Entries.at(key));
+                    }
+                }
+            }
+        }
+    }
+
+    void ChunkPipeline::Complete(std::uint64_t a_Key, Result a_Result)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_CompletedMutex);
+            m_Completed.emplace_back(a_Key, a_Result);
+        }
+        --m_RunningJobs;
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "PopulateContext.h"
+
+namespace utilities
+{
+    class ThreadPool;
+}
+
+namespace voxl
+{
+    class Chunk;
+    class ChunkStore;
+    class IWorldGenerator;
+    class PendingWriteStore;
+    class RegionStorage;
+
+    /*
+     * Brings chunks from nothing to READY on the thread pool.
+     *
+     * A requested chunk is first loaded from its region file. Chunks that were never saved are generated instead, and then populated.
+     * Population only starts once all 26 neighbouring chunks are generated, so that it can rely on the terrain around the chunk.
+     * Neighbours that are missing are generated for that purpose, but not populated unless they are requested themselves.
+     * Voxels that population places in other chunks are handed to the PendingWriteStore, which also adds the ones waiting for a chunk before it is published.
+     *
+     * Chunks are owned by the pipeline until they are READY, so the tick thread never sees a chunk that is being worked on.
+     * Update is called from the tick thread at a point where the chunk store may change, and moves finished chunks into the store.
+     * All functions except the jobs themselves run on the tick thread.
+     */
+    class ChunkPipeline
+    {
+    public:
+        ChunkPipeline(utilities::ThreadPool& a_ThreadPool, ChunkStore& a_ChunkStore, RegionStorage& a_RegionStorage, PendingWriteStore& a_PendingWrites, std::shared_ptr<IWorldGenerator> a_Generator, std::uint64_t a_Seed);
+
+        /*
+         * Waits for all running jobs.
+         */
+        ~ChunkPipeline();
+
+        ChunkPipeline(const ChunkPipeline&) = delete;
+        ChunkPipeline& operator=(const ChunkPipeline&) = delete;
+
+        /*
+         * Start bringing the chunk at the given coordinates to READY.
+         * Does nothing if the chunk is already loaded or on its way.
+         */
+        void Request(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Handle finished jobs, start population of chunks whose neighbours are done, and add READY chunks to the chunk store.
+         * Returns the amount of chunks added to the store. The coordinates of added chunks that were generated instead of loaded are appended to a_Generated.
+         */
+        std::uint32_t Update(std::vector<glm::ivec3>* a_Generated = nullptr);
+
+        /*
+         * Block until no jobs are running. Chunks that are not READY stay in the pipeline.
+         */
+        void WaitForJobs();
+
+        /*
+         * Drop generated chunks that are only kept for their neighbours and match a_Predicate, because none of their neighbours will be requested anymore.
+         * Returns the amount of chunks dropped.
+         */
+        std::size_t DiscardUnrequested(const std::function<bool(const glm::ivec3&)>& a_Predicate);
+
+        /*
+         * Get the amount of chunks owned by the pipeline, including generated chunks that are only kept for their neighbours.
+         */
+        std::size_t GetPendingCount() const;
+
+        /*
+         * Returns true if the chunk was requested and is not in the chunk store yet.
+         */
+        bool IsRequested(const glm::ivec3& a_Coordinates) const;
+
+        /*
+         * Get the memory used by the generated chunks that wait for population or for their neighbours.
+         * Chunks that are being worked on by a job are not included.
+         */
+        std::uint64_t GetMemoryUsage() const;
+
+    private:
+        enum class Stage
+        {
+            LOADING,        //Being loaded from disk, or generated if not on disk.
+            GENERATED,      //Generated, not populated.
+            POPULATING,     //Being populated.
+            READY           //Waiting to be added to the chunk store.
+        };
+
+        struct Entry
+        {
+            std::unique_ptr<Chunk> chunk;
+            Stage stage;
+
+            //False for chunks that are only generated because a neighbour needs them.
+            bool populate;
+
+            //Voxels placed in other chunks during population.
+            std::vector<PendingWrite> writes;
+        };
+
+        //Results reported by the jobs.
+        enum class Result
+        {
+            LOADED,
+            GENERATED,
+            POPULATED
+        };
+
+        /*
+         * Create an entry for the chunk and start its load job.
+         */
+        void Start(std::uint64_t a_Key, const glm::ivec3& a_Coordinates, bool a_Populate);
+
+        /*
+         * Start populating the chunk if its neighbours are all generated. Missing neighbours are requested.
+         */
+        void TryPopulate(std::uint64_t a_Key, Entry& a_Entry);
+
+        /*
+         * Check the chunks waiting for population around the given chunk again.
+         */
+        void WakeNeighbours(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Called by jobs when they are done.
+         */
+        void Complete(std::uint64_t a_Key, Result a_Result);
+
+    private:
+        utilities::ThreadPool& m_ThreadPool;
+        ChunkStore& m_ChunkStore;
+        RegionStorage& m_RegionStorage;
+        PendingWriteStore& m_PendingWrites;
+        std::shared_ptr<IWorldGenerator> m_Generator;
+        std::uint64_t m_Seed;
+
+        //Chunks owned by the pipeline, by packed coordinates.
+        std::unordered_map<std::uint64_t, Entry> m_Entries;
+
+        //Generated chunks that should be populated, but have neighbours that are not generated yet.
+        std::unordered_set<std::uint64_t> m_Waiting;
+
+        //Memory used by the chunks in the GENERATED stage. Kept up to date when entries enter or leave that stage.
+        std::uint64_t m_GeneratedBytes;
+
+        //Jobs report here, the tick thread picks the results up in Update.
+        std::mutex m_CompletedMutex;
+        std::vector<std::pair<std::uint64_t, Result>> m_Completed;
+        std::atomic<std::uint32_t> m_RunningJobs;
+    };
+}
@@ -0,0 +1,180 @@
+#include "ChunkResidencyManager.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+
+#include "Chunk.h"
+#include "ChunkStore.h"
+#include "PendingWriteStore.h"
+#include "RegionStorage.h"
+
+namespace voxl
+{
+    ChunkResidencyManager::ChunkResidencyManager(std::uint64_t a_MemoryBudget, std::uint32_t a_RenderDistance, const std::function<IChunk*(const glm::ivec3&)>& a_Loader) : m_MemoryBudget(a_MemoryBudget), m_RenderDistance(static_cast<std::int32_t>(a_RenderDistance)), m_Loader(a_Loader), m_Clock(1), m_OverBudget(false)
+    {
+
+    }
+
+    IChunk* ChunkResidencyManager::GetChunk(ChunkStore& a_ChunkStore, const glm::ivec3& a_Coordinates)
+    {
+        auto* chunk = a_ChunkStore.GetChunk(a_Coordinates);
+        if(chunk != nullptr)
+        {
+            ++m_Stats.hits;
+        }
+        else
+        {
+            ++m_Stats.misses;
+            chunk = m_Loader(a_Coordinates);
+        }
+
+        if(chunk != nullptr)
+        {
+            Touch(static_cast<Chunk&>(*chunk));
+        }
+        return chunk;
+    }
+
+    void ChunkResidencyManager::Touch(Chunk& a_Chunk) const
+    {
+        a_Chunk.SetLastUsed(m_Clock);
+    }
+
+    std::uint32_t ChunkResidencyManager::Tick(ChunkStore& a_ChunkStore, RegionStorage& a_RegionStorage, PendingWriteStore& a_PendingWrites, const std::vector<glm::ivec3>& a_PlayerChunks, std::uint64_t a_PendingUsage, bool a_CanSave, bool a_Compress)
+    {
+        ++m_Clock;
+
+        m_Stats.residentChunks = a_ChunkStore.GetNumLoadedChunks();
+        m_Stats.residentBytes = a_ChunkStore.GetMemoryUsage();
+        m_Stats.pendingBytes = a_PendingUsage;
+        auto usage = m_Stats.residentBytes + a_PendingUsage;
+
+        if(m_MemoryBudget == 0 || usage <= m_MemoryBudget)
+        {
+            m_OverBudget = false;
+            return 0;
+        }
+
+        //Only chunks that nobody needs right now may go. Chunks that are still generating are left alone as well.
+        m_Candidates.clear();
+        for(auto& chunk : a_ChunkStore)
+        {
+            auto& serverChunk = static_cast<Chunk&>(chunk);
+            if(serverChunk.GetState() != ChunkState::READY || serverChunk.GetSubscriberCount() != 0 || serverChunk.IsSaving())
+            {
+                continue;
+            }
+            if((!a_CanSave && serverChunk.IsDirty()) || IsNearPlayer(serverChunk.GetChunkCoordinates(), a_PlayerChunks))
+            {
+                continue;
+            }
+            m_Candidates.push_back(&serverChunk);
+        }
+
+        std::sort(m_Candidates.begin(), m_Candidates.end(), [](const Chunk* a_Left, const Chunk* a_Right)
+        {
+            return a_Left->GetLastUsed() < a_Right->GetLastUsed();
+        });
+
+        //Unloading moves chunks around in the store, so only coordinates are kept from here on.
+        const auto target = static_cast<std::uint64_t>(static_cast<double>(m_MemoryBudget) * EVICT_TARGET);
+        std::vector<glm::ivec3> evict;
+        std::uint32_t saves = 0;
+        auto pendingSaved = false;
+        for(auto* chunk : m_Candidates)
+        {
+            if(usage <= target)
+            {
+                break;
+            }
+
+            //Compacting changes the memory usage, so take it first.
+            const auto chunkUsage = chunk->GetMemoryUsage();
+            if(chunk->IsDirty())
+            {
+                //Saving is slow, so past the limit only clean chunks are evicted. The rest follows in later ticks.
+                if(saves == MAX_SAVES_PER_TICK)
+                {
+                    continue;
+                }
+
+                //The writes the chunk placed in other chunks have to be on disk before the chunk is.
+                if(!pendingSaved)
+                {
+                    pendingSaved = true;
+                    if(!a_PendingWrites.Save(false))
+                    {
+                        a_CanSave = false;
+                    }
+                }
+                if(!a_CanSave)
+                {
+                    continue;
+                }
+
+                if(a_Compress)
+                {
+                    chunk->Compact();
+                }
+
+                m_Data.clear();
+                chunk->Serialize(m_Data);
+                if(a_Compress)
+                {
+                    Chunk::CompactSerialized(m_Data);
+                }
+
+                //Keep chunks that could not be saved, they would be lost otherwise.
+                if(!a_RegionStorage.SaveChunkData(chunk->GetChunkCoordinates(), m_Data.data(), m_Data.size()))
+                {
+                    continue;
+                }
+                chunk->SetDirty(false);
+                ++m_Stats.evictionSaves;
+                ++saves;
+            }
+
+            usage -= chunkUsage;
+            evict.push_back(chunk->GetChunkCoordinates());
+        }
+        m_Candidates.clear();
+
+        for(const auto& coordinates : evict)
+        {
+            a_ChunkStore.UnloadChunk(coordinates);
+        }
+        m_Stats.evictions += evict.size();
+        m_Stats.residentChunks = a_ChunkStore.GetNumLoadedChunks();
+        m_Stats.residentBytes = a_ChunkStore.GetMemoryUsage();
+        usage = m_Stats.residentBytes + a_PendingUsage;
+
+        //Only warn once until usage gets back within the budget. Running out of saves for this tick does not count.
+        if(usage > m_MemoryBudget && saves < MAX_SAVES_PER_TICK && !m_OverBudget)
+        {
+            m_OverBudget = true;
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Warning, "Chunks use " + std::to_string(usage / (1024 * 1024)) + " MB, which is over the budget of " + std::to_string(m_MemoryBudget / (1024 * 1024)) + " MB, but no more chunks can be evicted.");
+        }
+
+        return static_cast<std::uint32_t>(evict.size());
+    }
+
+    const ChunkResidencyStats& ChunkResidencyManager::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    bool ChunkResidencyManager::IsNearPlayer(const glm::ivec3& a_Coordinates, const std::vector<glm::ivec3>& a_PlayerChunks) const
+    {
+        for(const auto& player : a_PlayerChunks)
+        {
+            if(std::abs(a_Coordinates.x - player.x) <= m_RenderDistance && std::abs(a_Coordinates.y - player.y) <= m_RenderDistance && std::abs(a_Coordinates.z - player.z) <= m_RenderDistance)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
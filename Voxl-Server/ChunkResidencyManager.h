@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+namespace voxl
+{
+    class Chunk;
+    class ChunkStore;
+    class IChunk;
+    class PendingWriteStore;
+    class RegionStorage;
+
+    /*
+     * Counters describing how well the resident chunks match what is being used.
+     */
+    struct ChunkResidencyStats
+    {
+        std::uint64_t hits = 0;             //Chunk requests answered from memory.
+        std::uint64_t misses = 0;           //Chunk requests that had to go to disk.
+        std::uint64_t evictions = 0;        //Chunks removed from memory to stay within the budget.
+        std::uint64_t evictionSaves = 0;    //Evicted chunks that had to be saved first.
+        std::uint64_t residentChunks = 0;   //Chunks in memory after the last tick.
+        std::uint64_t residentBytes = 0;    //Memory used by those chunks after the last tick.
+        std::uint64_t pendingBytes = 0;     //Memory used by chunks outside the store that count against the budget.
+    };
+
+    /*
+     * Keeps the memory used by the chunks of a world within a budget.
+     *
+     * Chunks are marked as used whenever they are requested through GetChunk, and by the world through Touch when they are published, sent or edited.
+     * The memory usage is kept by the chunk store as chunks change, so a tick within the budget does not visit any chunk.
+     * When the resident chunks use more memory than the budget, the least recently used chunks are unloaded until usage drops below EVICT_TARGET of the budget.
+     * Chunks with subscribers, within the render distance of a player or with a snapshot still being saved are never evicted. Dirty chunks are saved before they are unloaded, at most MAX_SAVES_PER_TICK per tick, after the pending writes of population.
+     */
+    class ChunkResidencyManager
+    {
+    public:
+        //Eviction stops at this fraction of the budget, so that it does not run again on the very next tick.
+        static constexpr double EVICT_TARGET = 0.9;
+
+        //Amount of dirty chunks that may be saved for eviction in a single tick.
+        static constexpr std::uint32_t MAX_SAVES_PER_TICK = 32;
+
+    public:
+        /*
+         * a_MemoryBudget is the amount of bytes the chunks may use. 0 disables eviction.
+         * a_Loader loads a chunk that is not in memory, and returns nullptr when the chunk does not exist.
+         */
+        ChunkResidencyManager(std::uint64_t a_MemoryBudget, std::uint32_t a_RenderDistance, const std::function<IChunk*(const glm::ivec3&)>& a_Loader);
+
+        /*
+         * Get the chunk at the given coordinates, loading it if needed, and mark it as used.
+         */
+        IChunk* GetChunk(ChunkStore& a_ChunkStore, const glm::ivec3& a_Coordinates);
+
+        /*
+         * Mark a chunk as used without counting a request.
+         */
+        void Touch(Chunk& a_Chunk) const;
+
+        /*
+         * Evict chunks if the budget is exceeded.
+         * a_PlayerChunks are the chunk coordinates of every player in the world.
+         * a_PendingUsage is the memory used by chunks that are not in the store, such as generated neighbours waiting in the pipeline. They cannot be evicted here, but count against the budget.
+         * When a_CanSave is false, dirty chunks are kept, for example because a save with an older copy of them is still being written.
+         * Returns the amount of chunks evicted.
+         */
+        std::uint32_t Tick(ChunkStore& a_ChunkStore, RegionStorage& a_RegionStorage, PendingWriteStore& a_PendingWrites, const std::vector<glm::ivec3>& a_PlayerChunks, std::uint64_t a_PendingUsage, bool a_CanSave, bool a_Compress);
+
+        /*
+         * Get the counters collected so far.
+         */
+        const ChunkResidencyStats& GetStats() const;
+
+    private:
+        /*
+         * Returns true if the chunk is within the render distance of any of the given players.
+         */
+        bool IsNearPlayer(const glm::ivec3& a_Coordinates, const std::vector<glm::ivec3>& a_PlayerChunks) const;
+
+    private:
+        std::uint64_t m_MemoryBudget;
+        std::int32_t m_RenderDistance;
+        std::function<IChunk*(const glm::ivec3&)> m_Loader;
+
+        //Incremented every tick. Chunks remember the value at which they were last used.
+        std::uint64_t m_Clock;
+
+        ChunkResidencyStats m_Stats;
+
+        //True while the budget is exceeded and nothing more could be evicted.
+        bool m_OverBudget;
+
+        //Scratch buffers reused between ticks.
+        std::vector<Chunk*> m_Candidates;
+        std::vector<std::uint8_t> m_Data;
+    };
+}
@@ -0,0 +1,220 @@
+#include "ChunkSendQueue.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/geometric.hpp>
+
+#include <IChunkStore.h>
+#include <Utility.h>
+
+#include "ChunkPackets.h"
+
+namespace voxl
+{
+    namespace
+    {
+        //Weight of the newest tick in the averaged throughput.
+        constexpr double THROUGHPUT_SMOOTHING = 0.125;
+
+        //Factors the rate is changed with, at most once per round trip.
+        constexpr double RATE_INCREASE = 1.25;
+        constexpr double RATE_DECREASE = 0.85;
+
+        //Round trips worth of acknowledged bytes that may be waiting for an acknowledgement.
+        constexpr double MAX_BACKLOG = 2.0;
+
+        //How far the rate may be raised above the measured throughput.
+        constexpr double MAX_LEAD = 1.5;
+
+        //Directions closer than this are treated as the same, so turning slightly does not sort the queue again.
+        constexpr float FORWARD_TOLERANCE = 0.95f;
+    }
+
+    ChunkSendQueue::ChunkSendQueue(std::uint32_t a_MaxBytesPerTick) : m_MaxBytesPerTick(std::max(1u, a_MaxBytesPerTick)), m_Sequence(0), m_Sorted(true), m_FocusChunk(0), m_Forward(0.f, 0.f, 1.f), m_HasFocus(false),
+        m_Rate(INITIAL_RATE), m_Credit(0.0), m_Limited(false), m_Throughput(0.0), m_LastAcknowledged(0), m_LowestRoundTripTime(0), m_SinceAdjustment(0.0)
+    {
+
+    }
+
+    void ChunkSendQueue::Push(const glm::ivec3& a_Coordinates)
+    {
+        if(m_Queued.insert(PackChunkCoordinates(a_Coordinates)).second)
+        {
+            m_Queue.push_back(Entry{ a_Coordinates, m_Sequence++, 0, 0.f });
+            m_Sorted = false;
+        }
+    }
+
+    void ChunkSendQueue::Remove(const glm::ivec3& a_Coordinates)
+    {
+        if(m_Queued.erase(PackChunkCoordinates(a_Coordinates)) != 0)
+        {
+            m_Queue.erase(std::find_if(m_Queue.begin(), m_Queue.end(), [&a_Coordinates](const Entry& a_Entry)
+            {
+                return a_Entry.coordinates == a_Coordinates;
+            }));
+        }
+    }
+
+    void ChunkSendQueue::Clear()
+    {
+        m_Queue.clear();
+        m_Queued.clear();
+        m_Sorted = true;
+    }
+
+    void ChunkSendQueue::SetFocus(const glm::ivec3& a_Chunk, const glm::vec3& a_Forward)
+    {
+        const auto length = glm::length(a_Forward);
+        const auto forward = length > 0.f ? a_Forward / length : m_Forward;
+        if(!m_HasFocus || a_Chunk != m_FocusChunk || glm::dot(forward, m_Forward) < FORWARD_TOLERANCE)
+        {
+            m_FocusChunk = a_Chunk;
+            m_Forward = forward;
+            m_HasFocus = true;
+            m_Sorted = false;
+        }
+    }
+
+    void ChunkSendQueue::UpdateBudget(const LinkStats& a_Link, double a_DeltaTime)
+    {
+        if(a_DeltaTime <= 0.0)
+        {
+            return;
+        }
+
+        //Measure how fast the client acknowledges what it was sent.
+        const auto acknowledged = a_Link.acknowledgedBytes - m_LastAcknowledged;
+        m_LastAcknowledged = a_Link.acknowledgedBytes;
+        m_Throughput += (static_cast<double>(acknowledged) / a_DeltaTime - m_Throughput) * THROUGHPUT_SMOOTHING;
+
+        if(a_Link.roundTripTime != 0 && (m_LowestRoundTripTime == 0 || a_Link.roundTripTime < m_LowestRoundTripTime))
+        {
+            m_LowestRoundTripTime = a_Link.roundTripTime;
+        }
+
+        //A round trip time well above the lowest one means packets wait in a queue somewhere. So do more unacknowledged bytes than the client
+        //acknowledges in a few round trips. Nothing is known before the first acknowledgement.
+        const auto roundTrip = a_Link.roundTripTime / 1000.0;
+        const auto queueDelay = a_Link.roundTripTime > m_LowestRoundTripTime ? a_Link.roundTripTime - m_LowestRoundTripTime : 0;
+        const auto backlog = MAX_BACKLOG * std::max(m_Throughput, MIN_RATE) * (m_LowestRoundTripTime / 1000.0 + a_DeltaTime);
+        const bool congested = m_LowestRoundTripTime != 0 && (queueDelay > std::max(MAX_QUEUE_DELAY, m_LowestRoundTripTime / 2) || static_cast<double>(a_Link.unacknowledgedBytes) > backlog);
+
+        //The effect of a change only shows after a round trip.
+        m_SinceAdjustment += a_DeltaTime;
+        if(m_SinceAdjustment >= std::max(roundTrip, a_DeltaTime))
+        {
+            m_SinceAdjustment = 0.0;
+            if(congested)
+            {
+                //Fall back to below what the client acknowledges, so that the backlog drains. At most halve the rate at once.
+                m_Rate = std::max(std::min(m_Rate, m_Throughput), m_Rate * 0.5) * RATE_DECREASE;
+            }
+            else if(m_Limited)
+            {
+                //Stay within reach of what the client acknowledges, so that the rate does not run away before the delay shows.
+                m_Rate = std::min(m_Rate * RATE_INCREASE, std::max(m_Throughput, INITIAL_RATE) * MAX_LEAD);
+            }
+        }
+
+        auto maxRate = m_MaxBytesPerTick / a_DeltaTime;
+        if(a_Link.bandwidth != 0)
+        {
+            maxRate = std::min(maxRate, static_cast<double>(a_Link.bandwidth));
+        }
+        m_Rate = std::min(std::max(m_Rate, MIN_RATE), maxRate);
+
+        //Unused budget is not saved up, so an idle client can not send a burst later.
+        m_Credit = std::min(m_Credit, 0.0) + m_Rate * a_DeltaTime;
+    }
+
+    std::uint64_t ChunkSendQueue::Send(IChunkStore& a_ChunkStore, IConnection& a_Connection, std::uint64_t a_Limit, std::vector<glm::ivec3>* a_Sent)
+    {
+        m_Limited = false;
+        if(m_Queue.empty() || m_Credit <= 0.0)
+        {
+            m_Limited = !m_Queue.empty();
+            return 0;
+        }
+
+        if(!m_Sorted)
+        {
+            Sort();
+        }
+
+        const auto budget = std::min(m_Credit, static_cast<double>(a_Limit));
+        std::uint64_t sent = 0;
+
+        //Chunks that are not loaded yet keep their place in the queue.
+        auto next = m_Queue.size();
+        auto kept = m_Queue.size();
+        while(next > 0 && static_cast<double>(sent) < budget)
+        {
+            const auto& entry = m_Queue[--next];
+            auto* chunk = a_ChunkStore.GetChunk(entry.coordinates);
+            if(chunk == nullptr)
+            {
+                m_Queue[--kept] = entry;
+                continue;
+            }
+
+            m_Queued.erase(PackChunkCoordinates(entry.coordinates));
+            sent += SendChunk(*chunk, a_Connection);
+            if(a_Sent != nullptr)
+            {
+                a_Sent->push_back(entry.coordinates);
+            }
+        }
+        m_Queue.erase(m_Queue.begin() + next, m_Queue.begin() + kept);
+
+        m_Credit -= static_cast<double>(sent);
+        m_Limited = !m_Queue.empty() && m_Credit <= 0.0;
+        return sent;
+    }
+
+    std::size_t ChunkSendQueue::GetPendingCount() const
+    {
+        return m_Queue.size();
+    }
+
+    double ChunkSendQueue::GetRate() const
+    {
+        return m_Rate;
+    }
+
+    void ChunkSendQueue::Sort()
+    {
+        if(!m_HasFocus)
+        {
+            std::sort(m_Queue.begin(), m_Queue.end(), [](const Entry& a_Left, const Entry& a_Right)
+            {
+                return a_Left.sequence > a_Right.sequence;
+            });
+            m_Sorted = true;
+            return;
+        }
+
+        for(auto& entry : m_Queue)
+        {
+            const auto offset = entry.coordinates - m_FocusChunk;
+            entry.distance = static_cast<std::int64_t>(offset.x) * offset.x + static_cast<std::int64_t>(offset.y) * offset.y + static_cast<std::int64_t>(offset.z) * offset.z;
+            entry.facing = entry.distance == 0 ? 1.f : glm::dot(glm::vec3(offset), m_Forward) / std::sqrt(static_cast<float>(entry.distance));
+        }
+
+        //Furthest first, so that the nearest chunk is at the back. Chunks at the same distance are sent in the direction the client looks first.
+        std::sort(m_Queue.begin(), m_Queue.end(), [](const Entry& a_Left, const Entry& a_Right)
+        {
+            if(a_Left.distance != a_Right.distance)
+            {
+                return a_Left.distance > a_Right.distance;
+            }
+            if(a_Left.facing != a_Right.facing)
+            {
+                return a_Left.facing < a_Right.facing;
+            }
+            return a_Left.sequence > a_Right.sequence;
+        });
+        m_Sorted = true;
+    }
+}
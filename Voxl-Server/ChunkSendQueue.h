@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+namespace voxl
+{
+    class IChunkStore;
+    class IConnection;
+
+    /*
+     * What is known about the connection to a client, used to pace the chunks sent to it.
+     */
+    struct LinkStats
+    {
+        //Mean round trip time of reliable packets in milliseconds, as measured by ENet.
+        std::uint32_t roundTripTime = 0;
+
+        //Bytes sent to the client that were not acknowledged yet, and the total amount that was acknowledged.
+        std::uint64_t unacknowledgedBytes = 0;
+        std::uint64_t acknowledgedBytes = 0;
+
+        //Downstream bandwidth the client reported in bytes per second, 0 when unknown.
+        std::uint32_t bandwidth = 0;
+    };
+
+    /*
+     * The chunks that still have to be sent to a single client, sent a few per tick.
+     *
+     * Chunks are sent nearest to the client's focus first. Chunks at the same distance are sent in the direction the client looks first.
+     * The amount of bytes sent per tick follows the rate at which the client acknowledges them. The rate grows while the round trip time
+     * stays near the lowest seen, and falls back to the measured throughput once packets start queueing up, so that a single client
+     * never fills the server's uplink. Chunks are read when they are sent, so they always hold their latest voxels.
+     */
+    class ChunkSendQueue
+    {
+    public:
+        //Bounds and starting value of the send rate in bytes per second.
+        static constexpr double MIN_RATE = 16.0 * 1024.0;
+        static constexpr double INITIAL_RATE = 128.0 * 1024.0;
+
+        //Round trip time in milliseconds above the lowest one seen that is accepted before the link counts as congested.
+        static constexpr std::uint32_t MAX_QUEUE_DELAY = 25;
+
+    public:
+        /*
+         * a_MaxBytesPerTick is the most that is sent to this client in a single tick.
+         */
+        explicit ChunkSendQueue(std::uint32_t a_MaxBytesPerTick);
+
+        /*
+         * Queue a chunk to be sent. Chunks that are queued already keep their place.
+         */
+        void Push(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Stop sending a chunk that was queued.
+         */
+        void Remove(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Forget all queued chunks.
+         */
+        void Clear();
+
+        /*
+         * Set the chunk the client is in and the direction it looks in, which decide the order of the queue.
+         */
+        void SetFocus(const glm::ivec3& a_Chunk, const glm::vec3& a_Forward);
+
+        /*
+         * Adjust the send rate to the state of the link, and add the bytes that may be sent this tick.
+         */
+        void UpdateBudget(const LinkStats& a_Link, double a_DeltaTime);
+
+        /*
+         * Send the queued chunks that are loaded in a_ChunkStore, nearest first, until the budget or a_Limit bytes are used up.
+         * The last chunk may go over, which is taken from the next budget. Returns the amount of bytes sent.
+         * The coordinates of the sent chunks are appended to a_Sent.
+         */
+        std::uint64_t Send(IChunkStore& a_ChunkStore, IConnection& a_Connection, std::uint64_t a_Limit, std::vector<glm::ivec3>* a_Sent = nullptr);
+
+        /*
+         * Get the amount of chunks waiting to be sent.
+         */
+        std::size_t GetPendingCount() const;
+
+        /*
+         * Get the current send rate in bytes per second.
+         */
+        double GetRate() const;
+
+    private:
+        struct Entry
+        {
+            glm::ivec3 coordinates;
+
+            //Order in which the chunk was queued, used when there is no focus.
+            std::uint64_t sequence;
+
+            //Squared distance to the focus, and how much the chunk lies in the direction the client looks, from -1 to 1.
+            std::int64_t distance;
+            float facing;
+        };
+
+        /*
+         * Sort the queue so that the chunk to send first is at the back.
+         */
+        void Sort();
+
+    private:
+        double m_MaxBytesPerTick;
+
+        //Chunks to send, the next one at the back, and their packed coordinates.
+        std::vector<Entry> m_Queue;
+        std::unordered_set<std::uint64_t> m_Queued;
+        std::uint64_t m_Sequence;
+        bool m_Sorted;
+
+        glm::ivec3 m_FocusChunk;
+        glm::vec3 m_Forward;
+        bool m_HasFocus;
+
+        //Send rate in bytes per second, and the bytes that may still be sent. Negative after going over the budget.
+        double m_Rate;
+        double m_Credit;
+
+        //Whether the last send stopped because the budget was used up while chunks were waiting.
+        bool m_Limited;
+
+        //Acknowledged bytes per second, averaged over recent ticks.
+        double m_Throughput;
+        std::uint64_t m_LastAcknowledged;
+
+        //Lowest round trip time seen, and the time since the rate was last changed.
+        std::uint32_t m_LowestRoundTripTime;
+        double m_SinceAdjustment;
+    };
+}
@@ -1,57 +1,229 @@
 #include "ChunkStore.h"
 
+#include <cassert>
+
+#include <Utility.h>
+#include <VoxelData.h>
+
+#include "Chunk.h"
+
 namespace voxl
 {
+    ChunkStore::ChunkStore(std::uint32_t a_ChunksPerSlab) : m_DataPool(a_ChunksPerSlab, static_cast<std::uint32_t>(sizeof(VoxelData) * CHUNK_SIZE_CUBED)), m_Slots(INITIAL_CAPACITY, Slot{ EMPTY_KEY, 0 }), m_Mask(INITIAL_CAPACITY - 1), m_MemoryUsage(0)
+    {
+
+    }
+
     IChunk* ChunkStore::GetChunk(const glm::ivec3& a_Coordinates)
     {
-        //TODO
-        return nullptr;
+        const auto& slot = m_Slots[FindSlot(PackChunkCoordinates(a_Coordinates))];
+        if(slot.key == EMPTY_KEY)
+        {
+            return nullptr;
+        }
+        return m_Chunks[slot.index].get();
     }
 
     IChunk* ChunkStore::LoadChunk(std::unique_ptr<IChunk>&& a_Chunk)
     {
-        //TODO
-        return nullptr;
+        assert(a_Chunk != nullptr);
+        const auto key = PackChunkCoordinates(a_Chunk->GetChunkCoordinates());
+
+        //Keep the table at most half full.
+        if((m_Chunks.size() + 1) * 2 > m_Slots.size())
+        {
+            Grow();
+        }
+
+        auto& slot = m_Slots[FindSlot(key)];
+
+        //Already loaded, replace the old chunk.
+        if(slot.key != EMPTY_KEY)
+        {
+            if(m_Listener)
+            {
+                m_Listener(*m_Chunks[slot.index], false);
+            }
+            static_cast<Chunk&>(*m_Chunks[slot.index]).SetResident(false);
+            m_Chunks[slot.index] = std::move(a_Chunk);
+        }
+        else
+        {
+            slot.key = key;
+            slot.index = static_cast<std::uint32_t>(m_Chunks.size());
+            m_Chunks.emplace_back(std::move(a_Chunk));
+            m_Keys.push_back(key);
+        }
+
+        auto* chunk = m_Chunks[slot.index].get();
+        static_cast<Chunk*>(chunk)->SetResident(true);
+        if(m_Listener)
+        {
+            m_Listener(*chunk, true);
+        }
+        return chunk;
     }
 
     bool ChunkStore::UnloadChunk(const glm::ivec3& a_Coordinates)
     {
-        //TODO
-        return false;
+        auto hole = FindSlot(PackChunkCoordinates(a_Coordinates));
+        if(m_Slots[hole].key == EMPTY_KEY)
+        {
+            return false;
+        }
+
+        if(m_Listener)
+        {
+            m_Listener(*m_Chunks[m_Slots[hole].index], false);
+        }
+        static_cast<Chunk&>(*m_Chunks[m_Slots[hole].index]).SetResident(false);
+
+        //Move the last chunk into the removed chunk's place to keep the array dense, and point its slot to the new index.
+        const auto index = m_Slots[hole].index;
+        const auto last = m_Chunks.size() - 1;
+        if(index != last)
+        {
+            m_Chunks[index] = std::move(m_Chunks[last]);
+            m_Keys[index] = m_Keys[last];
+            m_Slots[FindSlot(m_Keys[index])].index = index;
+        }
+        m_Chunks.pop_back();
+        m_Keys.pop_back();
+
+        //Backward shift deletion: move entries later in the probe sequence into the hole so that no tombstones are needed.
+        auto next = hole;
+        while(true)
+        {
+            next = (next + 1) & m_Mask;
+            if(m_Slots[next].key == EMPTY_KEY)
+            {
+                break;
+            }
+
+            //Only move the entry if its home slot does not lie cyclically in (hole, next].
+            const auto home = static_cast<std::size_t>(Mix64(m_Slots[next].key)) & m_Mask;
+            const bool inRange = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+            if(!inRange)
+            {
+                m_Slots[hole] = m_Slots[next];
+                hole = next;
+            }
+        }
+        m_Slots[hole].key = EMPTY_KEY;
+
+        return true;
     }
 
     void ChunkStore::UnloadAll()
     {
-        //TODO
+        if(m_Listener)
+        {
+            for(auto& chunk : m_Chunks)
+            {
+                m_Listener(*chunk, false);
+            }
+        }
+
+        m_Chunks.clear();
+        m_Keys.clear();
+        m_MemoryUsage = 0;
+        m_Slots.assign(INITIAL_CAPACITY, Slot{ EMPTY_KEY, 0 });
+        m_Mask = INITIAL_CAPACITY - 1;
+
+        {
+            std::lock_guard<std::mutex> lock(m_DirtyMutex);
+            m_DirtyChunks.clear();
+        }
+
+        //Nothing is loaded anymore, so give the chunk memory back to the system.
+        m_DataPool.trim();
     }
 
     size_t ChunkStore::GetNumLoadedChunks()
     {
-        //TODO
-        return 0;
+        return m_Chunks.size();
     }
 
     IChunkStore::iterator ChunkStore::begin()
     {
-        //TODO
-        return nullptr;
+        return m_Chunks.data();
     }
 
     IChunkStore::iterator ChunkStore::end()
     {
-        //TODO
-        return nullptr;
+        return m_Chunks.data() + m_Chunks.size();
     }
 
     IChunkStore::const_iterator ChunkStore::begin() const
     {
-        //TODO
-        return nullptr;
+        return m_Chunks.data();
     }
 
     IChunkStore::const_iterator ChunkStore::end() const
     {
-        //TODO
-        return nullptr;
+        return m_Chunks.data() + m_Chunks.size();
+    }
+
+    utilities::SlabPool& ChunkStore::GetDataPool()
+    {
+        return m_DataPool;
+    }
+
+    void ChunkStore::MarkDirty(const glm::ivec3& a_Coordinates)
+    {
+        std::lock_guard<std::mutex> lock(m_DirtyMutex);
+        m_DirtyChunks.push_back(PackChunkCoordinates(a_Coordinates));
+    }
+
+    void ChunkStore::TakeDirtyChunks(std::vector<std::uint64_t>& a_Output)
+    {
+        std::lock_guard<std::mutex> lock(m_DirtyMutex);
+        a_Output.insert(a_Output.end(), m_DirtyChunks.begin(), m_DirtyChunks.end());
+        m_DirtyChunks.clear();
+    }
+
+    void ChunkStore::SetListener(ChunkListener a_Listener)
+    {
+        m_Listener = std::move(a_Listener);
+    }
+
+    std::uint64_t ChunkStore::GetMemoryUsage() const
+    {
+        return m_MemoryUsage;
+    }
+
+    void ChunkStore::AddMemoryUsage(std::size_t a_Bytes)
+    {
+        m_MemoryUsage += a_Bytes;
+    }
+
+    void ChunkStore::RemoveMemoryUsage(std::size_t a_Bytes)
+    {
+        assert(m_MemoryUsage >= a_Bytes && "Chunk store memory usage went below zero!");
+        m_MemoryUsage -= a_Bytes;
+    }
+
+    std::size_t ChunkStore::FindSlot(std::uint64_t a_Key) const
+    {
+        //Linear probing. The table is never full so this always terminates.
+        auto index = static_cast<std::size_t>(Mix64(a_Key)) & m_Mask;
+        while(m_Slots[index].key != a_Key && m_Slots[index].key != EMPTY_KEY)
+        {
+            index = (index + 1) & m_Mask;
+        }
+        return index;
+    }
+
+    void ChunkStore::Grow()
+    {
+        m_Slots.assign(m_Slots.size() * 2, Slot{ EMPTY_KEY, 0 });
+        m_Mask = m_Slots.size() - 1;
+
+        for(std::uint32_t i = 0; i < static_cast<std::uint32_t>(m_Keys.size()); ++i)
+        {
+            auto& slot = m_Slots[FindSlot(m_Keys[i])];
+            slot.key = m_Keys[i];
+            slot.index = i;
+        }
     }
 }
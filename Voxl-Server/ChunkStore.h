@@ -1,11 +1,34 @@
 #pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
 #include <IChunkStore.h>
+#include <memory/SlabPool.h>
 
 namespace voxl
 {
+    /*
+     * Chunk store backed by an open addressing hash table.
+     * The table maps packed chunk coordinates to an index in a dense array of chunks.
+     * Lookups never allocate, and iteration walks the dense array linearly.
+     *
+     * The store also owns the pool that the voxel data of its chunks is allocated from.
+     * Buffers of unloaded chunks are recycled for newly loaded chunks.
+     */
     class ChunkStore : public IChunkStore
     {
     public:
+        /*
+         * Called with a_Loaded set after a chunk was added to the store, and without it right before a chunk is removed.
+         */
+        using ChunkListener = std::function<void(IChunk& a_Chunk, bool a_Loaded)>;
+
+        /*
+         * Create a chunk store that allocates chunk data a_ChunksPerSlab chunks at a time.
+         */
+        explicit ChunkStore(std::uint32_t a_ChunksPerSlab);
+
         IChunk* GetChunk(const glm::ivec3& a_Coordinates) override;
         IChunk* LoadChunk(std::unique_ptr<IChunk>&& a_Chunk) override;
         bool UnloadChunk(const glm::ivec3& a_Coordinates) override;
@@ -15,6 +38,85 @@ namespace voxl
         iterator end() override;
         const_iterator begin() const override;
         const_iterator end() const override;
+
+        /*
+         * Get the pool that chunks in this store allocate their voxel data from.
+         */
+        utilities::SlabPool& GetDataPool();
+
+        /*
+         * Record that the chunk at the given coordinates has unsaved changes. Called by chunks when they become dirty.
+         * This can be called from any thread.
+         */
+        void MarkDirty(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Move the packed coordinates of all chunks marked dirty since the last call into a_Output, oldest first.
+         * The chunks may have been saved or unloaded in the meantime.
+         */
+        void TakeDirtyChunks(std::vector<std::uint64_t>& a_Output);
+
+        /*
+         * Set the function that is told about chunks being added and removed. Replaces the previous one.
+         */
+        void SetListener(ChunkListener a_Listener);
+
+        /*
+         * Get the memory used by the chunks in this store. Kept up to date by the chunks, so this does not visit them.
+         */
+        std::uint64_t GetMemoryUsage() const;
+
+        /*
+         * Adjust the memory usage total. Called by chunks in the store when their storage changes, from any thread.
+         */
+        void AddMemoryUsage(std::size_t a_Bytes);
+        void RemoveMemoryUsage(std::size_t a_Bytes);
+
+    private:
+        /*
+         * A single entry in the hash table.
+         * Empty slots have EMPTY_KEY as key.
+         */
+        struct Slot
+        {
+            std::uint64_t key;
+            std::uint32_t index;
+        };
+
+        /*
+         * Find the slot containing the given key.
+         * If the key is not in the table, the empty slot that ends the probe sequence is returned.
+         */
+        std::size_t FindSlot(std::uint64_t a_Key) const;
+
+        /*
+         * Double the size of the table and re-insert all keys.
+         */
+        void Grow();
+
+    private:
+        static constexpr std::uint64_t EMPTY_KEY = ~0ull;
+        static constexpr std::size_t INITIAL_CAPACITY = 1024;
+
+        //Declared before the chunks so that it outlives them.
+        utilities::SlabPool m_DataPool;
+
+        //Hash table with a power of two size. Never more than half full to keep probe sequences short.
+        std::vector<Slot> m_Slots;
+        std::size_t m_Mask;
+
+        //The chunks, stored densely. m_Keys contains the packed coordinates for the chunk at the same index.
+        std::vector<std::unique_ptr<IChunk>> m_Chunks;
+        std::vector<std::uint64_t> m_Keys;
+
+        //Packed coordinates of chunks that became dirty, in the order they did.
+        std::mutex m_DirtyMutex;
+        std::vector<std::uint64_t> m_DirtyChunks;
+
+        ChunkListener m_Listener;
+
+        //Memory used by the chunks in the store. Chunks in the light engine change it from the thread pool.
+        std::atomic<std::uint64_t> m_MemoryUsage;
     };
 
 }
@@ -1,17 +1,48 @@
 #include "ClientConnection.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cassert>
 
+#include <IChunkStore.h>
+#include <IEntity.h>
+#include <IWorld.h>
+#include <Utility.h>
+
+#include "Chunk.h"
+#include "PlayerController.h"
+#include "SendBufferPool.h"
+
 namespace voxl
 {
-    ClientConnection::ClientConnection(ENetPeer* a_Peer) : m_Peer(a_Peer), m_FirstConnected(0)
+    ClientConnection::ClientConnection(ENetPeer* a_Peer, SendBufferPool& a_SendBuffers, std::uint32_t a_ChunkBytesPerTick) : m_Peer(a_Peer), m_SendBuffers(a_SendBuffers), m_Writing(false), m_Channel(0),
+        m_UnacknowledgedBytes(0), m_AcknowledgedBytes(0), m_ChunkQueue(a_ChunkBytesPerTick), m_FirstConnected(0)
     {
         assert(a_Peer != nullptr);
         m_FirstConnected = std::chrono::high_resolution_clock::now().time_since_epoch().count();
         m_State = ConnectionState::CONNECTED;
     }
 
+    ClientConnection::~ClientConnection()
+    {
+        for(auto& frame : m_Frames)
+        {
+            if(frame.packet != nullptr)
+            {
+                enet_packet_destroy(frame.packet);
+            }
+        }
+
+        //ENet may still hold the packets, in which case it destroys them when it is done.
+        for(auto* packet : m_Unacknowledged)
+        {
+            if(--packet->referenceCount == 0)
+            {
+                enet_packet_destroy(packet);
+            }
+        }
+    }
+
     void ClientConnection::Disconnect()
     {
         m_State = ConnectionState::DISCONNECTED;
@@ -39,13 +70,67 @@ namespace voxl
         return std::string(name);
     }
 
-    void ClientConnection::SendPacket(const IPacket& a_Data, size_t a_Size)
+    std::uint8_t* ClientConnection::BeginPacket(std::size_t a_Size, std::uint8_t a_Channel)
     {
-        //Send the packet if connected still.
-        if(m_State == ConnectionState::CONNECTED)
+        assert(!m_Writing && "Packet started before the previous one was sent.");
+        assert(a_Channel < CHANNEL_COUNT);
+
+        //Only send the packet if connected still.
+        if(m_State != ConnectionState::CONNECTED)
         {
-            ENetPacket* packet = enet_packet_create(&a_Data, a_Size, ENET_PACKET_FLAG_RELIABLE);
-            enet_peer_send(m_Peer, 0, packet);
+            return nullptr;
+        }
+
+        //Send the frame first when the packet does not fit in it anymore.
+        const auto size = GetMessageHeaderSize(a_Size) + a_Size;
+        auto& frame = m_Frames[a_Channel];
+        if(frame.packet != nullptr && frame.size + size > frame.packet->dataLength)
+        {
+            SendFrame(a_Channel);
+        }
+
+        if(frame.packet == nullptr)
+        {
+            frame.packet = m_SendBuffers.CreatePacket(std::max(size, GetFrameCapacity()), ENET_PACKET_FLAG_RELIABLE);
+            frame.size = 0;
+            if(frame.packet == nullptr)
+            {
+                return nullptr;
+            }
+        }
+
+        PacketWriter writer(frame.packet->data + frame.size, size);
+        WriteMessageHeader(writer, a_Size);
+        auto* data = frame.packet->data + frame.size + (size - a_Size);
+        frame.size += size;
+
+        m_Writing = true;
+        m_Channel = a_Channel;
+        return data;
+    }
+
+    void ClientConnection::EndPacket()
+    {
+        assert(m_Writing && "No packet was started.");
+        m_Writing = false;
+
+        //Nothing else fits in a full frame, which happens for packets that got a frame of their own.
+        const auto& frame = m_Frames[m_Channel];
+        if(frame.size == frame.packet->dataLength)
+        {
+            SendFrame(m_Channel);
+        }
+    }
+
+    void ClientConnection::Flush()
+    {
+        assert(!m_Writing && "Flushed while a packet is being written.");
+        for(std::uint8_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+        {
+            if(m_Frames[channel].packet != nullptr)
+            {
+                SendFrame(channel);
+            }
         }
     }
 
@@ -74,4 +159,126 @@ namespace voxl
     {
         m_Controller = a_Controller;
     }
+
+    ChunkSendQueue& ClientConnection::GetChunkQueue()
+    {
+        return m_ChunkQueue;
+    }
+
+    bool ClientConnection::Subscribe(const glm::ivec3& a_Coordinates)
+    {
+        if(!m_Subscriptions.insert(PackChunkCoordinates(a_Coordinates)).second)
+        {
+            return false;
+        }
+
+        auto* chunk = GetLoadedChunk(a_Coordinates);
+        if(chunk != nullptr)
+        {
+            chunk->AddSubscriber();
+        }
+        return true;
+    }
+
+    bool ClientConnection::Unsubscribe(const glm::ivec3& a_Coordinates)
+    {
+        if(m_Subscriptions.erase(PackChunkCoordinates(a_Coordinates)) == 0)
+        {
+            return false;
+        }
+
+        auto* chunk = GetLoadedChunk(a_Coordinates);
+        if(chunk != nullptr)
+        {
+            chunk->RemoveSubscriber();
+        }
+        return true;
+    }
+
+    void ClientConnection::UnsubscribeAll()
+    {
+        for(const auto key : m_Subscriptions)
+        {
+            auto* chunk = GetLoadedChunk(UnpackChunkCoordinates(key));
+            if(chunk != nullptr)
+            {
+                chunk->RemoveSubscriber();
+            }
+        }
+        m_Subscriptions.clear();
+        m_ChunkQueue.Clear();
+    }
+
+    bool ClientConnection::IsSubscribed(const glm::ivec3& a_Coordinates) const
+    {
+        return m_Subscriptions.count(PackChunkCoordinates(a_Coordinates)) != 0;
+    }
+
+    void ClientConnection::UpdateAcknowledged()
+    {
+        //Packets only referenced here were acknowledged, or dropped when the peer was reset.
+        const auto end = std::remove_if(m_Unacknowledged.begin(), m_Unacknowledged.end(), [this](ENetPacket* a_Packet)
+        {
+            if(a_Packet->referenceCount != 1)
+            {
+                return false;
+            }
+
+            m_UnacknowledgedBytes -= a_Packet->dataLength;
+            m_AcknowledgedBytes += a_Packet->dataLength;
+            enet_packet_destroy(a_Packet);
+            return true;
+        });
+        m_Unacknowledged.erase(end, m_Unacknowledged.end());
+    }
+
+    std::size_t ClientConnection::GetFrameCapacity() const
+    {
+        //A frame is sent as one reliable command in one datagram, which starts with the protocol header.
+        const std::size_t overhead = sizeof(ENetProtocolHeader) + sizeof(ENetProtocolSendReliable);
+        return m_Peer->mtu > overhead ? m_Peer->mtu - overhead : ENET_HOST_DEFAULT_MTU - overhead;
+    }
+
+    void ClientConnection::SendFrame(std::uint8_t a_Channel)
+    {
+        auto& frame = m_Frames[a_Channel];
+        auto* packet = frame.packet;
+        frame.packet = nullptr;
+
+        //Pooled buffers only shrink, which does not copy.
+        enet_packet_resize(packet, frame.size);
+
+        //ENet takes ownership of the packet, unless it could not be queued.
+        if(enet_peer_send(m_Peer, a_Channel, packet) != 0)
+        {
+            enet_packet_destroy(packet);
+            return;
+        }
+
+        //Keep a reference to see when ENet is done with the packet, which for reliable packets means it was acknowledged.
+        ++packet->referenceCount;
+        m_Unacknowledged.push_back(packet);
+        m_UnacknowledgedBytes += packet->dataLength;
+    }
+
+    Chunk* ClientConnection::GetLoadedChunk(const glm::ivec3& a_Coordinates) const
+    {
+        auto* entity = m_Controller != nullptr ? m_Controller->GetEntity() : nullptr;
+        auto* world = entity != nullptr ? entity->GetWorld() : nullptr;
+        if(world == nullptr || world->GetWorldState() == WorldState::UNLOADED)
+        {
+            return nullptr;
+        }
+        return static_cast<Chunk*>(world->GetChunkStore().GetChunk(a_Coordinates));
+    }
+
+    LinkStats ClientConnection::GetLinkStats() const
+    {
+        LinkStats stats;
+        stats.roundTripTime = m_Peer->roundTripTime;
+        stats.unacknowledgedBytes = m_UnacknowledgedBytes;
+        stats.acknowledgedBytes = m_AcknowledgedBytes;
+        stats.bandwidth = m_Peer->incomingBandwidth;
+        return stats;
+    }
 }
@@ -1,20 +1,40 @@
 #pragma once
 #include <enet/enet.h>
 #include <memory>
+#include <unordered_set>
+#include <vector>
 #include <IClientConnection.h>
 
+#include "ChunkSendQueue.h"
+
 namespace voxl
 {
+    class Chunk;
     class IEntityController;
     class PlayerController;
+    class SendBufferPool;
 
     /*
      * This class describes a connection between client and server.
+     *
+     * Packets sent during a tick are written one after another into a frame per channel, which is sent as a single ENet packet by Flush.
+     * A frame that would grow past what fits in one datagram is sent right away and a new one is started, so that ENet does not have to
+     * fragment it. Packets too large for a frame get a frame of their own.
      */
     class ClientConnection : public IClientConnection
     {
     public:
-        explicit ClientConnection(ENetPeer* a_Peer);
+        //Amount of ENet channels used to send to clients.
+        static constexpr std::uint8_t CHANNEL_COUNT = 2;
+
+    public:
+        /*
+         * Create a connection for a peer. Packets are sent from buffers in a_SendBuffers.
+         * At most a_ChunkBytesPerTick bytes of chunks are sent to the client per tick.
+         */
+        ClientConnection(ENetPeer* a_Peer, SendBufferPool& a_SendBuffers, std::uint32_t a_ChunkBytesPerTick);
+
+        ~ClientConnection() override;
 
     public:
         void Disconnect() override;
@@ -22,7 +42,8 @@ namespace voxl
         std::uint64_t GetLastResponse() override;
         std::uint64_t GetConnectionStartTime() override;
         std::string GetIp() override;
-        void SendPacket(const IPacket& a_Data, size_t a_Size) override;
+        std::uint8_t* BeginPacket(std::size_t a_Size, std::uint8_t a_Channel) override;
+        void EndPacket() override;
         std::string GetUsername() const override;
 
     public:
@@ -47,8 +68,89 @@ namespace voxl
          */
         void SetController(std::shared_ptr<PlayerController>& a_Controller);
 
+        /*
+         * Send the frames of all channels. Called at the end of every tick.
+         */
+        void Flush();
+
+        /*
+         * Get the chunks that are waiting to be sent to this client.
+         */
+        ChunkSendQueue& GetChunkQueue();
+
+        /*
+         * Subscribe to or unsubscribe from the chunk at the given coordinates.
+         * The subscriber count of the chunk is updated when it is loaded in the world of the controlled entity. Chunks loaded later get it from the world.
+         * Returns false if the client already was or was not subscribed.
+         */
+        bool Subscribe(const glm::ivec3& a_Coordinates);
+        bool Unsubscribe(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Unsubscribe from every chunk. Called when the client disconnects, so that its chunks can be unloaded.
+         */
+        void UnsubscribeAll();
+
+        /*
+         * Returns true if the client is subscribed to the chunk at the given coordinates.
+         */
+        bool IsSubscribed(const glm::ivec3& a_Coordinates) const;
+
+        /*
+         * Count the packets the client acknowledged since the last call. Called once per tick.
+         */
+        void UpdateAcknowledged();
+
+        /*
+         * Get the state of the link to the client as measured by ENet, and the bytes it acknowledged.
+         */
+        LinkStats GetLinkStats() const;
+
+    private:
+        /*
+         * Packets written during this tick that were not sent yet.
+         */
+        struct Frame
+        {
+            ENetPacket* packet = nullptr;
+            std::size_t size = 0;
+        };
+
+        /*
+         * Get the amount of bytes of a frame that fits in a single datagram.
+         */
+        std::size_t GetFrameCapacity() const;
+
+        /*
+         * Send the frame of a channel and start a new one with the next packet.
+         */
+        void SendFrame(std::uint8_t a_Channel);
+
+        /*
+         * Get the chunk at the given coordinates in the world of the controlled entity, or nullptr if it is not loaded.
+         */
+        Chunk* GetLoadedChunk(const glm::ivec3& a_Coordinates) const;
+
     private:
         ENetPeer* m_Peer;
+        SendBufferPool& m_SendBuffers;
+
+        Frame m_Frames[CHANNEL_COUNT];
+
+        //Whether a packet is being written between BeginPacket and EndPacket, and the channel of its frame.
+        bool m_Writing;
+        std::uint8_t m_Channel;
+
+        //Sent packets that are kept alive with an extra reference, until ENet releases them after the client acknowledged them.
+        std::vector<ENetPacket*> m_Unacknowledged;
+        std::uint64_t m_UnacknowledgedBytes;
+        std::uint64_t m_AcknowledgedBytes;
+
+        ChunkSendQueue m_ChunkQueue;
+
+        //Packed coordinates of the chunks the client is subscribed to.
+        std::unordered_set<std::uint64_t> m_Subscriptions;
+
         std::string m_Username;
         std::uint64_t m_FirstConnected;
         ConnectionState m_State;
@@ -0,0 +1,91 @@
+#include "ColumnCache.h"
+
+namespace voxl
+{
+    std::size_t ColumnCache::KeyHash::operator()(const Key& a_Key) const
+    {
+        //Neighbouring columns only differ in a few bits, so mix them before picking a shard or bucket.
+        return static_cast<std::size_t>(Mix64(a_Key.column ^ (a_Key.seed * 0x9E3779B97F4A7C15ull)));
+    }
+
+    ColumnCache::ColumnCache(std::uint32_t a_Capacity) : m_ShardCapacity((a_Capacity + SHARD_COUNT - 1) / SHARD_COUNT), m_Hits(0), m_Misses(0)
+    {
+
+    }
+
+    std::shared_ptr<const TerrainColumn> ColumnCache::Get(std::uint64_t a_Seed, std::int32_t a_X, std::int32_t a_Z)
+    {
+        const auto key = MakeKey(a_Seed, a_X, a_Z);
+        auto& shard = GetShard(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto found = shard.columns.find(key);
+        if(found == shard.columns.end())
+        {
+            ++m_Misses;
+            return nullptr;
+        }
+
+        ++m_Hits;
+        shard.order.splice(shard.order.begin(), shard.order, found->second);
+        return found->second->second;
+    }
+
+    void ColumnCache::Insert(std::uint64_t a_Seed, std::int32_t a_X, std::int32_t a_Z, std::shared_ptr<const TerrainColumn> a_Column)
+    {
+        if(m_ShardCapacity == 0)
+        {
+            return;
+        }
+
+        const auto key = MakeKey(a_Seed, a_X, a_Z);
+        auto& shard = GetShard(key);
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if(shard.columns.count(key) != 0)
+        {
+            return;
+        }
+
+        if(shard.order.size() >= m_ShardCapacity)
+        {
+            shard.columns.erase(shard.order.back().first);
+            shard.order.pop_back();
+        }
+
+        shard.order.emplace_front(key, std::move(a_Column));
+        shard.columns.emplace(key, shard.order.begin());
+    }
+
+    void ColumnCache::Clear()
+    {
+        for(auto& shard : m_Shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.columns.clear();
+            shard.order.clear();
+        }
+    }
+
+    std::uint64_t ColumnCache::GetHits() const
+    {
+        return m_Hits;
+    }
+
+    std::uint64_t ColumnCache::GetMisses() const
+    {
+        return m_Misses;
+    }
+
+    ColumnCache::Key ColumnCache::MakeKey(std::uint64_t a_Seed, std::int32_t a_X, std::int32_t a_Z)
+    {
+        return { a_Seed, (static_cast<std::uint64_t>(static_cast<std::uint32_t>(a_X)) << 32) | static_cast<std::uint32_t>(a_Z) };
+    }
+
+    ColumnCache::Shard& ColumnCache::GetShard(const Key& a_Key)
+    {
+        //The bucket index uses the low bits of the hash, so pick the shard with the high ones.
+        const auto hash = static_cast<std::uint64_t>(KeyHash()(a_Key));
+        return m_Shards[(hash >> 56) % SHARD_COUNT];
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <Utility.h>
+
+namespace voxl
+{
+    /*
+     * The kinds of terrain the default generator produces, picked from temperature and humidity.
+     */
+    enum class Biome : std::uint8_t
+    {
+        PLAINS,
+        FOREST,
+        DESERT,
+        MOUNTAINS
+    };
+
+    /*
+     * Terrain data shared by all chunks in a column, which only depends on the x and z coordinates.
+     * All arrays are indexed by z * CHUNK_SIZE + x.
+     */
+    struct TerrainColumn
+    {
+        //Height of the terrain surface.
+        int heights[CHUNK_SIZE_SQUARED];
+
+        //Climate, roughly between -1 and 1.
+        float temperature[CHUNK_SIZE_SQUARED];
+        float humidity[CHUNK_SIZE_SQUARED];
+
+        Biome biomes[CHUNK_SIZE_SQUARED];
+
+        //The largest value in heights.
+        int highest;
+    };
+
+    /*
+     * Bounded cache of TerrainColumns, keyed by seed and chunk column.
+     *
+     * The world is unbounded vertically, so every chunk stacked in a column would otherwise compute the same 2D noise again.
+     * The cache is split into shards that each have their own lock and evict their least recently used column, so generation workers rarely wait on each other.
+     * Columns are handed out as shared pointers to const data, and can be used after they have been evicted.
+     */
+    class ColumnCache
+    {
+    public:
+        //Amount of independently locked parts of the cache.
+        static constexpr std::uint32_t SHARD_COUNT = 16;
+
+    public:
+        /*
+         * Create a cache that holds at most a_Capacity columns. A capacity of 0 disables caching.
+         */
+        explicit ColumnCache(std::uint32_t a_Capacity);
+
+        /*
+         * Get the column at the given chunk x and z for a seed, or nullptr if it is not cached.
+         */
+        std::shared_ptr<const TerrainColumn> Get(std::uint64_t a_Seed, std::int32_t a_X, std::int32_t a_Z);
+
+        /*
+         * Add a column to the cache, evicting the least recently used column of its shard when full.
+         * When two workers computed the same column, the one inserted first is kept.
+         */
+        void Insert(std::uint64_t a_Seed, std::int32_t a_X, std::int32_t a_Z, std::shared_ptr<const TerrainColumn> a_Column);
+
+        /*
+         * Remove all columns.
+         */
+        void Clear();
+
+        /*
+         * Get the amount of lookups that found a column, and that did not.
+         */
+        std::uint64_t GetHits() const;
+        std::uint64_t GetMisses() const;
+
+    private:
+        struct Key
+        {
+            std::uint64_t seed;
+            std::uint64_t column;
+
+            bool operator==(const Key& a_Other) const
+            {
+                return seed == a_Other.seed && column == a_Other.column;
+            }
+        };
+
+        struct KeyHash
+        {
+            std::size_t operator()(const Key& a_Key) const;
+        };
+
+        struct Shard
+        {
+            std::mutex mutex;
+
+            //Most recently used columns at the front.
+            std::list<std::pair<Key, std::shared_ptr<const TerrainColumn>>> order;
+            std::unordered_map<Key, decltype(order)::iterator, KeyHash> columns;
+        };
+
+        static Key MakeKey(std::uint64_t a_Seed, std::int32_t a_X, std::int32_t a_Z);
+        Shard& GetShard(const Key& a_Key);
+
+    private:
+        std::uint32_t m_ShardCapacity;
+        Shard m_Shards[SHARD_COUNT];
+        std::atomic<std::uint64_t> m_Hits;
+        std::atomic<std::uint64_t> m_Misses;
+    };
+}
@@ -6,10 +6,11 @@
 #include "ClientConnection.h"
 #include "other/ServiceLocator.h"
 #include "PacketManager.h"
+#include "SendBufferPool.h"
 
 namespace voxl
 {
-    ConnectionManager::ConnectionManager() : m_Server(nullptr)
+    ConnectionManager::ConnectionManager() : m_SendBuffers(std::make_unique<SendBufferPool>()), m_Server(nullptr), m_ChunkBytesPerTick(0)
     {
 
     }
@@ -36,7 +37,7 @@ namespace voxl
 
             server = enet_host_create(&address     /* the address to bind the server host to */,
                 a_Settings.maximumConnections      /* allow up to 32 clients and/or outgoing connections */,
-                2      /* allow up to 2 channels to be used, 0 and 1 */,
+                ClientConnection::CHANNEL_COUNT      /* allow up to 2 channels to be used, 0 and 1 */,
                 0      /* assume any amount of incoming bandwidth */,
                 0      /* assume any amount of outgoing bandwidth */);
 
@@ -47,6 +48,7 @@ namespace voxl
 
             //Store pointer for deletion and access.
             m_Server = server;
+            m_ChunkBytesPerTick = a_Settings.chunkSendBytesPerTick;
 
             //Creat the packet manager instance.
             m_PacketManager = std::make_unique<PacketManager>();
@@ -89,38 +91,48 @@ namespace voxl
                 break;
             case ENET_EVENT_TYPE_RECEIVE:
                 {
-                    IPacket* packet = reinterpret_cast<IPacket*>(event.packet->data);
-
-                    //Packet received for user that has authenticated.
-                    if (event.peer->data != nullptr)
-                    {
-                        ClientConnection* c = static_cast<ClientConnection*>(event.peer->data);
-                        m_PacketManager->Resolve(packet->type, *packet, c);
-                    }
-                    else
+                    //A packet holds all messages the client sent in one frame. They are read in place, and their fields are checked
+                    //against the size of the message when they are resolved. A malformed frame drops the messages after it.
+                    PacketReader packet(event.packet->data, event.packet->dataLength);
+                    PacketReader reader(nullptr, 0);
+                    while (ReadMessage(packet, reader))
                     {
-                        //If no authentication happened, and this is not an authentication packet or the authentication failed, return.
-                        if (packet->type != PacketType::AUTHENTICATE)
+                        PacketType type = PacketType::UNKNOWN;
+                        const bool valid = ReadPacketType(reader, type);
+
+                        //Packet received for user that has authenticated. Packets that are not understood are dropped.
+                        if (event.peer->data != nullptr)
                         {
-                            enet_peer_disconnect(event.peer, 0);
+                            ClientConnection* c = static_cast<ClientConnection*>(event.peer->data);
+                            if (valid)
+                            {
+                                m_PacketManager->Resolve(type, reader, c);
+                            }
                         }
-                        //If this is the authentication packet, verify the user and then add them to the active connections.
                         else
                         {
-                            //Authenticate the user which adds them to the connections list. If the packet returns true it means authentication succeeded.
-                            //In that case connection will contain the right data.
-                            std::unique_ptr<ClientConnection> connection = std::make_unique<ClientConnection>(event.peer);
-                            if(m_PacketManager->Resolve(PacketType::AUTHENTICATE, *packet, connection.get()))
+                            //If no authentication happened, and this is not an authentication packet or the authentication failed, return.
+                            if (!valid || type != PacketType::AUTHENTICATE)
                             {
-                                //Link the peer and the data object and then insert into the user set.
-                                event.peer->data = connection.get();
-                                m_Clients.insert(std::make_pair(connection->GetUsername(), std::move(connection)));
+                                enet_peer_disconnect(event.peer, 0);
+                                break;
                             }
-                            else
+
+                            //Authenticate the user which adds them to the connections list. If the packet returns true it means authentication succeeded.
+                            //In that case connection will contain the right data. The response is sent right away, so that it arrives before a disconnect.
+                            std::unique_ptr<ClientConnection> connection = std::make_unique<ClientConnection>(event.peer, *m_SendBuffers, m_ChunkBytesPerTick);
+                            const bool authenticated = m_PacketManager->Resolve(PacketType::AUTHENTICATE, reader, connection.get());
+                            connection->Flush();
+                            if (!authenticated)
                             {
                                 //Client already connected with that name or other failure.
                                 enet_peer_disconnect(event.peer, 0);
+                                break;
                             }
+
+                            //Link the peer and the data object and then insert into the user set.
+                            event.peer->data = connection.get();
+                            m_Clients.insert(std::make_pair(connection->GetUsername(), std::move(connection)));
                         }
                     }
                     enet_packet_destroy(event.packet);
@@ -140,6 +152,7 @@ namespace voxl
                         if (found != m_Clients.end())
                         {
                             utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Info, "Client '" + found->second->GetUsername() + "' disconnected at ip: " + found->second->GetIp() + ".");
+                            static_cast<ClientConnection*>(found->second.get())->UnsubscribeAll();
                             m_Clients.erase(found);
                         }
                     }
@@ -159,13 +172,28 @@ namespace voxl
         //Update client state stuff.
         for (auto& client : m_Clients)
         {
+            ClientConnection* c = static_cast<ClientConnection*>(client.second.get());
+
             //Clients that are marked for disconnect are removed.
             if (client.second->GetConnectionState() == ConnectionState::DISCONNECTED)
             {
-                const ClientConnection* c = static_cast<ClientConnection*>(client.second.get());
                 enet_peer_disconnect_now(c->GetPeer(), 0);
             }
+
+            //Acknowledgements were processed by the host service above.
+            c->UpdateAcknowledged();
+        }
+    }
+
+    void ConnectionManager::FlushClientConnections()
+    {
+        for (auto& client : m_Clients)
+        {
+            static_cast<ClientConnection*>(client.second.get())->Flush();
         }
+
+        //Hand the frames to the socket now instead of at the next host service.
+        enet_host_flush(m_Server);
     }
 
     IPacketManager& ConnectionManager::GetPacketManager()
@@ -1,6 +1,7 @@
 #pragma once
 #include <IConnectionManager.h>
 #include <map>
+#include <memory>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -10,6 +11,8 @@ struct _ENetHost;
 
 namespace voxl
 {
+    class SendBufferPool;
+
     class ConnectionManager : public IConnectionManager
     {
     public:
@@ -21,11 +24,19 @@ namespace voxl
         void Stop() override;
         std::vector<IClientConnection*> GetConnectedClients() override;
         void ProcessClientConnections() override;
+        void FlushClientConnections() override;
         IPacketManager& GetPacketManager() override;
         void DisconnectClients() override;
         IClientConnection* GetClient(const std::string& a_Username) override;
     private:
+        //Buffers of outgoing packets. ENet frees them when the host is destroyed, so the pool is kept alive until the manager is.
+        std::unique_ptr<SendBufferPool> m_SendBuffers;
+
         _ENetHost* m_Server;
+
+        //Most bytes of chunks sent to a single client per tick.
+        std::uint32_t m_ChunkBytesPerTick;
+
         std::unordered_map<std::string, std::unique_ptr<IClientConnection>> m_Clients;
         std::unique_ptr<IPacketManager> m_PacketManager;
     };
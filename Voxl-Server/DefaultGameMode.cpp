@@ -11,7 +11,7 @@ namespace voxl
         {
             if (world->GetWorldState() == WorldState::RUNNING)
             {
-                world->Save();
+                world->Save(true);
             }
         }
     }
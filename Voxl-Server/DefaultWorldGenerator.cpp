@@ -1,20 +1,307 @@
 #include "DefaultWorldGenerator.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <ChunkRandom.h>
+#include <IChunk.h>
+#include <IPopulateContext.h>
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+
 namespace voxl
 {
+    namespace
+    {
+        //Caves and climate use their own noise, so that they do not follow the shape of the terrain.
+        constexpr std::uint64_t CAVE_SEED = 0x5DEECE66Dull;
+        constexpr std::uint64_t TEMPERATURE_SEED = 0x2545F4914F6CDD1Dull;
+        constexpr std::uint64_t HUMIDITY_SEED = 0x9FB21C651E98DF25ull;
+
+        //The most samples the climate grid of a column can have, at a spacing of 1.
+        constexpr int MAX_GRID_SAMPLES = (CHUNK_SIZE + 1) * (CHUNK_SIZE + 1);
+
+        //The terrain height is the base height plus or minus at most the height variation.
+        struct BiomeShape
+        {
+            float baseHeight;
+            float heightVariation;
+        };
+
+        //Indexed by Biome.
+        constexpr BiomeShape BIOME_SHAPES[] =
+        {
+            { 28.0f, 12.0f },   //PLAINS
+            { 32.0f, 28.0f },   //FOREST
+            { 24.0f, 6.0f },    //DESERT
+            { 48.0f, 72.0f }    //MOUNTAINS
+        };
+
+        /*
+         * Bilinearly interpolate a grid with a sample every a_Spacing voxels at the given voxel in the column.
+         */
+        float Interpolate(const float* a_Grid, int a_GridSize, int a_Spacing, int a_X, int a_Z)
+        {
+            const auto fractionX = static_cast<float>(a_X % a_Spacing) / static_cast<float>(a_Spacing);
+            const auto fractionZ = static_cast<float>(a_Z % a_Spacing) / static_cast<float>(a_Spacing);
+            const auto* corner = a_Grid + (a_Z / a_Spacing) * a_GridSize + a_X / a_Spacing;
+
+            const auto near = corner[0] + (corner[1] - corner[0]) * fractionX;
+            const auto far = corner[a_GridSize] + (corner[a_GridSize + 1] - corner[a_GridSize]) * fractionX;
+            return near + (far - near) * fractionZ;
+        }
+    }
+
+    DefaultWorldGenerator::DefaultWorldGenerator(const DefaultGeneratorSettings& a_Settings) : m_Settings(a_Settings), m_Columns(a_Settings.columnCacheSize)
+    {
+        //Grid points have to line up with the edges of every column, so that neighbouring columns interpolate between the same samples.
+        std::uint32_t spacing = 1;
+        while(spacing * 2 <= std::min(a_Settings.climateSpacing, static_cast<std::uint32_t>(CHUNK_SIZE)))
+        {
+            spacing *= 2;
+        }
+
+        if(spacing != a_Settings.climateSpacing)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Warning, "Climate spacing " + std::to_string(a_Settings.climateSpacing) + " is not a power of two up to the chunk size, using " + std::to_string(spacing) + " instead.");
+        }
+        m_Settings.climateSpacing = spacing;
+    }
+
     void DefaultWorldGenerator::Generate(const std::uint64_t a_Seed, IChunk& a_Chunk)
     {
-        //TODO
+        const auto coordinates = a_Chunk.GetChunkCoordinates();
+        const auto origin = coordinates * CHUNK_SIZE;
+
+        //The heightmap is shared with the chunks above and below.
+        const auto column = GetColumn(a_Seed, coordinates.x, coordinates.z);
+        const auto* heights = column->heights;
+
+        VoxelData air;
+        air.id = AIR;
+        VoxelData stone;
+        stone.id = STONE;
+
+        //Chunks entirely above the terrain skip the cave noise.
+        if(column->highest <= origin.y)
+        {
+            a_Chunk.Fill(air);
+            return;
+        }
+
+        const FractalNoise caves(a_Seed ^ CAVE_SEED, GetCaveNoise(), m_Settings.kernel);
+        VoxelData voxels[CHUNK_SIZE_CUBED];
+        float cave[CHUNK_SIZE];
+        for(int y = 0; y < CHUNK_SIZE; ++y)
+        {
+            const auto worldY = origin.y + y;
+            for(int z = 0; z < CHUNK_SIZE; ++z)
+            {
+                const auto* columns = heights + z * CHUNK_SIZE;
+                auto* row = voxels + GetVoxelIndex(glm::uvec3(0, y, z));
+
+                const auto solid = std::any_of(columns, columns + CHUNK_SIZE, [worldY](int a_Height) { return worldY < a_Height; });
+                if(!solid)
+                {
+                    std::fill(row, row + CHUNK_SIZE, air);
+                    continue;
+                }
+
+                caves.Row3D(static_cast<float>(origin.x), static_cast<float>(worldY), static_cast<float>(origin.z + z), 1.0f, CHUNK_SIZE, cave);
+                for(int x = 0; x < CHUNK_SIZE; ++x)
+                {
+                    row[x] = worldY < columns[x] && cave[x] <= CAVE_THRESHOLD ? stone : air;
+                }
+            }
+        }
+
+        a_Chunk.SetVoxels(voxels);
+        a_Chunk.Compact();
     }
 
-    void DefaultWorldGenerator::Populate(const std::uint64_t a_Seed, IChunk& a_Chunk)
+    void DefaultWorldGenerator::Populate(const std::uint64_t a_Seed, IChunk& a_Chunk, IPopulateContext& a_Context)
     {
-        //TODO
+        const auto coordinates = a_Chunk.GetChunkCoordinates();
+        const auto origin = coordinates * CHUNK_SIZE;
+        const auto column = GetColumn(a_Seed, coordinates.x, coordinates.z);
+        if(column->highest < origin.y)
+        {
+            return;
+        }
+
+        VoxelData stone;
+        stone.id = STONE;
+
+        ChunkRandom random(a_Seed, coordinates, STAGE_BOULDERS);
+        for(std::uint32_t attempt = 0; attempt < BOULDER_ATTEMPTS; ++attempt)
+        {
+            //Every attempt uses its own stream, so a skipped attempt does not change the ones after it.
+            auto boulder = random.Fork(attempt);
+            if(!boulder.NextChance(BOULDER_CHANCE))
+            {
+                continue;
+            }
+
+            //The center has to be on the surface in this chunk, the rest of the boulder may reach into its neighbours.
+            const auto radius = boulder.NextInt(1, 2);
+            const auto x = boulder.NextInt(0, CHUNK_SIZE - 1);
+            const auto z = boulder.NextInt(0, CHUNK_SIZE - 1);
+            const auto i = z * CHUNK_SIZE + x;
+            const auto y = column->heights[i] - origin.y;
+            if(y < 0 || y >= CHUNK_SIZE || (column->biomes[i] != Biome::PLAINS && column->biomes[i] != Biome::FOREST))
+            {
+                continue;
+            }
+
+            for(int dy = -radius; dy <= radius; ++dy)
+            {
+                for(int dz = -radius; dz <= radius; ++dz)
+                {
+                    for(int dx = -radius; dx <= radius; ++dx)
+                    {
+                        if(dx * dx + dy * dy + dz * dz <= radius * radius)
+                        {
+                            a_Context.SetVoxel(origin + glm::ivec3(x + dx, y + dy, z + dz), stone);
+                        }
+                    }
+                }
+            }
+        }
     }
 
     std::string DefaultWorldGenerator::GetName() const
     {
-        //TODO
-        return "";
+        return "default";
+    }
+
+    const DefaultGeneratorSettings& DefaultWorldGenerator::GetSettings() const
+    {
+        return m_Settings;
+    }
+
+    bool DefaultWorldGenerator::CheckWorldSettings(WorldSettings& a_Settings) const
+    {
+        if(a_Settings.climateSpacing == 0)
+        {
+            a_Settings.climateSpacing = m_Settings.climateSpacing;
+            return true;
+        }
+
+        if(a_Settings.climateSpacing != m_Settings.climateSpacing)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "World '" + a_Settings.name + "' was created with climate spacing " + std::to_string(a_Settings.climateSpacing) +
+                ", but the generator uses " + std::to_string(m_Settings.climateSpacing) + ".");
+            return false;
+        }
+        return true;
+    }
+
+    const ColumnCache& DefaultWorldGenerator::GetColumnCache() const
+    {
+        return m_Columns;
+    }
+
+    std::shared_ptr<const TerrainColumn> DefaultWorldGenerator::GetColumn(std::uint64_t a_Seed, std::int32_t a_X, std::int32_t a_Z)
+    {
+        auto cached = m_Columns.Get(a_Seed, a_X, a_Z);
+        if(cached != nullptr)
+        {
+            return cached;
+        }
+
+        const auto originX = static_cast<float>(a_X * CHUNK_SIZE);
+        const auto originZ = static_cast<float>(a_Z * CHUNK_SIZE);
+
+        //Sample the climate on the coarse grid, including the edge shared with the next columns.
+        const auto spacing = static_cast<int>(m_Settings.climateSpacing);
+        const auto gridSize = CHUNK_SIZE / spacing + 1;
+        const FractalNoise temperature(a_Seed ^ TEMPERATURE_SEED, GetClimateNoise(), m_Settings.kernel);
+        const FractalNoise humidity(a_Seed ^ HUMIDITY_SEED, GetClimateNoise(), m_Settings.kernel);
+        float temperatureGrid[MAX_GRID_SAMPLES];
+        float humidityGrid[MAX_GRID_SAMPLES];
+        for(int z = 0; z < gridSize; ++z)
+        {
+            const auto rowZ = originZ + static_cast<float>(z * spacing);
+            temperature.Row2D(originX, rowZ, static_cast<float>(spacing), gridSize, temperatureGrid + z * gridSize);
+            humidity.Row2D(originX, rowZ, static_cast<float>(spacing), gridSize, humidityGrid + z * gridSize);
+        }
+
+        //The shape of the terrain is interpolated between the biomes at the grid points, so that biomes blend into each other.
+        float baseGrid[MAX_GRID_SAMPLES];
+        float variationGrid[MAX_GRID_SAMPLES];
+        for(int i = 0; i < gridSize * gridSize; ++i)
+        {
+            const auto& shape = BIOME_SHAPES[static_cast<int>(GetBiome(temperatureGrid[i], humidityGrid[i]))];
+            baseGrid[i] = shape.baseHeight;
+            variationGrid[i] = shape.heightVariation;
+        }
+
+        //The heightmap itself is detailed, so it is sampled for every voxel column.
+        const FractalNoise terrain(a_Seed, GetTerrainNoise(), m_Settings.kernel);
+        float heightmap[CHUNK_SIZE_SQUARED];
+        for(int z = 0; z < CHUNK_SIZE; ++z)
+        {
+            terrain.Row2D(originX, originZ + static_cast<float>(z), 1.0f, CHUNK_SIZE, heightmap + z * CHUNK_SIZE);
+        }
+
+        auto column = std::make_shared<TerrainColumn>();
+        column->highest = std::numeric_limits<int>::min();
+        for(int z = 0; z < CHUNK_SIZE; ++z)
+        {
+            for(int x = 0; x < CHUNK_SIZE; ++x)
+            {
+                const auto i = z * CHUNK_SIZE + x;
+                column->temperature[i] = Interpolate(temperatureGrid, gridSize, spacing, x, z);
+                column->humidity[i] = Interpolate(humidityGrid, gridSize, spacing, x, z);
+                column->biomes[i] = GetBiome(column->temperature[i], column->humidity[i]);
+
+                const auto baseHeight = Interpolate(baseGrid, gridSize, spacing, x, z);
+                const auto heightVariation = Interpolate(variationGrid, gridSize, spacing, x, z);
+                column->heights[i] = static_cast<int>(std::floor(baseHeight + heightmap[i] * heightVariation));
+                column->highest = std::max(column->highest, column->heights[i]);
+            }
+        }
+
+        //Another worker may have computed the same column meanwhile, both results are equal.
+        m_Columns.Insert(a_Seed, a_X, a_Z, column);
+        return column;
+    }
+
+    NoiseSettings DefaultWorldGenerator::GetTerrainNoise()
+    {
+        NoiseSettings settings;
+        settings.octaves = 5;
+        settings.frequency = 1.0f / 256.0f;
+        return settings;
+    }
+
+    NoiseSettings DefaultWorldGenerator::GetCaveNoise()
+    {
+        NoiseSettings settings;
+        settings.octaves = 2;
+        settings.frequency = 1.0f / 48.0f;
+        return settings;
+    }
+
+    NoiseSettings DefaultWorldGenerator::GetClimateNoise()
+    {
+        NoiseSettings settings;
+        settings.octaves = 4;
+        settings.frequency = 1.0f / 1024.0f;
+        return settings;
+    }
+
+    Biome DefaultWorldGenerator::GetBiome(float a_Temperature, float a_Humidity)
+    {
+        if(a_Temperature < -0.25f)
+        {
+            return Biome::MOUNTAINS;
+        }
+        if(a_Temperature > 0.25f && a_Humidity < 0.0f)
+        {
+            return Biome::DESERT;
+        }
+        return a_Humidity > 0.15f ? Biome::FOREST : Biome::PLAINS;
     }
 }
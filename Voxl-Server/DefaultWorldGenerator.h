@@ -1,13 +1,99 @@
 #pragma once
+#include <memory>
+
+#include <IWorld.h>
 #include <IWorldGenerator.h>
 
+#include "ColumnCache.h"
+#include "Noise.h"
+
 namespace voxl
 {
+    /*
+     * Settings for the default world generator.
+     */
+    struct DefaultGeneratorSettings
+    {
+        //The instruction set noise is evaluated with.
+        NoiseKernel kernel = FractalNoise::GetFastestKernel();
+
+        //Amount of chunk columns whose terrain data is kept, about 3 KB each. 0 disables the cache.
+        std::uint32_t columnCacheSize = 4096;
+
+        //Distance in voxels between climate samples, which are interpolated in between. Rounded down to a power of two no larger than CHUNK_SIZE.
+        std::uint32_t climateSpacing = 4;
+    };
+
+    /*
+     * Generates stone terrain from a fractal heightmap, with caves carved out by 3D noise.
+     *
+     * The shape of the terrain depends on the biome, which is picked from temperature and humidity.
+     * Climate varies slowly, so it is only sampled on a coarse grid and interpolated bilinearly in between.
+     * The height and roughness of the biomes are interpolated the same way, which blends the terrain smoothly where biomes meet.
+     * Population scatters boulders on the surface, which may reach into neighbouring chunks.
+     */
     class DefaultWorldGenerator : public IWorldGenerator
     {
     public:
+        //Voxel types used by the terrain.
+        static constexpr std::uint16_t AIR = 0;
+        static constexpr std::uint16_t STONE = 1;
+
+        //Stone is carved out where the cave noise is above this value.
+        static constexpr float CAVE_THRESHOLD = 0.55f;
+
+        //Chance for each of BOULDER_ATTEMPTS to place a boulder on plains or forest surface in a chunk.
+        static constexpr std::uint32_t BOULDER_ATTEMPTS = 2;
+        static constexpr float BOULDER_CHANCE = 0.2f;
+
+        //ChunkRandom stages used by this generator.
+        static constexpr std::uint32_t STAGE_BOULDERS = 1;
+
+    public:
+        explicit DefaultWorldGenerator(const DefaultGeneratorSettings& a_Settings = DefaultGeneratorSettings());
+
         void Generate(const std::uint64_t a_Seed, IChunk& a_Chunk) override;
-        void Populate(const std::uint64_t a_Seed, IChunk& a_Chunk) override;
+        void Populate(const std::uint64_t a_Seed, IChunk& a_Chunk, IPopulateContext& a_Context) override;
         std::string GetName() const override;
+
+        /*
+         * Get the settings this generator uses, with the climate spacing rounded.
+         */
+        const DefaultGeneratorSettings& GetSettings() const;
+
+        /*
+         * Check that a world was created with the climate spacing this generator uses, and record it in worlds that do not have one yet.
+         * Returns false when the spacing differs, as new chunks would not line up with the terrain of the saved ones.
+         */
+        bool CheckWorldSettings(WorldSettings& a_Settings) const;
+
+        /*
+         * Get the noise settings used for the heightmap, the caves and the climate.
+         */
+        static NoiseSettings GetTerrainNoise();
+        static NoiseSettings GetCaveNoise();
+        static NoiseSettings GetClimateNoise();
+
+        /*
+         * Get the biome for the given temperature and humidity.
+         */
+        static Biome GetBiome(float a_Temperature, float a_Humidity);
+
+        /*
+         * Get the cache of terrain columns, shared by all worlds using this generator.
+         */
+        const ColumnCache& GetColumnCache() const;
+
+    private:
+        /*
+         * Get the terrain column for the given chunk coordinates, computing it if it is not cached.
+         */
+        std::shared_ptr<const TerrainColumn> GetColumn(std::uint64_t a_Seed, std::int32_t a_X, std::int32_t a_Z);
+
+    private:
+        DefaultGeneratorSettings m_Settings;
+
+        //Generation workers share this, it does its own locking.
+        ColumnCache m_Columns;
     };
-}
\ No newline at end of file
+}
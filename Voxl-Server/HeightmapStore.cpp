@@ -0,0 +1,223 @@
+#include "HeightmapStore.h"
+
+#include <algorithm>
+
+#include <IChunk.h>
+#include <IChunkStore.h>
+#include <VoxelRegistry.h>
+
+namespace voxl
+{
+    namespace
+    {
+        /*
+         * Divide rounding towards negative infinity, to find the chunk of a world coordinate.
+         */
+        std::int32_t FloorDivide(std::int32_t a_Value)
+        {
+            return (a_Value < 0 ? a_Value - (CHUNK_SIZE - 1) : a_Value) / CHUNK_SIZE;
+        }
+    }
+
+    HeightmapStore::HeightmapStore(VoxelRegistry& a_Registry)
+    {
+        //Types that are not registered block light.
+        const auto count = a_Registry.GetMaximumEntries();
+        m_Blocking.assign(count, 1);
+        for(std::uint32_t id = 0; id < count; ++id)
+        {
+            if(a_Registry.IsRegistered(id))
+            {
+                m_Blocking[id] = a_Registry.GetVoxelInfo(id).opacity != 0 ? 1 : 0;
+            }
+        }
+    }
+
+    void HeightmapStore::AddChunk(IChunkStore& a_ChunkStore, IChunk& a_Chunk, std::vector<HeightChange>& a_Changes)
+    {
+        const auto coordinates = a_Chunk.GetChunkCoordinates();
+        const auto inserted = m_Columns.emplace(GetKey(coordinates.x, coordinates.z), Column());
+        auto& column = inserted.first->second;
+        if(inserted.second)
+        {
+            std::fill(std::begin(column.heights), std::end(column.heights), NO_HEIGHT);
+            column.minChunk = coordinates.y;
+            column.maxChunk = coordinates.y;
+            column.chunkCount = 0;
+        }
+
+        column.minChunk = std::min(column.minChunk, coordinates.y);
+        column.maxChunk = std::max(column.maxChunk, coordinates.y);
+        ++column.chunkCount;
+
+        UpdateChunk(a_ChunkStore, a_Chunk, a_Changes);
+    }
+
+    void HeightmapStore::RemoveChunk(const glm::ivec3& a_Coordinates)
+    {
+        //The heights stay valid, as the voxels of the chunk do not change while it is not loaded.
+        const auto found = m_Columns.find(GetKey(a_Coordinates.x, a_Coordinates.z));
+        if(found != m_Columns.end() && --found->second.chunkCount == 0)
+        {
+            m_Columns.erase(found);
+        }
+    }
+
+    void HeightmapStore::UpdateChunk(IChunkStore& a_ChunkStore, IChunk& a_Chunk, std::vector<HeightChange>& a_Changes)
+    {
+        const auto coordinates = a_Chunk.GetChunkCoordinates();
+        const auto found = m_Columns.find(GetKey(coordinates.x, coordinates.z));
+        if(found == m_Columns.end())
+        {
+            return;
+        }
+
+        auto& column = found->second;
+        const auto bottom = coordinates.y * CHUNK_SIZE;
+        const auto top = bottom + CHUNK_SIZE - 1;
+        for(std::uint32_t z = 0; z < CHUNK_SIZE; ++z)
+        {
+            for(std::uint32_t x = 0; x < CHUNK_SIZE; ++x)
+            {
+                const auto height = column.heights[GetColumnIndex(x, z)];
+
+                //A voxel above the chunk covers it, whatever the chunk contains.
+                if(height > top)
+                {
+                    continue;
+                }
+
+                const auto worldX = coordinates.x * CHUNK_SIZE + static_cast<std::int32_t>(x);
+                const auto worldZ = coordinates.z * CHUNK_SIZE + static_cast<std::int32_t>(z);
+                const auto highest = FindHighest(a_Chunk, x, z, CHUNK_SIZE - 1);
+                const auto newHeight = highest < 0 ? NO_HEIGHT : bottom + highest;
+                if(newHeight > height)
+                {
+                    SetHeight(column, worldX, worldZ, newHeight, a_Changes);
+                }
+                else if(newHeight < height && height >= bottom)
+                {
+                    //The highest voxel of the column was in this chunk. Without another one in the chunk, it continues below.
+                    SetHeight(column, worldX, worldZ, highest < 0 ? SearchDown(a_ChunkStore, column, worldX, worldZ, bottom - 1) : newHeight, a_Changes);
+                }
+            }
+        }
+    }
+
+    void HeightmapStore::UpdateVoxel(IChunkStore& a_ChunkStore, const glm::ivec3& a_Position, std::vector<HeightChange>& a_Changes)
+    {
+        glm::ivec3 coordinates;
+        std::uint32_t index;
+        VoxelToChunk(a_Position, coordinates, index);
+
+        const auto found = m_Columns.find(GetKey(coordinates.x, coordinates.z));
+        const auto* chunk = a_ChunkStore.GetChunk(coordinates);
+        if(found == m_Columns.end() || chunk == nullptr)
+        {
+            return;
+        }
+
+        auto& column = found->second;
+        const auto local = GetVoxelCoordinates(index);
+        const auto height = column.heights[GetColumnIndex(local.x, local.z)];
+        const auto blocking = BlocksLight(chunk->GetVoxel(index).id);
+
+        //Placing a voxel above the column, or removing its highest voxel, are the only changes that move the height.
+        if(blocking && a_Position.y > height)
+        {
+            SetHeight(column, a_Position.x, a_Position.z, a_Position.y, a_Changes);
+        }
+        else if(!blocking && a_Position.y == height)
+        {
+            SetHeight(column, a_Position.x, a_Position.z, SearchDown(a_ChunkStore, column, a_Position.x, a_Position.z, a_Position.y - 1), a_Changes);
+        }
+    }
+
+    std::int32_t HeightmapStore::GetHeight(std::int32_t a_X, std::int32_t a_Z) const
+    {
+        const auto chunkX = FloorDivide(a_X);
+        const auto chunkZ = FloorDivide(a_Z);
+        const auto* column = GetColumn(chunkX, chunkZ);
+        if(column == nullptr)
+        {
+            return NO_HEIGHT;
+        }
+        return column->heights[GetColumnIndex(a_X - chunkX * CHUNK_SIZE, a_Z - chunkZ * CHUNK_SIZE)];
+    }
+
+    const HeightmapStore::Column* HeightmapStore::GetColumn(std::int32_t a_ChunkX, std::int32_t a_ChunkZ) const
+    {
+        const auto found = m_Columns.find(GetKey(a_ChunkX, a_ChunkZ));
+        return found == m_Columns.end() ? nullptr : &found->second;
+    }
+
+    std::uint64_t HeightmapStore::GetKey(std::int32_t a_ChunkX, std::int32_t a_ChunkZ)
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(a_ChunkX)) << 32) | static_cast<std::uint32_t>(a_ChunkZ);
+    }
+
+    std::int32_t HeightmapStore::FindHighest(const IChunk& a_Chunk, std::uint32_t a_X, std::uint32_t a_Z, std::int32_t a_Top) const
+    {
+        //Uniform chunks are the common case for air and solid ground.
+        if(a_Chunk.GetStorage() == ChunkStorage::UNIFORM)
+        {
+            return BlocksLight(a_Chunk.GetVoxel(0).id) ? a_Top : -1;
+        }
+
+        for(auto y = a_Top; y >= 0; --y)
+        {
+            if(BlocksLight(a_Chunk.GetVoxel(GetVoxelIndex(glm::uvec3(a_X, y, a_Z))).id))
+            {
+                return y;
+            }
+        }
+        return -1;
+    }
+
+    std::int32_t HeightmapStore::SearchDown(IChunkStore& a_ChunkStore, const Column& a_Column, std::int32_t a_X, std::int32_t a_Z, std::int32_t a_Top) const
+    {
+        const auto chunkX = FloorDivide(a_X);
+        const auto chunkZ = FloorDivide(a_Z);
+        const auto x = static_cast<std::uint32_t>(a_X - chunkX * CHUNK_SIZE);
+        const auto z = static_cast<std::uint32_t>(a_Z - chunkZ * CHUNK_SIZE);
+
+        //Chunks that are not loaded are skipped, they are taken into account when they are added.
+        for(auto chunkY = std::min(FloorDivide(a_Top), a_Column.maxChunk); chunkY >= a_Column.minChunk; --chunkY)
+        {
+            const auto* chunk = a_ChunkStore.GetChunk(glm::ivec3(chunkX, chunkY, chunkZ));
+            if(chunk == nullptr)
+            {
+                continue;
+            }
+
+            const auto top = std::min(a_Top - chunkY * CHUNK_SIZE, CHUNK_SIZE - 1);
+            const auto highest = FindHighest(*chunk, x, z, top);
+            if(highest >= 0)
+            {
+                return chunkY * CHUNK_SIZE + highest;
+            }
+        }
+        return NO_HEIGHT;
+    }
+
+    void HeightmapStore::SetHeight(Column& a_Column, std::int32_t a_X, std::int32_t a_Z, std::int32_t a_Height, std::vector<HeightChange>& a_Changes)
+    {
+        auto& height = a_Column.heights[GetColumnIndex(a_X - FloorDivide(a_X) * CHUNK_SIZE, a_Z - FloorDivide(a_Z) * CHUNK_SIZE)];
+        if(height == a_Height)
+        {
+            return;
+        }
+
+        //Voxels above the lower and up to the higher height switch between direct sky light and none. Only the loaded chunks matter.
+        const auto low = std::min(height, a_Height);
+        const auto high = std::max(height, a_Height);
+        height = a_Height;
+
+        const auto minY = low == NO_HEIGHT ? a_Column.minChunk * CHUNK_SIZE : std::max(low + 1, a_Column.minChunk * CHUNK_SIZE);
+        const auto maxY = std::min(high, a_Column.maxChunk * CHUNK_SIZE + CHUNK_SIZE - 1);
+        if(minY <= maxY)
+        {
+            a_Changes.push_back(HeightChange{ a_X, a_Z, minY, maxY });
+        }
+    }
+}
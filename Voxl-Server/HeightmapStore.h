@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include <Utility.h>
+
+namespace voxl
+{
+    class IChunk;
+    class IChunkStore;
+    class VoxelRegistry;
+
+    /*
+     * A range of voxels in a single column whose direct sky light changed because the height of the column changed.
+     */
+    struct HeightChange
+    {
+        std::int32_t x;
+        std::int32_t z;
+        std::int32_t minY;
+        std::int32_t maxY;
+    };
+
+    /*
+     * Keeps, for every column of voxels in the loaded chunks, the height of the highest voxel that blocks or dims light.
+     * Everything above that height receives full sky light without having to flood light down through the empty chunks above.
+     *
+     * Only loaded chunks are taken into account, and a column without any light blocking voxel in them has height NO_HEIGHT.
+     * Heights are updated in constant time for most voxel changes. Only removing the highest voxel of a column searches down for the next one.
+     * Only used from the tick thread, but may be read from other threads while it is not changed.
+     */
+    class HeightmapStore
+    {
+    public:
+        //Height of a column that has no light blocking voxel in its loaded chunks.
+        static constexpr std::int32_t NO_HEIGHT = std::numeric_limits<std::int32_t>::min();
+
+        /*
+         * The heights of all voxel columns in a column of chunks, indexed with GetColumnIndex.
+         */
+        struct Column
+        {
+            std::int32_t heights[CHUNK_SIZE_SQUARED];
+
+            //Lowest and highest chunk y that was loaded in this column, and the amount of chunks loaded now.
+            std::int32_t minChunk;
+            std::int32_t maxChunk;
+            std::uint32_t chunkCount;
+        };
+
+    public:
+        explicit HeightmapStore(VoxelRegistry& a_Registry);
+
+        /*
+         * Add the voxels of a chunk that was added to the chunk store. Changed heights are added to a_Changes.
+         */
+        void AddChunk(IChunkStore& a_ChunkStore, IChunk& a_Chunk, std::vector<HeightChange>& a_Changes);
+
+        /*
+         * Forget a chunk that was removed from the chunk store. Columns are dropped with their last chunk.
+         */
+        void RemoveChunk(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Update the heights after many voxels of a loaded chunk changed at once. Changed heights are added to a_Changes.
+         */
+        void UpdateChunk(IChunkStore& a_ChunkStore, IChunk& a_Chunk, std::vector<HeightChange>& a_Changes);
+
+        /*
+         * Update the height of a column after the voxel at a_Position changed. A changed height is added to a_Changes.
+         */
+        void UpdateVoxel(IChunkStore& a_ChunkStore, const glm::ivec3& a_Position, std::vector<HeightChange>& a_Changes);
+
+        /*
+         * Get the height of the highest light blocking voxel at the given world x and z, or NO_HEIGHT.
+         */
+        std::int32_t GetHeight(std::int32_t a_X, std::int32_t a_Z) const;
+
+        /*
+         * Get the heights of a column of chunks, or nullptr when none of its chunks are loaded.
+         */
+        const Column* GetColumn(std::int32_t a_ChunkX, std::int32_t a_ChunkZ) const;
+
+        /*
+         * Returns true when voxels of the given type block or dim light, so that light below them is not direct sky light.
+         */
+        bool BlocksLight(std::uint16_t a_Id) const
+        {
+            return a_Id >= m_Blocking.size() || m_Blocking[a_Id] != 0;
+        }
+
+        /*
+         * Convert x and z local to a chunk into an index into Column::heights. Matches the layout of GetVoxelIndex.
+         */
+        static constexpr std::uint32_t GetColumnIndex(std::uint32_t a_X, std::uint32_t a_Z)
+        {
+            return a_Z * CHUNK_SIZE + a_X;
+        }
+
+    private:
+        static std::uint64_t GetKey(std::int32_t a_ChunkX, std::int32_t a_ChunkZ);
+
+        /*
+         * Get the highest light blocking voxel at or below local y a_Top in a chunk, or -1 when there is none.
+         */
+        std::int32_t FindHighest(const IChunk& a_Chunk, std::uint32_t a_X, std::uint32_t a_Z, std::int32_t a_Top) const;
+
+        /*
+         * Search down from world y a_Top through the loaded chunks of a column for the highest light blocking voxel.
+         */
+        std::int32_t SearchDown(IChunkStore& a_ChunkStore, const Column& a_Column, std::int32_t a_X, std::int32_t a_Z, std::int32_t a_Top) const;
+
+        /*
+         * Set the height of a voxel column, and report the voxels of the loaded chunks whose direct sky light changed.
+         */
+        static void SetHeight(Column& a_Column, std::int32_t a_X, std::int32_t a_Z, std::int32_t a_Height, std::vector<HeightChange>& a_Changes);
+
+    private:
+        //Per voxel type, whether it blocks or dims light.
+        std::vector<std::uint8_t> m_Blocking;
+
+        std::unordered_map<std::uint64_t, Column> m_Columns;
+    };
+}
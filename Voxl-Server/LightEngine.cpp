@@ -0,0 +1,684 @@
+#include "LightEngine.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <IChunk.h>
+#include <IChunkStore.h>
+#include <Utility.h>
+#include <VoxelRegistry.h>
+#include <threads/ThreadPool.h>
+
+namespace voxl
+{
+    namespace
+    {
+        const glm::ivec3 DIRECTIONS[6] =
+        {
+            { 1, 0, 0 }, { -1, 0, 0 },
+            { 0, 1, 0 }, { 0, -1, 0 },
+            { 0, 0, 1 }, { 0, 0, -1 }
+        };
+
+        /*
+         * Union-find with path halving, used to join changes into groups.
+         */
+        std::size_t FindRoot(std::vector<std::size_t>& a_Parents, std::size_t a_Index)
+        {
+            while(a_Parents[a_Index] != a_Index)
+            {
+                a_Parents[a_Index] = a_Parents[a_Parents[a_Index]];
+                a_Index = a_Parents[a_Index];
+            }
+            return a_Index;
+        }
+    }
+
+    LightEngine::LightEngine(VoxelRegistry& a_Registry, utilities::ThreadPool* a_ThreadPool) : m_ThreadPool(a_ThreadPool), m_GroupCount(0), m_LightUpdateCount(0)
+    {
+        //Copy what is needed from the registry into small tables, which are read for every voxel visited.
+        const auto count = a_Registry.GetMaximumEntries();
+        m_Emission.assign(count, 0);
+        m_Opacity.assign(count, MAX_LIGHT);
+        for(std::uint32_t id = 0; id < count; ++id)
+        {
+            if(!a_Registry.IsRegistered(id))
+            {
+                continue;
+            }
+
+            //Emissive light is defined from 0 to 255. Any light at all emits at least level 1.
+            const auto& info = a_Registry.GetVoxelInfo(id);
+            m_Emission[id] = static_cast<std::uint8_t>((info.emissiveLight * MAX_LIGHT + 254) / 255);
+            m_Opacity[id] = static_cast<std::uint8_t>(std::clamp<int>(info.opacity, 1, MAX_LIGHT));
+        }
+    }
+
+    void LightEngine::QueueVoxel(const glm::ivec3& a_Position)
+    {
+        m_Voxels.push_back(a_Position);
+    }
+
+    void LightEngine::QueueChunk(const glm::ivec3& a_Coordinates)
+    {
+        m_Chunks.push_back(a_Coordinates);
+    }
+
+    void LightEngine::QueueHeightChange(const HeightChange& a_Change)
+    {
+        m_HeightChanges.push_back(a_Change);
+    }
+
+    void LightEngine::Update(IChunkStore& a_ChunkStore, const HeightmapStore& a_Heightmaps)
+    {
+        m_LightUpdateCount = 0;
+        m_RelitVoxels.clear();
+        m_RelitChunks.clear();
+        if(m_Voxels.empty() && m_Chunks.empty() && m_HeightChanges.empty())
+        {
+            return;
+        }
+
+        SplitHeightChanges();
+        CreateGroups();
+
+        //Chunks are looked up here, so the workers never touch the chunk store.
+        for(std::size_t i = 0; i < m_GroupCount; ++i)
+        {
+            auto& group = m_Groups[i];
+            group.slots.resize(static_cast<std::size_t>(group.size.x) * group.size.y * group.size.z);
+            auto slot = group.slots.begin();
+            for(int x = 0; x < group.size.x; ++x)
+            {
+                for(int y = 0; y < group.size.y; ++y)
+                {
+                    for(int z = 0; z < group.size.z; ++z)
+                    {
+                        *slot++ = a_ChunkStore.GetChunk(group.min + glm::ivec3(x, y, z));
+                    }
+                }
+            }
+
+            group.columns.resize(static_cast<std::size_t>(group.size.x) * group.size.z);
+            auto column = group.columns.begin();
+            for(int x = 0; x < group.size.x; ++x)
+            {
+                for(int z = 0; z < group.size.z; ++z)
+                {
+                    *column++ = a_Heightmaps.GetColumn(group.min.x + x, group.min.z + z);
+                }
+            }
+        }
+
+        const std::size_t threads = m_ThreadPool == nullptr ? 0 : m_ThreadPool->numThreads();
+        if(m_Relighters.size() < threads + 1)
+        {
+            m_Relighters.resize(threads + 1);
+        }
+
+        if(threads == 0 || m_GroupCount < 2 || m_Voxels.size() + m_Heights.size() * CHUNK_SIZE + m_Chunks.size() * CHUNK_SIZE_SQUARED < PARALLEL_THRESHOLD)
+        {
+            for(std::size_t i = 0; i < m_GroupCount; ++i)
+            {
+                RelightGroup(m_Groups[i], m_Relighters[0]);
+            }
+        }
+        else
+        {
+            //The calling thread works along, so every thread of the pool and the calling thread get a relighter of their own.
+            m_ThreadPool->parallelFor(m_GroupCount, [this](std::size_t a_Group, std::size_t a_Worker)
+            {
+                RelightGroup(m_Groups[a_Group], m_Relighters[a_Worker]);
+            });
+        }
+
+        for(std::size_t i = 0; i < m_GroupCount; ++i)
+        {
+            m_LightUpdateCount += m_Groups[i].lightUpdates;
+            m_RelitVoxels.insert(m_RelitVoxels.end(), m_Groups[i].relitVoxels.begin(), m_Groups[i].relitVoxels.end());
+            m_RelitChunks.insert(m_RelitChunks.end(), m_Groups[i].relitChunks.begin(), m_Groups[i].relitChunks.end());
+            m_Groups[i].relitVoxels.clear();
+            m_Groups[i].relitChunks.clear();
+            m_Groups[i].voxels.clear();
+            m_Groups[i].heights.clear();
+            m_Groups[i].chunks.clear();
+        }
+        m_GroupCount = 0;
+        m_Voxels.clear();
+        m_Heights.clear();
+        m_Chunks.clear();
+    }
+
+    std::size_t LightEngine::GetLightUpdateCount() const
+    {
+        return m_LightUpdateCount;
+    }
+
+    const std::vector<VoxelChange>& LightEngine::GetRelitVoxels() const
+    {
+        return m_RelitVoxels;
+    }
+
+    const std::vector<glm::ivec3>& LightEngine::GetRelitChunks() const
+    {
+        return m_RelitChunks;
+    }
+
+    void LightEngine::SplitHeightChanges()
+    {
+        //Split the changed columns at chunk borders, so that every part belongs to a single chunk.
+        std::unordered_map<std::uint64_t, std::uint32_t> counts;
+        for(const auto& change : m_HeightChanges)
+        {
+            auto y = change.minY;
+            while(y <= change.maxY)
+            {
+                glm::ivec3 coordinates;
+                std::uint32_t index;
+                VoxelToChunk(glm::ivec3(change.x, y, change.z), coordinates, index);
+
+                const auto top = std::min(change.maxY, coordinates.y * CHUNK_SIZE + CHUNK_SIZE - 1);
+                m_Heights.push_back(HeightChange{ change.x, change.z, y, top });
+                counts[PackChunkCoordinates(coordinates)] += static_cast<std::uint32_t>(top - y + 1);
+                y = top + 1;
+            }
+        }
+        m_HeightChanges.clear();
+
+        //Chunks where a large part of the voxels changed are cheaper to relight as a whole.
+        std::size_t kept = 0;
+        for(const auto& part : m_Heights)
+        {
+            glm::ivec3 coordinates;
+            std::uint32_t index;
+            VoxelToChunk(glm::ivec3(part.x, part.minY, part.z), coordinates, index);
+
+            auto& count = counts[PackChunkCoordinates(coordinates)];
+            if(count * 4 < CHUNK_SIZE_CUBED)
+            {
+                m_Heights[kept++] = part;
+            }
+            else if(count != ~std::uint32_t(0))
+            {
+                m_Chunks.push_back(coordinates);
+                count = ~std::uint32_t(0);
+            }
+        }
+        m_Heights.resize(kept);
+    }
+
+    void LightEngine::CreateGroups()
+    {
+        //The chunks that have changes, in the order they were first queued.
+        std::unordered_map<std::uint64_t, std::size_t> indices;
+        std::vector<glm::ivec3> chunks;
+        const auto getIndex = [&](const glm::ivec3& a_Coordinates)
+        {
+            const auto inserted = indices.emplace(PackChunkCoordinates(a_Coordinates), chunks.size());
+            if(inserted.second)
+            {
+                chunks.push_back(a_Coordinates);
+            }
+            return inserted.first->second;
+        };
+
+        std::vector<std::size_t> voxelChunks(m_Voxels.size());
+        for(std::size_t i = 0; i < m_Voxels.size(); ++i)
+        {
+            glm::ivec3 coordinates;
+            std::uint32_t index;
+            VoxelToChunk(m_Voxels[i], coordinates, index);
+            voxelChunks[i] = getIndex(coordinates);
+        }
+        std::vector<std::size_t> heightChunks(m_Heights.size());
+        for(std::size_t i = 0; i < m_Heights.size(); ++i)
+        {
+            glm::ivec3 coordinates;
+            std::uint32_t index;
+            VoxelToChunk(glm::ivec3(m_Heights[i].x, m_Heights[i].minY, m_Heights[i].z), coordinates, index);
+            heightChunks[i] = getIndex(coordinates);
+        }
+        for(const auto& coordinates : m_Chunks)
+        {
+            getIndex(coordinates);
+        }
+
+        //Join chunks whose reach overlaps. Chunks are hashed into cells as large as that distance, so only neighbouring cells have to be compared.
+        constexpr int distance = 2 * REACH;
+        std::vector<std::size_t> parents(chunks.size());
+        std::unordered_map<std::uint64_t, std::vector<std::size_t>> cells;
+        for(std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            parents[i] = i;
+            const auto cell = glm::ivec3(glm::floor(glm::vec3(chunks[i]) / static_cast<float>(distance + 1)));
+            for(int x = -1; x <= 1; ++x)
+            {
+                for(int y = -1; y <= 1; ++y)
+                {
+                    for(int z = -1; z <= 1; ++z)
+                    {
+                        const auto found = cells.find(PackChunkCoordinates(cell + glm::ivec3(x, y, z)));
+                        if(found == cells.end())
+                        {
+                            continue;
+                        }
+
+                        for(const auto other : found->second)
+                        {
+                            const auto offset = glm::abs(chunks[i] - chunks[other]);
+                            if(std::max(offset.x, std::max(offset.y, offset.z)) <= distance)
+                            {
+                                parents[FindRoot(parents, i)] = FindRoot(parents, other);
+                            }
+                        }
+                    }
+                }
+            }
+            cells[PackChunkCoordinates(cell)].push_back(i);
+        }
+
+        //One group per root, reusing the memory of earlier updates.
+        std::vector<std::size_t> groups(chunks.size(), ~std::size_t(0));
+        std::vector<glm::ivec3> maxima;
+        for(std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            const auto root = FindRoot(parents, i);
+            if(groups[root] == ~std::size_t(0))
+            {
+                if(m_GroupCount == m_Groups.size())
+                {
+                    m_Groups.emplace_back();
+                }
+                groups[root] = m_GroupCount++;
+                m_Groups[groups[root]].min = chunks[i];
+                maxima.push_back(chunks[i]);
+            }
+
+            const auto group = groups[root];
+            m_Groups[group].min = glm::min(m_Groups[group].min, chunks[i]);
+            maxima[group] = glm::max(maxima[group], chunks[i]);
+            groups[i] = group;
+        }
+
+        for(std::size_t i = 0; i < m_GroupCount; ++i)
+        {
+            m_Groups[i].min -= glm::ivec3(REACH);
+            m_Groups[i].size = maxima[i] + glm::ivec3(REACH) - m_Groups[i].min + glm::ivec3(1);
+            m_Groups[i].lightUpdates = 0;
+        }
+
+        for(std::size_t i = 0; i < m_Voxels.size(); ++i)
+        {
+            m_Groups[groups[voxelChunks[i]]].voxels.push_back(m_Voxels[i]);
+        }
+        for(std::size_t i = 0; i < m_Heights.size(); ++i)
+        {
+            m_Groups[groups[heightChunks[i]]].heights.push_back(m_Heights[i]);
+        }
+        for(const auto& coordinates : m_Chunks)
+        {
+            m_Groups[groups[indices[PackChunkCoordinates(coordinates)]]].chunks.push_back(coordinates);
+        }
+    }
+
+    void LightEngine::RelightGroup(Group& a_Group, Relighter& a_Relighter)
+    {
+        a_Relighter.voxels.assign(a_Group.slots.size(), nullptr);
+        a_Relighter.copySlots.clear();
+        a_Relighter.originals.assign(a_Group.slots.size(), nullptr);
+        a_Relighter.writtenSlots.clear();
+
+        //Both channels spread through the same voxels, so they share the unpacked chunks.
+        const auto updates = RelightChannel<BLOCK_SHIFT>(a_Group, a_Relighter) + RelightChannel<SKY_SHIFT>(a_Group, a_Relighter);
+        StoreRelit(a_Group, a_Relighter);
+
+        a_Group.lightUpdates = updates;
+    }
+
+    void LightEngine::StoreRelit(Group& a_Group, Relighter& a_Relighter)
+    {
+        //The inverse of GetSlot.
+        const auto getChunk = [&a_Group](std::size_t a_Slot)
+        {
+            const auto slot = static_cast<std::int32_t>(a_Slot);
+            return a_Group.min + glm::ivec3(slot / (a_Group.size.y * a_Group.size.z), (slot / a_Group.size.z) % a_Group.size.y, slot % a_Group.size.z);
+        };
+
+        auto& changed = a_Relighter.changed;
+        for(const auto slot : a_Relighter.writtenSlots)
+        {
+            const auto* voxels = a_Relighter.voxels[slot];
+            const auto* original = a_Relighter.originals[slot];
+            changed.clear();
+            for(std::uint32_t index = 0; index < CHUNK_SIZE_CUBED; ++index)
+            {
+                if(voxels[index].lightLevel != original[index])
+                {
+                    changed.push_back(static_cast<std::uint16_t>(index));
+                }
+            }
+            if(changed.empty())
+            {
+                continue;
+            }
+
+            //Chunks stored as flat arrays were changed in place, the others get their copy back.
+            auto* chunk = a_Group.slots[slot];
+            if(voxels == chunk->GetVoxelData())
+            {
+                chunk->SetDirty(true);
+            }
+            else if(changed.size() * 4 >= CHUNK_SIZE_CUBED)
+            {
+                chunk->SetVoxels(voxels);
+            }
+            else
+            {
+                for(const auto index : changed)
+                {
+                    chunk->SetVoxel(index, voxels[index]);
+                }
+            }
+
+            const auto coordinates = getChunk(slot);
+            if(changed.size() > MAX_RELIT_VOXELS)
+            {
+                a_Group.relitChunks.push_back(coordinates);
+                continue;
+            }
+            for(const auto index : changed)
+            {
+                const auto position = coordinates * CHUNK_SIZE + glm::ivec3(GetVoxelCoordinates(index));
+                a_Group.relitVoxels.push_back({ position, voxels[index] });
+            }
+        }
+    }
+
+    template<std::uint32_t SHIFT>
+    std::size_t LightEngine::RelightChannel(const Group& a_Group, Relighter& a_Relighter) const
+    {
+        auto& remove = a_Relighter.remove;
+        auto& add = a_Relighter.add;
+        remove.clear();
+        add.clear();
+
+        std::size_t updates = 0;
+        const auto origin = a_Group.min * CHUNK_SIZE;
+
+        //Clear the light of a voxel and start spreading from it again if it is a source now.
+        const auto seed = [&](const glm::ivec3& a_Position, VoxelData& a_Voxel)
+        {
+            const auto level = GetLight<SHIFT>(a_Voxel);
+            if(level != 0)
+            {
+                SetLight<SHIFT>(a_Voxel, 0);
+                remove.push_back({ a_Position, level });
+            }
+
+            const auto source = GetSource<SHIFT>(a_Group, a_Voxel, a_Position);
+            if(source != 0)
+            {
+                SetLight<SHIFT>(a_Voxel, source);
+                add.push_back(a_Position);
+            }
+        };
+
+        for(const auto& position : a_Group.voxels)
+        {
+            const auto local = position - origin;
+            auto* voxel = GetVoxel(a_Group, a_Relighter, local, true);
+            if(voxel == nullptr)
+            {
+                continue;
+            }
+            seed(local, *voxel);
+
+            //The voxel may let through more light than before, so its lit neighbours spread into it again.
+            for(const auto& direction : DIRECTIONS)
+            {
+                const auto* neighbour = GetVoxel(a_Group, a_Relighter, local + direction, false);
+                if(neighbour != nullptr && GetLight<SHIFT>(*neighbour) > 1)
+                {
+                    add.push_back(local + direction);
+                }
+            }
+        }
+
+        //Voxels that gained or lost direct sky light. Only the sky changes for them, and only if their light does not match already.
+        if(SHIFT == SKY_SHIFT)
+        {
+            for(const auto& change : a_Group.heights)
+            {
+                for(auto y = change.minY; y <= change.maxY; ++y)
+                {
+                    const auto local = glm::ivec3(change.x, y, change.z) - origin;
+                    auto* voxel = GetVoxel(a_Group, a_Relighter, local, false);
+                    if(voxel == nullptr || GetLight<SHIFT>(*voxel) == GetSource<SHIFT>(a_Group, *voxel, local))
+                    {
+                        continue;
+                    }
+                    seed(local, *GetVoxel(a_Group, a_Relighter, local, true));
+                }
+            }
+        }
+
+        //Clear all light in relit chunks. The light they gave to their neighbours is removed starting at the voxels just outside.
+        for(const auto& coordinates : a_Group.chunks)
+        {
+            const auto base = (coordinates - a_Group.min) * CHUNK_SIZE;
+            const auto slot = GetSlot(a_Group, base);
+            auto* voxels = GetSlotVoxels(a_Group, a_Relighter, slot);
+            if(voxels == nullptr)
+            {
+                continue;
+            }
+            MarkWritten(a_Relighter, slot);
+
+            for(std::uint32_t index = 0; index < CHUNK_SIZE_CUBED; ++index)
+            {
+                auto& voxel = voxels[index];
+                const auto position = base + glm::ivec3(GetVoxelCoordinates(index));
+                const auto source = GetSource<SHIFT>(a_Group, voxel, position);
+                SetLight<SHIFT>(voxel, source);
+                if(source != 0)
+                {
+                    add.push_back(position);
+                }
+            }
+
+            for(const auto& direction : DIRECTIONS)
+            {
+                //The layer of voxels just outside the chunk on this side.
+                const auto first = base + glm::max(direction * CHUNK_SIZE, glm::ivec3(-1)) * glm::abs(direction);
+                const auto axisA = direction.x != 0 ? glm::ivec3(0, 1, 0) : glm::ivec3(1, 0, 0);
+                const auto axisB = direction.z != 0 ? glm::ivec3(0, 1, 0) : glm::ivec3(0, 0, 1);
+                for(int a = 0; a < CHUNK_SIZE; ++a)
+                {
+                    for(int b = 0; b < CHUNK_SIZE; ++b)
+                    {
+                        const auto position = first + axisA * a + axisB * b;
+                        const auto* neighbour = GetVoxel(a_Group, a_Relighter, position, false);
+                        if(neighbour != nullptr && GetLight<SHIFT>(*neighbour) != 0)
+                        {
+                            seed(position, *GetVoxel(a_Group, a_Relighter, position, true));
+                        }
+                    }
+                }
+            }
+        }
+
+        //Remove pass. Neighbours that are darker got their light through the removed voxel, brighter ones are lit from elsewhere and spread again.
+        for(std::size_t i = 0; i < remove.size(); ++i)
+        {
+            const auto node = remove[i];
+            for(const auto& direction : DIRECTIONS)
+            {
+                const auto position = node.position + direction;
+                const auto* neighbour = GetVoxel(a_Group, a_Relighter, position, false);
+                if(neighbour == nullptr)
+                {
+                    continue;
+                }
+
+                const auto level = GetLight<SHIFT>(*neighbour);
+                if(level == 0)
+                {
+                    continue;
+                }
+
+                if(level >= node.level)
+                {
+                    add.push_back(position);
+                    continue;
+                }
+
+                auto* voxel = GetVoxel(a_Group, a_Relighter, position, true);
+                SetLight<SHIFT>(*voxel, 0);
+                remove.push_back({ position, level });
+                ++updates;
+
+                const auto source = GetSource<SHIFT>(a_Group, *voxel, position);
+                if(source != 0)
+                {
+                    SetLight<SHIFT>(*voxel, source);
+                    add.push_back(position);
+                }
+            }
+        }
+
+        //Add pass.
+        for(std::size_t i = 0; i < add.size(); ++i)
+        {
+            const auto position = add[i];
+            const auto level = GetLight<SHIFT>(*GetVoxel(a_Group, a_Relighter, position, false));
+            if(level <= 1)
+            {
+                continue;
+            }
+
+            for(const auto& direction : DIRECTIONS)
+            {
+                const auto* neighbour = GetVoxel(a_Group, a_Relighter, position + direction, false);
+                if(neighbour == nullptr)
+                {
+                    continue;
+                }
+
+                const auto opacity = GetOpacity(neighbour->id);
+                if(opacity >= level || GetLight<SHIFT>(*neighbour) >= level - opacity)
+                {
+                    continue;
+                }
+
+                auto* voxel = GetVoxel(a_Group, a_Relighter, position + direction, true);
+                SetLight<SHIFT>(*voxel, static_cast<std::uint8_t>(level - opacity));
+                add.push_back(position + direction);
+                ++updates;
+            }
+        }
+
+        return updates;
+    }
+
+    template<std::uint32_t SHIFT>
+    std::uint8_t LightEngine::GetSource(const Group& a_Group, const VoxelData& a_Voxel, const glm::ivec3& a_Position) const
+    {
+        if(SHIFT == BLOCK_SHIFT)
+        {
+            return GetEmission(a_Voxel.id);
+        }
+
+        //Voxels above the highest light blocking voxel of their column get full sky light.
+        const auto* column = a_Group.columns[static_cast<std::size_t>(a_Position.x / CHUNK_SIZE) * a_Group.size.z + a_Position.z / CHUNK_SIZE];
+        if(column == nullptr)
+        {
+            return 0;
+        }
+        const auto height = column->heights[HeightmapStore::GetColumnIndex(a_Position.x % CHUNK_SIZE, a_Position.z % CHUNK_SIZE)];
+        return a_Group.min.y * CHUNK_SIZE + a_Position.y > height ? MAX_LIGHT : 0;
+    }
+
+    VoxelData* LightEngine::GetSlotVoxels(const Group& a_Group, Relighter& a_Relighter, std::size_t a_Slot)
+    {
+        auto* voxels = a_Relighter.voxels[a_Slot];
+        if(voxels != nullptr)
+        {
+            return voxels;
+        }
+
+        auto* chunk = a_Group.slots[a_Slot];
+        if(chunk == nullptr)
+        {
+            return nullptr;
+        }
+
+        //Uniform and palette chunks are unpacked once, and packed again when the group is done.
+        voxels = chunk->GetVoxelData();
+        if(voxels == nullptr)
+        {
+            const auto copy = a_Relighter.copySlots.size();
+            if(copy == a_Relighter.copies.size())
+            {
+                a_Relighter.copies.push_back(std::make_unique<VoxelData[]>(CHUNK_SIZE_CUBED));
+            }
+            voxels = a_Relighter.copies[copy].get();
+            chunk->GetVoxels(voxels);
+            a_Relighter.copySlots.push_back(a_Slot);
+        }
+
+        a_Relighter.voxels[a_Slot] = voxels;
+        return voxels;
+    }
+
+    void LightEngine::MarkWritten(Relighter& a_Relighter, std::size_t a_Slot)
+    {
+        if(a_Relighter.originals[a_Slot] != nullptr)
+        {
+            return;
+        }
+
+        const auto written = a_Relighter.writtenSlots.size();
+        if(written == a_Relighter.lights.size())
+        {
+            a_Relighter.lights.push_back(std::make_unique<std::uint8_t[]>(CHUNK_SIZE_CUBED));
+        }
+        auto* original = a_Relighter.lights[written].get();
+        const auto* voxels = a_Relighter.voxels[a_Slot];
+        for(std::uint32_t index = 0; index < CHUNK_SIZE_CUBED; ++index)
+        {
+            original[index] = voxels[index].lightLevel;
+        }
+
+        a_Relighter.originals[a_Slot] = original;
+        a_Relighter.writtenSlots.push_back(a_Slot);
+    }
+
+    VoxelData* LightEngine::GetVoxel(const Group& a_Group, Relighter& a_Relighter, const glm::ivec3& a_Position, bool a_Write)
+    {
+        const auto extent = a_Group.size * CHUNK_SIZE;
+        if(a_Position.x < 0 || a_Position.y < 0 || a_Position.z < 0 || a_Position.x >= extent.x || a_Position.y >= extent.y || a_Position.z >= extent.z)
+        {
+            return nullptr;
+        }
+
+        const auto slot = GetSlot(a_Group, a_Position);
+        auto* voxels = GetSlotVoxels(a_Group, a_Relighter, slot);
+        if(voxels == nullptr)
+        {
+            return nullptr;
+        }
+
+        const auto index = GetVoxelIndex(glm::uvec3(a_Position % CHUNK_SIZE));
+        if(a_Write)
+        {
+            MarkWritten(a_Relighter, slot);
+        }
+        return voxels + index;
+    }
+
+    std::size_t LightEngine::GetSlot(const Group& a_Group, const glm::ivec3& a_Position)
+    {
+        const auto chunk = a_Position / CHUNK_SIZE;
+        return (static_cast<std::size_t>(chunk.x) * a_Group.size.y + chunk.y) * a_Group.size.z + chunk.z;
+    }
+}
@@ -0,0 +1,276 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include <IVoxelEditor.h>
+#include <VoxelData.h>
+
+#include "HeightmapStore.h"
+
+namespace utilities
+{
+    class ThreadPool;
+}
+
+namespace voxl
+{
+    class IChunk;
+    class IChunkStore;
+    class VoxelRegistry;
+
+    /*
+     * Computes the block light stored in the low four bits of VoxelData::lightLevel, and the sky light stored in the high four bits.
+     *
+     * Block light spreads from emissive voxels and loses one level per voxel travelled, or the voxel's opacity when that is higher.
+     * Sky light spreads the same way from the voxels above the heightmap of their column, which all get full sky light.
+     * Changes are relit incrementally with two flood fills: a remove pass clears the light that came through the changed voxels,
+     * and an add pass spreads light again from emitters and from the lit voxels bordering the cleared area.
+     *
+     * Changes are collected during a tick and relit together by Update. Light never travels further than MAX_LIGHT voxels,
+     * so a change only affects the chunks within REACH of its own. Changes that are far enough apart form independent groups, which run on the thread pool.
+     * Chunks that are not loaded block light.
+     */
+    class LightEngine
+    {
+    public:
+        //The highest light level. Light levels are stored in four bits.
+        static constexpr std::uint8_t MAX_LIGHT = 15;
+
+        //Clearing and spreading light again from a change reaches at most 2 * MAX_LIGHT + 1 voxels, which is never more than this many chunks away.
+        static constexpr std::int32_t REACH = 2;
+
+        //Below this amount of queued changes, handing groups to other threads costs more than it saves.
+        static constexpr std::size_t PARALLEL_THRESHOLD = 64;
+
+        //Chunks where the light of more voxels changed are reported as relit as a whole. Sending such a chunk again is smaller than that many voxel updates.
+        static constexpr std::uint32_t MAX_RELIT_VOXELS = 64;
+
+    public:
+        /*
+         * Create a light engine for the voxel types in a_Registry. Without a thread pool all groups are relit on the calling thread.
+         */
+        explicit LightEngine(VoxelRegistry& a_Registry, utilities::ThreadPool* a_ThreadPool = nullptr);
+
+        /*
+         * Queue relighting around a voxel that changed.
+         * The voxel still has to hold its light level from before the change, which VoxelEditor keeps.
+         */
+        void QueueVoxel(const glm::ivec3& a_Position);
+
+        /*
+         * Queue relighting all voxels of a chunk, for chunks that were changed in bulk or whose light is unknown.
+         */
+        void QueueChunk(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Queue relighting voxels that gained or lost direct sky light, as reported by the HeightmapStore.
+         */
+        void QueueHeightChange(const HeightChange& a_Change);
+
+        /*
+         * Relight everything queued since the last update in the chunks of a_ChunkStore, and mark the chunks whose light changed dirty.
+         * a_Heightmaps has to be up to date with the chunks.
+         */
+        void Update(IChunkStore& a_ChunkStore, const HeightmapStore& a_Heightmaps);
+
+        /*
+         * Get the amount of times the light of a voxel was set by the last update.
+         */
+        std::size_t GetLightUpdateCount() const;
+
+        /*
+         * Get the voxels whose light was changed by the last update, with their new data. Only holds the voxels of chunks with few of them.
+         */
+        const std::vector<VoxelChange>& GetRelitVoxels() const;
+
+        /*
+         * Get the chunks in which the light of more than MAX_RELIT_VOXELS voxels was changed by the last update.
+         */
+        const std::vector<glm::ivec3>& GetRelitChunks() const;
+
+        /*
+         * Get the block light of a voxel.
+         */
+        static std::uint8_t GetBlockLight(const VoxelData& a_Data)
+        {
+            return a_Data.lightLevel & 0x0F;
+        }
+
+        /*
+         * Get the sky light of a voxel.
+         */
+        static std::uint8_t GetSkyLight(const VoxelData& a_Data)
+        {
+            return a_Data.lightLevel >> 4;
+        }
+
+        /*
+         * Get the light level emitted by voxels of the given type.
+         */
+        std::uint8_t GetEmission(std::uint16_t a_Id) const
+        {
+            return a_Id < m_Emission.size() ? m_Emission[a_Id] : 0;
+        }
+
+        /*
+         * Get the amount of light lost when entering voxels of the given type, at least 1. Types that are not registered block all light.
+         */
+        std::uint8_t GetOpacity(std::uint16_t a_Id) const
+        {
+            return a_Id < m_Opacity.size() ? m_Opacity[a_Id] : MAX_LIGHT;
+        }
+
+    private:
+        //Position of each channel in VoxelData::lightLevel.
+        static constexpr std::uint32_t BLOCK_SHIFT = 0;
+        static constexpr std::uint32_t SKY_SHIFT = 4;
+
+        /*
+         * Changes that are relit together, and the box of chunks they can reach.
+         */
+        struct Group
+        {
+            glm::ivec3 min;
+            glm::ivec3 size;
+            std::vector<glm::ivec3> voxels;
+            std::vector<HeightChange> heights;
+            std::vector<glm::ivec3> chunks;
+
+            //The chunks in the box, nullptr for chunks that are not loaded.
+            std::vector<IChunk*> slots;
+
+            //The heightmaps of the columns of chunks in the box, by x and z.
+            std::vector<const HeightmapStore::Column*> columns;
+            std::size_t lightUpdates;
+
+            //What the relight changed, collected by the group so that the threads do not share them.
+            std::vector<VoxelChange> relitVoxels;
+            std::vector<glm::ivec3> relitChunks;
+        };
+
+        /*
+         * Memory for relighting a group, one per thread.
+         */
+        struct Relighter
+        {
+            struct Node
+            {
+                glm::ivec3 position;
+                std::uint8_t level;
+            };
+
+            std::vector<Node> remove;
+            std::vector<glm::ivec3> add;
+
+            //Flat voxels per slot of the group, either the chunk's own array or a copy that is written back afterwards.
+            std::vector<VoxelData*> voxels;
+            std::vector<std::unique_ptr<VoxelData[]>> copies;
+            std::vector<std::size_t> copySlots;
+
+            //The light of every voxel of a slot before the group was relit, taken when the slot is first written, by slot.
+            //Relighting often sets a voxel back to the light it had, so only voxels whose light differs are written back and reported.
+            std::vector<std::uint8_t*> originals;
+            std::vector<std::unique_ptr<std::uint8_t[]>> lights;
+            std::vector<std::size_t> writtenSlots;
+
+            //The voxels of a slot whose light changed, by index.
+            std::vector<std::uint16_t> changed;
+        };
+
+        /*
+         * Split the queued height changes into parts within a single chunk. Chunks with many changed voxels are relit as a whole instead.
+         */
+        void SplitHeightChanges();
+
+        /*
+         * Split the queued changes into groups that do not share any chunk.
+         */
+        void CreateGroups();
+
+        /*
+         * Relight all changes in a group.
+         */
+        void RelightGroup(Group& a_Group, Relighter& a_Relighter);
+
+        /*
+         * Hand the voxels whose light changed back to the chunks of a group, and collect them or their chunks as relit.
+         * Copies with few changes are written back voxel by voxel, which keeps the palette of the chunk instead of building it again.
+         */
+        static void StoreRelit(Group& a_Group, Relighter& a_Relighter);
+
+        /*
+         * Relight one channel of a group, and return the amount of times the light of a voxel was set.
+         */
+        template<std::uint32_t SHIFT>
+        std::size_t RelightChannel(const Group& a_Group, Relighter& a_Relighter) const;
+
+        /*
+         * Get the light a voxel emits itself in a channel, at a position local to the first voxel of the group's box.
+         */
+        template<std::uint32_t SHIFT>
+        std::uint8_t GetSource(const Group& a_Group, const VoxelData& a_Voxel, const glm::ivec3& a_Position) const;
+
+        /*
+         * Get the flat voxels of a slot in the group's box, or nullptr when its chunk is not loaded.
+         */
+        static VoxelData* GetSlotVoxels(const Group& a_Group, Relighter& a_Relighter, std::size_t a_Slot);
+
+        /*
+         * Keep the light of a slot's voxels before its first write, so the voxels that changed can be found afterwards.
+         */
+        static void MarkWritten(Relighter& a_Relighter, std::size_t a_Slot);
+
+        /*
+         * Get the slot of the chunk containing a position local to the first voxel of the group's box, which has to be inside the box.
+         */
+        static std::size_t GetSlot(const Group& a_Group, const glm::ivec3& a_Position);
+
+        /*
+         * Get the voxel at a position local to the first voxel of the group's box, or nullptr when it is outside the box or its chunk is not loaded.
+         * With a_Write set, the voxel is written back when the group is done if its light changed.
+         */
+        static VoxelData* GetVoxel(const Group& a_Group, Relighter& a_Relighter, const glm::ivec3& a_Position, bool a_Write);
+
+        /*
+         * Get and set the light of a voxel in one channel.
+         */
+        template<std::uint32_t SHIFT>
+        static std::uint8_t GetLight(const VoxelData& a_Voxel)
+        {
+            return (a_Voxel.lightLevel >> SHIFT) & 0x0F;
+        }
+
+        template<std::uint32_t SHIFT>
+        static void SetLight(VoxelData& a_Voxel, std::uint8_t a_Level)
+        {
+            a_Voxel.lightLevel = static_cast<std::uint8_t>((a_Voxel.lightLevel & ~(0x0F << SHIFT)) | (a_Level << SHIFT));
+        }
+
+    private:
+        utilities::ThreadPool* m_ThreadPool;
+
+        //Light emitted by and lost in every voxel type, indexed by id.
+        std::vector<std::uint8_t> m_Emission;
+        std::vector<std::uint8_t> m_Opacity;
+
+        //Changes queued since the last update, and the height changes split per chunk.
+        std::vector<glm::ivec3> m_Voxels;
+        std::vector<HeightChange> m_HeightChanges;
+        std::vector<HeightChange> m_Heights;
+        std::vector<glm::ivec3> m_Chunks;
+
+        std::vector<Group> m_Groups;
+        std::size_t m_GroupCount;
+
+        //One relighter for the calling thread and one for every thread in the pool.
+        std::vector<Relighter> m_Relighters;
+
+        std::size_t m_LightUpdateCount;
+        std::vector<VoxelChange> m_RelitVoxels;
+        std::vector<glm::ivec3> m_RelitChunks;
+    };
+}
@@ -1,10 +1,98 @@
 #include "time/GameLoop.h"
 #include "Server.h"
+#include <atomic>
 #include <chrono>
+#include <csignal>
 #include <IClientConnection.h>;
+#include <Utility.h>
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+#include <threads/ThreadPool.h>
 
-int main()
+#include "DefaultWorldGenerator.h"
+#include "Pregenerator.h"
+
+namespace
 {
+    //Set when Ctrl+C is pressed during pregeneration.
+    std::atomic<bool> g_StopPregeneration(false);
+
+    /*
+     * Pregenerate chunks of a world without starting the server.
+     * Arguments: pregenerate <world> <x> <z> <radius> [minY] [maxY]
+     * x and z are voxel coordinates of the center, the radius and the chunk y range are in chunks.
+     */
+    int Pregenerate(int argc, char** argv)
+    {
+        if(argc < 6)
+        {
+            std::cout << "Usage: pregenerate <world> <x> <z> <radius> [minY] [maxY]" << std::endl;
+            return 1;
+        }
+
+        voxl::PregenerationArea area;
+        glm::ivec3 center;
+        try
+        {
+            std::uint32_t index;
+            voxl::VoxelToChunk(glm::ivec3(std::stoi(argv[3]), 0, std::stoi(argv[4])), center, index);
+            area.center = glm::ivec2(center.x, center.z);
+            area.radius = std::stoi(argv[5]);
+            if(argc > 6)
+            {
+                area.minY = std::stoi(argv[6]);
+            }
+            if(argc > 7)
+            {
+                area.maxY = std::stoi(argv[7]);
+            }
+        }
+        catch(const std::exception&)
+        {
+            std::cout << "Coordinates, radius and chunk heights have to be whole numbers." << std::endl;
+            return 1;
+        }
+
+        utilities::Logger logger("logs/Pregenerate-" + std::string(argv[2]) + ".txt");
+        logger.setConsoleLogging(true);
+        utilities::ServiceLocator<utilities::Logger>::setService(&logger);
+
+        //Same generators the server registers, set up the way the world was created.
+        const auto getGenerator = [](const voxl::WorldSettings& a_Settings) -> std::shared_ptr<voxl::IWorldGenerator>
+        {
+            if(a_Settings.generator != "default")
+            {
+                return nullptr;
+            }
+
+            voxl::DefaultGeneratorSettings settings;
+            if(a_Settings.climateSpacing != 0)
+            {
+                settings.climateSpacing = a_Settings.climateSpacing;
+            }
+            return std::make_shared<voxl::DefaultWorldGenerator>(settings);
+        };
+
+        //Nothing else runs, so use every core.
+        utilities::ThreadPool threadPool(std::max(1u, std::thread::hardware_concurrency()));
+
+        std::signal(SIGINT, [](int)
+        {
+            g_StopPregeneration = true;
+        });
+
+        voxl::Pregenerator pregenerator(argv[2], area);
+        return pregenerator.Run(getGenerator, threadPool, g_StopPregeneration) ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc > 1 && std::string(argv[1]) == "pregenerate")
+    {
+        return Pregenerate(argc, argv);
+    }
+
     std::unique_ptr<voxl::Server> server = std::make_unique<voxl::Server>();
 
     //Start the server on another thread.
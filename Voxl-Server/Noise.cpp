@@ -0,0 +1,505 @@
+#include "Noise.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <Utility.h>
+
+/*
+ * The noise functions below are written once against an "Ops" type that provides the arithmetic, and instantiated for plain floats, SSE4.1 and AVX2.
+ * Every kernel performs exactly the same IEEE operations in the same order, which is what makes their results bit-identical.
+ * That only holds as long as the compiler does not contract multiplies and adds into FMA instructions, so this file must not be built with /arch:AVX2 or /fp:fast.
+ * MSVC accepts AVX2 intrinsics without /arch:AVX2, and they are only executed after GetFastestKernel confirmed support.
+ */
+namespace voxl
+{
+    namespace
+    {
+        constexpr float F2 = 0.36602540378f;    //(sqrt(3) - 1) / 2
+        constexpr float G2 = 0.21132486540f;    //(3 - sqrt(3)) / 6
+        constexpr float F3 = 1.0f / 3.0f;
+        constexpr float G3 = 1.0f / 6.0f;
+
+        //Bring the result of each dimension roughly into the range -1 to 1.
+        constexpr float SCALE_2D = 45.0f;
+        constexpr float SCALE_3D = 32.0f;
+
+        //Primes used to combine lattice coordinates into a hash.
+        constexpr std::uint32_t PRIME_X = 0x9E3779B1u;
+        constexpr std::uint32_t PRIME_Y = 0x85EBCA77u;
+        constexpr std::uint32_t PRIME_Z = 0xC2B2AE3Du;
+
+        struct ScalarOps
+        {
+            static constexpr std::uint32_t WIDTH = 1;
+            using Float = float;
+            using Int = std::uint32_t;
+            using Mask = bool;
+
+            static Float Set(float a_Value) { return a_Value; }
+            static Int SetInt(std::uint32_t a_Value) { return a_Value; }
+            static Float Lanes() { return 0.0f; }
+            static void Store(float* a_Output, Float a_Value) { *a_Output = a_Value; }
+
+            static Float Add(Float a_A, Float a_B) { return a_A + a_B; }
+            static Float Sub(Float a_A, Float a_B) { return a_A - a_B; }
+            static Float Mul(Float a_A, Float a_B) { return a_A * a_B; }
+            static Float Max(Float a_A, Float a_B) { return a_A > a_B ? a_A : a_B; }
+            static Float Negate(Float a_A) { return -a_A; }
+            static Float Floor(Float a_A) { return std::floor(a_A); }
+            static Int ToInt(Float a_A) { return static_cast<std::uint32_t>(static_cast<std::int32_t>(a_A)); }
+
+            static Int IntAdd(Int a_A, Int a_B) { return a_A + a_B; }
+            static Int IntMul(Int a_A, Int a_B) { return a_A * a_B; }
+            static Int IntXor(Int a_A, Int a_B) { return a_A ^ a_B; }
+            template<int Shift> static Int ShiftRight(Int a_A) { return a_A >> Shift; }
+
+            static Mask Greater(Float a_A, Float a_B) { return a_A > a_B; }
+            static Mask GreaterEqual(Float a_A, Float a_B) { return a_A >= a_B; }
+            static Mask TestBit(Int a_A, std::uint32_t a_Bit) { return (a_A & a_Bit) != 0; }
+            static Mask And(Mask a_A, Mask a_B) { return a_A && a_B; }
+            static Mask Or(Mask a_A, Mask a_B) { return a_A || a_B; }
+            static Mask Not(Mask a_A) { return !a_A; }
+            static Float Select(Mask a_Mask, Float a_True, Float a_False) { return a_Mask ? a_True : a_False; }
+            static Int SelectInt(Mask a_Mask, Int a_True, Int a_False) { return a_Mask ? a_True : a_False; }
+        };
+
+        struct Sse41Ops
+        {
+            static constexpr std::uint32_t WIDTH = 4;
+            using Float = __m128;
+            using Int = __m128i;
+            using Mask = __m128;
+
+            static Float Set(float a_Value) { return _mm_set1_ps(a_Value); }
+            static Int SetInt(std::uint32_t a_Value) { return _mm_set1_epi32(static_cast<int>(a_Value)); }
+            static Float Lanes() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+            static void Store(float* a_Output, Float a_Value) { _mm_storeu_ps(a_Output, a_Value); }
+
+            static Float Add(Float a_A, Float a_B) { return _mm_add_ps(a_A, a_B); }
+            static Float Sub(Float a_A, Float a_B) { return _mm_sub_ps(a_A, a_B); }
+            static Float Mul(Float a_A, Float a_B) { return _mm_mul_ps(a_A, a_B); }
+            static Float Max(Float a_A, Float a_B) { return _mm_max_ps(a_A, a_B); }
+            static Float Negate(Float a_A) { return _mm_xor_ps(a_A, _mm_set1_ps(-0.0f)); }
+            static Float Floor(Float a_A) { return _mm_floor_ps(a_A); }
+            static Int ToInt(Float a_A) { return _mm_cvttps_epi32(a_A); }
+
+            static Int IntAdd(Int a_A, Int a_B) { return _mm_add_epi32(a_A, a_B); }
+            static Int IntMul(Int a_A, Int a_B) { return _mm_mullo_epi32(a_A, a_B); }
+            static Int IntXor(Int a_A, Int a_B) { return _mm_xor_si128(a_A, a_B); }
+            template<int Shift> static Int ShiftRight(Int a_A) { return _mm_srli_epi32(a_A, Shift); }
+
+            static Mask Greater(Float a_A, Float a_B) { return _mm_cmpgt_ps(a_A, a_B); }
+            static Mask GreaterEqual(Float a_A, Float a_B) { return _mm_cmpge_ps(a_A, a_B); }
+            static Mask TestBit(Int a_A, std::uint32_t a_Bit)
+            {
+                const auto bit = SetInt(a_Bit);
+                return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(a_A, bit), bit));
+            }
+            static Mask And(Mask a_A, Mask a_B) { return _mm_and_ps(a_A, a_B); }
+            static Mask Or(Mask a_A, Mask a_B) { return _mm_or_ps(a_A, a_B); }
+            static Mask Not(Mask a_A) { return _mm_xor_ps(a_A, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+            static Float Select(Mask a_Mask, Float a_True, Float a_False) { return _mm_blendv_ps(a_False, a_True, a_Mask); }
+            static Int SelectInt(Mask a_Mask, Int a_True, Int a_False)
+            {
+                return _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(a_False), _mm_castsi128_ps(a_True), a_Mask));
+            }
+        };
+
+        struct Avx2Ops
+        {
+            static constexpr std::uint32_t WIDTH = 8;
+            using Float = __m256;
+            using Int = __m256i;
+            using Mask = __m256;
+
+            static Float Set(float a_Value) { return _mm256_set1_ps(a_Value); }
+            static Int SetInt(std::uint32_t a_Value) { return _mm256_set1_epi32(static_cast<int>(a_Value)); }
+            static Float Lanes() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+            static void Store(float* a_Output, Float a_Value) { _mm256_storeu_ps(a_Output, a_Value); }
+
+            static Float Add(Float a_A, Float a_B) { return _mm256_add_ps(a_A, a_B); }
+            static Float Sub(Float a_A, Float a_B) { return _mm256_sub_ps(a_A, a_B); }
+            static Float Mul(Float a_A, Float a_B) { return _mm256_mul_ps(a_A, a_B); }
+            static Float Max(Float a_A, Float a_B) { return _mm256_max_ps(a_A, a_B); }
+            static Float Negate(Float a_A) { return _mm256_xor_ps(a_A, _mm256_set1_ps(-0.0f)); }
+            static Float Floor(Float a_A) { return _mm256_floor_ps(a_A); }
+            static Int ToInt(Float a_A) { return _mm256_cvttps_epi32(a_A); }
+
+            static Int IntAdd(Int a_A, Int a_B) { return _mm256_add_epi32(a_A, a_B); }
+            static Int IntMul(Int a_A, Int a_B) { return _mm256_mullo_epi32(a_A, a_B); }
+            static Int IntXor(Int a_A, Int a_B) { return _mm256_xor_si256(a_A, a_B); }
+            template<int Shift> static Int ShiftRight(Int a_A) { return _mm256_srli_epi32(a_A, Shift); }
+
+            static Mask Greater(Float a_A, Float a_B) { return _mm256_cmp_ps(a_A, a_B, _CMP_GT_OQ); }
+            static Mask GreaterEqual(Float a_A, Float a_B) { return _mm256_cmp_ps(a_A, a_B, _CMP_GE_OQ); }
+            static Mask TestBit(Int a_A, std::uint32_t a_Bit)
+            {
+                const auto bit = SetInt(a_Bit);
+                return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(a_A, bit), bit));
+            }
+            static Mask And(Mask a_A, Mask a_B) { return _mm256_and_ps(a_A, a_B); }
+            static Mask Or(Mask a_A, Mask a_B) { return _mm256_or_ps(a_A, a_B); }
+            static Mask Not(Mask a_A) { return _mm256_xor_ps(a_A, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+            static Float Select(Mask a_Mask, Float a_True, Float a_False) { return _mm256_blendv_ps(a_False, a_True, a_Mask); }
+            static Int SelectInt(Mask a_Mask, Int a_True, Int a_False)
+            {
+                return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(a_False), _mm256_castsi256_ps(a_True), a_Mask));
+            }
+        };
+
+        /*
+         * Mix the bits of a lattice hash so that the low bits can be used to pick a gradient.
+         */
+        template<typename Ops>
+        typename Ops::Int Finalize(typename Ops::Int a_Hash)
+        {
+            auto hash = Ops::IntXor(a_Hash, Ops::template ShiftRight<16>(a_Hash));
+            hash = Ops::IntMul(hash, Ops::SetInt(0x7FEB352Du));
+            hash = Ops::IntXor(hash, Ops::template ShiftRight<15>(hash));
+            hash = Ops::IntMul(hash, Ops::SetInt(0x846CA68Bu));
+            return Ops::IntXor(hash, Ops::template ShiftRight<16>(hash));
+        }
+
+        /*
+         * Dot product of the offset with one of 8 gradients of the form (1, 2) picked by the hash.
+         */
+        template<typename Ops>
+        typename Ops::Float Gradient2D(typename Ops::Int a_Hash, typename Ops::Float a_X, typename Ops::Float a_Y)
+        {
+            const auto swap = Ops::TestBit(a_Hash, 4);
+            auto u = Ops::Select(swap, a_Y, a_X);
+            auto v = Ops::Select(swap, a_X, a_Y);
+            u = Ops::Select(Ops::TestBit(a_Hash, 1), Ops::Negate(u), u);
+            v = Ops::Select(Ops::TestBit(a_Hash, 2), Ops::Negate(v), v);
+            return Ops::Add(u, Ops::Add(v, v));
+        }
+
+        /*
+         * Dot product of the offset with one of 16 gradients pointing to the edges of a cube, picked by the hash.
+         */
+        template<typename Ops>
+        typename Ops::Float Gradient3D(typename Ops::Int a_Hash, typename Ops::Float a_X, typename Ops::Float a_Y, typename Ops::Float a_Z)
+        {
+            const auto first = Ops::TestBit(a_Hash, 8);
+            const auto second = Ops::TestBit(a_Hash, 4);
+            auto u = Ops::Select(first, Ops::Select(second, a_Z, a_Y), a_X);
+            auto v = Ops::Select(second, Ops::Select(first, a_X, a_Z), Ops::Select(first, a_Z, a_Y));
+            u = Ops::Select(Ops::TestBit(a_Hash, 1), Ops::Negate(u), u);
+            v = Ops::Select(Ops::TestBit(a_Hash, 2), Ops::Negate(v), v);
+            return Ops::Add(u, v);
+        }
+
+        template<typename Ops>
+        typename Ops::Float Corner2D(typename Ops::Int a_Hash, typename Ops::Float a_X, typename Ops::Float a_Y)
+        {
+            auto t = Ops::Sub(Ops::Sub(Ops::Set(0.5f), Ops::Mul(a_X, a_X)), Ops::Mul(a_Y, a_Y));
+            t = Ops::Max(t, Ops::Set(0.0f));
+            t = Ops::Mul(t, t);
+            return Ops::Mul(Ops::Mul(t, t), Gradient2D<Ops>(a_Hash, a_X, a_Y));
+        }
+
+        template<typename Ops>
+        typename Ops::Float Corner3D(typename Ops::Int a_Hash, typename Ops::Float a_X, typename Ops::Float a_Y, typename Ops::Float a_Z)
+        {
+            auto t = Ops::Sub(Ops::Sub(Ops::Sub(Ops::Set(0.6f), Ops::Mul(a_X, a_X)), Ops::Mul(a_Y, a_Y)), Ops::Mul(a_Z, a_Z));
+            t = Ops::Max(t, Ops::Set(0.0f));
+            t = Ops::Mul(t, t);
+            return Ops::Mul(Ops::Mul(t, t), Gradient3D<Ops>(a_Hash, a_X, a_Y, a_Z));
+        }
+
+        template<typename Ops>
+        typename Ops::Int Hash2D(typename Ops::Int a_Seed, typename Ops::Int a_X, typename Ops::Int a_Y)
+        {
+            const auto hash = Ops::IntXor(Ops::IntMul(a_X, Ops::SetInt(PRIME_X)), Ops::IntMul(a_Y, Ops::SetInt(PRIME_Y)));
+            return Finalize<Ops>(Ops::IntXor(hash, a_Seed));
+        }
+
+        template<typename Ops>
+        typename Ops::Int Hash3D(typename Ops::Int a_Seed, typename Ops::Int a_X, typename Ops::Int a_Y, typename Ops::Int a_Z)
+        {
+            auto hash = Ops::IntXor(Ops::IntMul(a_X, Ops::SetInt(PRIME_X)), Ops::IntMul(a_Y, Ops::SetInt(PRIME_Y)));
+            hash = Ops::IntXor(hash, Ops::IntMul(a_Z, Ops::SetInt(PRIME_Z)));
+            return Finalize<Ops>(Ops::IntXor(hash, a_Seed));
+        }
+
+        template<typename Ops>
+        typename Ops::Float Simplex2D(typename Ops::Int a_Seed, typename Ops::Float a_X, typename Ops::Float a_Y)
+        {
+            const auto zero = Ops::Set(0.0f);
+            const auto one = Ops::Set(1.0f);
+            const auto g2 = Ops::Set(G2);
+
+            //Skew into the lattice of triangles, and find the cell.
+            const auto skew = Ops::Mul(Ops::Add(a_X, a_Y), Ops::Set(F2));
+            const auto cellX = Ops::Floor(Ops::Add(a_X, skew));
+            const auto cellY = Ops::Floor(Ops::Add(a_Y, skew));
+            const auto unskew = Ops::Mul(Ops::Add(cellX, cellY), g2);
+            const auto x0 = Ops::Sub(a_X, Ops::Sub(cellX, unskew));
+            const auto y0 = Ops::Sub(a_Y, Ops::Sub(cellY, unskew));
+            const auto i = Ops::ToInt(cellX);
+            const auto j = Ops::ToInt(cellY);
+
+            //The middle corner depends on which triangle of the cell the point is in.
+            const auto lower = Ops::Greater(x0, y0);
+            const auto x1 = Ops::Add(Ops::Sub(x0, Ops::Select(lower, one, zero)), g2);
+            const auto y1 = Ops::Add(Ops::Sub(y0, Ops::Select(lower, zero, one)), g2);
+            const auto x2 = Ops::Add(Ops::Sub(x0, one), Ops::Set(2.0f * G2));
+            const auto y2 = Ops::Add(Ops::Sub(y0, one), Ops::Set(2.0f * G2));
+            const auto i1 = Ops::IntAdd(i, Ops::SelectInt(lower, Ops::SetInt(1), Ops::SetInt(0)));
+            const auto j1 = Ops::IntAdd(j, Ops::SelectInt(lower, Ops::SetInt(0), Ops::SetInt(1)));
+            const auto i2 = Ops::IntAdd(i, Ops::SetInt(1));
+            const auto j2 = Ops::IntAdd(j, Ops::SetInt(1));
+
+            const auto n0 = Corner2D<Ops>(Hash2D<Ops>(a_Seed, i, j), x0, y0);
+            const auto n1 = Corner2D<Ops>(Hash2D<Ops>(a_Seed, i1, j1), x1, y1);
+            const auto n2 = Corner2D<Ops>(Hash2D<Ops>(a_Seed, i2, j2), x2, y2);
+            return Ops::Mul(Ops::Set(SCALE_2D), Ops::Add(Ops::Add(n0, n1), n2));
+        }
+
+        template<typename Ops>
+        typename Ops::Float Simplex3D(typename Ops::Int a_Seed, typename Ops::Float a_X, typename Ops::Float a_Y, typename Ops::Float a_Z)
+        {
+            const auto zero = Ops::Set(0.0f);
+            const auto one = Ops::Set(1.0f);
+            const auto intZero = Ops::SetInt(0);
+            const auto intOne = Ops::SetInt(1);
+
+            //Skew into the lattice of tetrahedra, and find the cell.
+            const auto skew = Ops::Mul(Ops::Add(Ops::Add(a_X, a_Y), a_Z), Ops::Set(F3));
+            const auto cellX = Ops::Floor(Ops::Add(a_X, skew));
+            const auto cellY = Ops::Floor(Ops::Add(a_Y, skew));
+            const auto cellZ = Ops::Floor(Ops::Add(a_Z, skew));
+            const auto unskew = Ops::Mul(Ops::Add(Ops::Add(cellX, cellY), cellZ), Ops::Set(G3));
+            const auto x0 = Ops::Sub(a_X, Ops::Sub(cellX, unskew));
+            const auto y0 = Ops::Sub(a_Y, Ops::Sub(cellY, unskew));
+            const auto z0 = Ops::Sub(a_Z, Ops::Sub(cellZ, unskew));
+            const auto i = Ops::ToInt(cellX);
+            const auto j = Ops::ToInt(cellY);
+            const auto k = Ops::ToInt(cellZ);
+
+            //The second corner steps along the largest offset, the third along all but the smallest.
+            const auto xy = Ops::GreaterEqual(x0, y0);
+            const auto xz = Ops::GreaterEqual(x0, z0);
+            const auto yz = Ops::GreaterEqual(y0, z0);
+            const auto stepX1 = Ops::And(xy, xz);
+            const auto stepY1 = Ops::And(Ops::Not(xy), yz);
+            const auto stepZ1 = Ops::Not(Ops::Or(xz, yz));
+            const auto stepX2 = Ops::Or(xy, xz);
+            const auto stepY2 = Ops::Or(Ops::Not(xy), yz);
+            const auto stepZ2 = Ops::Not(Ops::And(xz, yz));
+
+            const auto g3 = Ops::Set(G3);
+            const auto x1 = Ops::Add(Ops::Sub(x0, Ops::Select(stepX1, one, zero)), g3);
+            const auto y1 = Ops::Add(Ops::Sub(y0, Ops::Select(stepY1, one, zero)), g3);
+            const auto z1 = Ops::Add(Ops::Sub(z0, Ops::Select(stepZ1, one, zero)), g3);
+            const auto g3x2 = Ops::Set(2.0f * G3);
+            const auto x2 = Ops::Add(Ops::Sub(x0, Ops::Select(stepX2, one, zero)), g3x2);
+            const auto y2 = Ops::Add(Ops::Sub(y0, Ops::Select(stepY2, one, zero)), g3x2);
+            const auto z2 = Ops::Add(Ops::Sub(z0, Ops::Select(stepZ2, one, zero)), g3x2);
+            const auto g3x3 = Ops::Set(3.0f * G3);
+            const auto x3 = Ops::Add(Ops::Sub(x0, one), g3x3);
+            const auto y3 = Ops::Add(Ops::Sub(y0, one), g3x3);
+            const auto z3 = Ops::Add(Ops::Sub(z0, one), g3x3);
+
+            const auto h0 = Hash3D<Ops>(a_Seed, i, j, k);
+            const auto h1 = Hash3D<Ops>(a_Seed, Ops::IntAdd(i, Ops::SelectInt(stepX1, intOne, intZero)), Ops::IntAdd(j, Ops::SelectInt(stepY1, intOne, intZero)), Ops::IntAdd(k, Ops::SelectInt(stepZ1, intOne, intZero)));
+            const auto h2 = Hash3D<Ops>(a_Seed, Ops::IntAdd(i, Ops::SelectInt(stepX2, intOne, intZero)), Ops::IntAdd(j, Ops::SelectInt(stepY2, intOne, intZero)), Ops::IntAdd(k, Ops::SelectInt(stepZ2, intOne, intZero)));
+            const auto h3 = Hash3D<Ops>(a_Seed, Ops::IntAdd(i, intOne), Ops::IntAdd(j, intOne), Ops::IntAdd(k, intOne));
+
+            const auto n0 = Corner3D<Ops>(h0, x0, y0, z0);
+            const auto n1 = Corner3D<Ops>(h1, x1, y1, z1);
+            const auto n2 = Corner3D<Ops>(h2, x2, y2, z2);
+            const auto n3 = Corner3D<Ops>(h3, x3, y3, z3);
+            return Ops::Mul(Ops::Set(SCALE_3D), Ops::Add(Ops::Add(Ops::Add(n0, n1), n2), n3));
+        }
+
+        /*
+         * Store the samples of a block, which may reach past the end of the row.
+         */
+        template<typename Ops>
+        void StoreBlock(float* a_Output, std::uint32_t a_Remaining, typename Ops::Float a_Value)
+        {
+            if(a_Remaining >= Ops::WIDTH)
+            {
+                Ops::Store(a_Output, a_Value);
+                return;
+            }
+
+            float block[Ops::WIDTH];
+            Ops::Store(block, a_Value);
+            std::copy(block, block + a_Remaining, a_Output);
+        }
+
+        template<typename Ops>
+        void FractalRow2D(const FractalNoise::Octave* a_Octaves, std::uint32_t a_OctaveCount, float a_X, float a_Y, float a_Step, std::uint32_t a_Count, float* a_Output)
+        {
+            for(std::uint32_t i = 0; i < a_Count; i += Ops::WIDTH)
+            {
+                const auto x = Ops::Add(Ops::Set(a_X), Ops::Mul(Ops::Add(Ops::Lanes(), Ops::Set(static_cast<float>(i))), Ops::Set(a_Step)));
+                const auto y = Ops::Set(a_Y);
+
+                auto value = Ops::Set(0.0f);
+                for(std::uint32_t octave = 0; octave < a_OctaveCount; ++octave)
+                {
+                    const auto& settings = a_Octaves[octave];
+                    const auto frequency = Ops::Set(settings.frequency);
+                    const auto noise = Simplex2D<Ops>(Ops::SetInt(settings.seed), Ops::Mul(x, frequency), Ops::Mul(y, frequency));
+                    value = Ops::Add(value, Ops::Mul(noise, Ops::Set(settings.amplitude)));
+                }
+
+                StoreBlock<Ops>(a_Output + i, a_Count - i, value);
+            }
+        }
+
+        template<typename Ops>
+        void FractalRow3D(const FractalNoise::Octave* a_Octaves, std::uint32_t a_OctaveCount, float a_X, float a_Y, float a_Z, float a_Step, std::uint32_t a_Count, float* a_Output)
+        {
+            for(std::uint32_t i = 0; i < a_Count; i += Ops::WIDTH)
+            {
+                const auto x = Ops::Add(Ops::Set(a_X), Ops::Mul(Ops::Add(Ops::Lanes(), Ops::Set(static_cast<float>(i))), Ops::Set(a_Step)));
+                const auto y = Ops::Set(a_Y);
+                const auto z = Ops::Set(a_Z);
+
+                auto value = Ops::Set(0.0f);
+                for(std::uint32_t octave = 0; octave < a_OctaveCount; ++octave)
+                {
+                    const auto& settings = a_Octaves[octave];
+                    const auto frequency = Ops::Set(settings.frequency);
+                    const auto noise = Simplex3D<Ops>(Ops::SetInt(settings.seed), Ops::Mul(x, frequency), Ops::Mul(y, frequency), Ops::Mul(z, frequency));
+                    value = Ops::Add(value, Ops::Mul(noise, Ops::Set(settings.amplitude)));
+                }
+
+                StoreBlock<Ops>(a_Output + i, a_Count - i, value);
+            }
+        }
+
+        NoiseKernel DetectKernel()
+        {
+            bool sse41 = false;
+            bool avx2 = false;
+
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            const auto maxLeaf = info[0];
+
+            __cpuid(info, 1);
+            sse41 = (info[2] & (1 << 19)) != 0;
+            const auto osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+            if(maxLeaf >= 7 && osSavesAvx)
+            {
+                __cpuidex(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+            }
+#else
+            __builtin_cpu_init();
+            sse41 = __builtin_cpu_supports("sse4.1");
+            avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+            if(avx2)
+            {
+                return NoiseKernel::AVX2;
+            }
+            return sse41 ? NoiseKernel::SSE41 : NoiseKernel::SCALAR;
+        }
+
+        /*
+         * Derive a 32 bit seed for every octave from the world seed (splitmix64).
+         */
+        std::uint32_t OctaveSeed(std::uint64_t a_Seed, std::uint32_t a_Octave)
+        {
+            return static_cast<std::uint32_t>(Mix64(a_Seed + (a_Octave + 1) * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+    }
+
+    FractalNoise::FractalNoise(std::uint64_t a_Seed, const NoiseSettings& a_Settings) : FractalNoise(a_Seed, a_Settings, GetFastestKernel())
+    {
+
+    }
+
+    FractalNoise::FractalNoise(std::uint64_t a_Seed, const NoiseSettings& a_Settings, NoiseKernel a_Kernel)
+    {
+        m_OctaveCount = std::min(std::max(a_Settings.octaves, 1u), MAX_OCTAVES);
+        m_Kernel = std::min(a_Kernel, GetFastestKernel());
+
+        float totalAmplitude = 0.0f;
+        float frequency = a_Settings.frequency;
+        float amplitude = 1.0f;
+        for(std::uint32_t i = 0; i < m_OctaveCount; ++i)
+        {
+            m_Octaves[i] = { frequency, amplitude, OctaveSeed(a_Seed, i) };
+            totalAmplitude += amplitude;
+            frequency *= a_Settings.lacunarity;
+            amplitude *= a_Settings.gain;
+        }
+
+        for(std::uint32_t i = 0; i < m_OctaveCount; ++i)
+        {
+            m_Octaves[i].amplitude /= totalAmplitude;
+        }
+    }
+
+    void FractalNoise::Row2D(float a_X, float a_Y, float a_Step, std::uint32_t a_Count, float* a_Output) const
+    {
+        switch(m_Kernel)
+        {
+        case NoiseKernel::AVX2:
+            FractalRow2D<Avx2Ops>(m_Octaves, m_OctaveCount, a_X, a_Y, a_Step, a_Count, a_Output);
+            break;
+        case NoiseKernel::SSE41:
+            FractalRow2D<Sse41Ops>(m_Octaves, m_OctaveCount, a_X, a_Y, a_Step, a_Count, a_Output);
+            break;
+        default:
+            FractalRow2D<ScalarOps>(m_Octaves, m_OctaveCount, a_X, a_Y, a_Step, a_Count, a_Output);
+            break;
+        }
+    }
+
+    void FractalNoise::Row3D(float a_X, float a_Y, float a_Z, float a_Step, std::uint32_t a_Count, float* a_Output) const
+    {
+        switch(m_Kernel)
+        {
+        case NoiseKernel::AVX2:
+            FractalRow3D<Avx2Ops>(m_Octaves, m_OctaveCount, a_X, a_Y, a_Z, a_Step, a_Count, a_Output);
+            break;
+        case NoiseKernel::SSE41:
+            FractalRow3D<Sse41Ops>(m_Octaves, m_OctaveCount, a_X, a_Y, a_Z, a_Step, a_Count, a_Output);
+            break;
+        default:
+            FractalRow3D<ScalarOps>(m_Octaves, m_OctaveCount, a_X, a_Y, a_Z, a_Step, a_Count, a_Output);
+            break;
+        }
+    }
+
+    float FractalNoise::Sample2D(float a_X, float a_Y) const
+    {
+        float value;
+        FractalRow2D<ScalarOps>(m_Octaves, m_OctaveCount, a_X, a_Y, 0.0f, 1, &value);
+        return value;
+    }
+
+    float FractalNoise::Sample3D(float a_X, float a_Y, float a_Z) const
+    {
+        float value;
+        FractalRow3D<ScalarOps>(m_Octaves, m_OctaveCount, a_X, a_Y, a_Z, 0.0f, 1, &value);
+        return value;
+    }
+
+    NoiseKernel FractalNoise::GetKernel() const
+    {
+        return m_Kernel;
+    }
+
+    NoiseKernel FractalNoise::GetFastestKernel()
+    {
+        static const NoiseKernel kernel = DetectKernel();
+        return kernel;
+    }
+}
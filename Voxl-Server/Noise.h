@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+
+namespace voxl
+{
+    /*
+     * The instruction sets noise can be evaluated with.
+     * All kernels produce bit-identical results, so the choice only affects speed.
+     */
+    enum class NoiseKernel
+    {
+        SCALAR,     //Plain C++, available everywhere.
+        SSE41,      //4 samples at once.
+        AVX2        //8 samples at once.
+    };
+
+    /*
+     * Parameters for fractal noise, made by adding octaves of simplex noise at increasing frequency and decreasing amplitude.
+     */
+    struct NoiseSettings
+    {
+        std::uint32_t octaves = 4;      //Amount of layers of noise, at most FractalNoise::MAX_OCTAVES.
+        float frequency = 0.01f;        //Frequency of the first octave, in samples per unit.
+        float lacunarity = 2.0f;        //Frequency multiplier between octaves.
+        float gain = 0.5f;              //Amplitude multiplier between octaves.
+    };
+
+    /*
+     * Seeded 2D and 3D simplex noise with fractal octaves, returning values roughly between -1 and 1.
+     *
+     * Noise is evaluated a row of samples at a time, spaced a_Step apart along the x axis.
+     * Rows are processed with the fastest kernel the CPU supports, unless a specific kernel is requested.
+     * Every kernel runs the same operations in the same order, so worlds generate identically on every machine.
+     *
+     * Instances are immutable after construction and can be used from multiple threads.
+     */
+    class FractalNoise
+    {
+    public:
+        static constexpr std::uint32_t MAX_OCTAVES = 16;
+
+    public:
+        FractalNoise(std::uint64_t a_Seed, const NoiseSettings& a_Settings);
+
+        /*
+         * Use the given kernel, or the fastest supported one below it if the CPU does not support it.
+         */
+        FractalNoise(std::uint64_t a_Seed, const NoiseSettings& a_Settings, NoiseKernel a_Kernel);
+
+        /*
+         * Sample a_Count points (a_X + i * a_Step, a_Y) into a_Output.
+         */
+        void Row2D(float a_X, float a_Y, float a_Step, std::uint32_t a_Count, float* a_Output) const;
+
+        /*
+         * Sample a_Count points (a_X + i * a_Step, a_Y, a_Z) into a_Output.
+         */
+        void Row3D(float a_X, float a_Y, float a_Z, float a_Step, std::uint32_t a_Count, float* a_Output) const;
+
+        /*
+         * Sample a single point.
+         */
+        float Sample2D(float a_X, float a_Y) const;
+        float Sample3D(float a_X, float a_Y, float a_Z) const;
+
+        /*
+         * Get the kernel this instance uses.
+         */
+        NoiseKernel GetKernel() const;
+
+        /*
+         * Get the fastest kernel supported by this CPU.
+         */
+        static NoiseKernel GetFastestKernel();
+
+    public:
+        //Parameters of a single octave. The amplitudes add up to 1.
+        struct Octave
+        {
+            float frequency;
+            float amplitude;
+            std::uint32_t seed;
+        };
+
+    private:
+        Octave m_Octaves[MAX_OCTAVES];
+        std::uint32_t m_OctaveCount;
+        NoiseKernel m_Kernel;
+    };
+}
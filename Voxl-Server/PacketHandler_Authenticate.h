@@ -34,6 +34,17 @@ namespace voxl
             //TODO authenticate
             bool credentialsValid = true;
 
+            //Clients using another wire format can not read the packets of this server.
+            if(a_Data.protocolVersion != PROTOCOL_VERSION)
+            {
+                response.accepted = false;
+                sender->SendTypedPacket(response);
+
+                //Log the request
+                utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Info, "Authentication request from: " + a_Sender->GetIp() + " for user " + name + " denied, protocol version " + std::to_string(a_Data.protocolVersion) + " does not match " + std::to_string(PROTOCOL_VERSION) + ".");
+                return false;
+            }
+
             //Already connected.
             if(m_Manager.GetClient(name) != nullptr || !credentialsValid)
             {
@@ -1,9 +1,21 @@
 #include "PacketHandler_ChunkSubscribe.h"
 
+#include "ClientConnection.h"
+
 namespace voxl
 {
     bool PacketHandler_ChunkSubscribe::OnResolve(Packet_ChunkSubscribe& a_Data, IConnection* a_Sender)
     {
-        //TODO get the world the player is in, then add them tothe chunk as subscribed.
+        if(a_Sender == nullptr)
+        {
+            return false;
+        }
+
+        //Subscribed chunks stay loaded. The chunk is sent once it is loaded and the client has bandwidth left, nearest chunks first.
+        auto* connection = static_cast<ClientConnection*>(a_Sender);
+        const auto coordinates = glm::ivec3(a_Data.coordinates[0], a_Data.coordinates[1], a_Data.coordinates[2]);
+        connection->Subscribe(coordinates);
+        connection->GetChunkQueue().Push(coordinates);
+        return true;
     }
 }
@@ -1,10 +1,21 @@
 #include "PacketHandler_ChunkUnsubscribe.h"
 
+#include "ClientConnection.h"
+
 namespace voxl
 {
     bool PacketHandler_ChunkUnsubscribe::OnResolve(Packet_ChunkUnsubscribe& a_Data, IConnection* a_Sender)
     {
-        //TODO get world the player is in and remove player from that chunk.
+        if(a_Sender == nullptr)
+        {
+            return false;
+        }
+
+        //A chunk that was not sent yet is no longer needed either.
+        auto* connection = static_cast<ClientConnection*>(a_Sender);
+        const auto coordinates = glm::ivec3(a_Data.coordinates[0], a_Data.coordinates[1], a_Data.coordinates[2]);
+        connection->Unsubscribe(coordinates);
+        connection->GetChunkQueue().Remove(coordinates);
         return true;
     }
 }
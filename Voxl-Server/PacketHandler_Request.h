@@ -14,19 +14,16 @@ namespace voxl
     class PacketHandler_Request : public PacketHandler<Packet_Request>
     {
     public:
-        PacketHandler_Request(const std::vector<char>& a_VoxelInfoFile)
+        PacketHandler_Request(const std::vector<char>& a_VoxelInfoFile) : m_VoxelInfoFile(a_VoxelInfoFile)
         {
-            //Set up the memory so that the packet si directly followed by the file data.
-            m_VoxelInfoPacket.resize(a_VoxelInfoFile.size() + sizeof(Packet_VoxelInfo));
-            Packet_VoxelInfo* ptr = reinterpret_cast<Packet_VoxelInfo*>(&m_VoxelInfoPacket[0]);
-            ptr->size = a_VoxelInfoFile.size();
-            Packet_VoxelInfo toCopy;
-            memcpy_s(ptr, sizeof(Packet_VoxelInfo), &toCopy, sizeof(Packet_VoxelInfo));
-
-            m_VoxelInfoPacket.insert(m_VoxelInfoPacket.begin() + sizeof(Packet_VoxelInfo), a_VoxelInfoFile.begin(), a_VoxelInfoFile.end());
-            
+            //The packet refers to the file, which is copied into the send buffer every time it is sent.
+            m_VoxelInfoPacket.json = ByteView{ reinterpret_cast<const std::uint8_t*>(m_VoxelInfoFile.data()), static_cast<std::uint32_t>(m_VoxelInfoFile.size()) };
         }
 
+        //The packet points into m_VoxelInfoFile.
+        PacketHandler_Request(const PacketHandler_Request&) = delete;
+        PacketHandler_Request& operator=(const PacketHandler_Request&) = delete;
+
         bool OnResolve(Packet_Request& a_Data, IConnection* a_Sender) override
         {
             if(a_Sender != nullptr)
@@ -34,8 +31,7 @@ namespace voxl
                 //Voxel info packet has been requested by the sender, so send it.
                 if(a_Data.requested == PacketType::VOXEL_INFO)
                 {
-                    IPacket* packetPtr = reinterpret_cast<Packet_VoxelInfo*>(&m_VoxelInfoPacket[0]);
-                    a_Sender->SendPacket(*packetPtr, m_VoxelInfoPacket.size());
+                    a_Sender->SendTypedPacket(m_VoxelInfoPacket);
                 }
             }
 
@@ -43,6 +39,7 @@ namespace voxl
         }
 
     private:
-        std::vector<char> m_VoxelInfoPacket;
+        std::vector<char> m_VoxelInfoFile;
+        Packet_VoxelInfo m_VoxelInfoPacket;
     };
 }
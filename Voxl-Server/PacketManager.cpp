@@ -15,12 +15,23 @@ namespace voxl
         m_Handlers.resize(static_cast<size_t>(PacketType::UNKNOWN) + 1);
     }
 
-    bool PacketManager::Resolve(PacketType a_Type, IPacket& a_Data, IConnection* a_Sender)
+    bool PacketManager::Resolve(PacketType a_Type, PacketReader& a_Reader, IConnection* a_Sender)
     {
+        assert(static_cast<size_t>(a_Type) < m_Handlers.size());
         auto* found = m_Handlers[static_cast<size_t>(a_Type)].get();
         if(found != nullptr)
         {
-            return found->Resolve(a_Data, a_Sender);
+            if(found->Resolve(a_Reader, a_Sender))
+            {
+                return true;
+            }
+
+            //Handlers only fail on their own for authentication, so only report packets that could not be read.
+            if(a_Reader.HasFailed() || a_Reader.GetRemaining() != 0)
+            {
+                utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Warning, "Package of type: " + std::to_string(static_cast<int>(a_Type)) + " is malformed.");
+            }
+            return false;
         }
 
         utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Warning, "Package of type: " + std::to_string(static_cast<int>(a_Type)) + " is not handled.");
@@ -9,7 +9,7 @@ namespace voxl
     public:
         PacketManager();
 
-        bool Resolve(PacketType a_Type, IPacket& a_Data, IConnection* a_Sender) override;
+        bool Resolve(PacketType a_Type, PacketReader& a_Reader, IConnection* a_Sender) override;
         void Register(PacketType a_Type, std::unique_ptr<IPacketHandler>&& a_Handler) override;
     private:
         //Map containing all the registered packet handlers.
@@ -0,0 +1,275 @@
+#include "PendingWriteStore.h"
+
+#include <cstring>
+#include <unordered_set>
+
+#include <IChunk.h>
+#include <IVoxelEditor.h>
+#include <Utility.h>
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+
+#include "ChunkStore.h"
+#include "RegionStorage.h"
+
+namespace voxl
+{
+    namespace
+    {
+        //Voxel index, id and metadata. Light is calculated after the voxel is placed, so it is not stored.
+        constexpr std::size_t WRITE_SIZE = 5;
+
+        template<typename T>
+        void Append(std::vector<std::uint8_t>& a_Output, T a_Value)
+        {
+            const auto offset = a_Output.size();
+            a_Output.resize(offset + sizeof(T));
+            std::memcpy(a_Output.data() + offset, &a_Value, sizeof(T));
+        }
+
+        template<typename T>
+        bool Take(const std::vector<std::uint8_t>& a_Data, std::size_t& a_Offset, T& a_Value)
+        {
+            if(a_Offset + sizeof(T) > a_Data.size())
+            {
+                return false;
+            }
+            std::memcpy(&a_Value, a_Data.data() + a_Offset, sizeof(T));
+            a_Offset += sizeof(T);
+            return true;
+        }
+    }
+
+    PendingWriteStore::PendingWriteStore(RegionStorage& a_RegionStorage, IVoxelEditor* a_VoxelEditor) : m_RegionStorage(a_RegionStorage), m_VoxelEditor(a_VoxelEditor), m_Count(0)
+    {
+
+    }
+
+    void PendingWriteStore::Add(ChunkStore& a_ChunkStore, const std::vector<PendingWrite>& a_Writes)
+    {
+        for(const auto& write : a_Writes)
+        {
+            auto* chunk = a_ChunkStore.GetChunk(write.chunk);
+            if(chunk != nullptr)
+            {
+                if(m_VoxelEditor != nullptr)
+                {
+                    m_VoxelEditor->QueueUpdate(write.chunk * CHUNK_SIZE + glm::ivec3(GetVoxelCoordinates(write.index)), write.data, EditPriority::POPULATION);
+                }
+                else if(Merge(*chunk, write.index, write.data))
+                {
+                    chunk->SetDirty(true);
+                }
+                continue;
+            }
+
+            auto& region = GetRegion(write.chunk);
+            region.chunks[RegionFile::GetChunkIndex(write.chunk)].push_back({ static_cast<std::uint16_t>(write.index), write.data });
+            region.changed = true;
+            ++m_Count;
+        }
+    }
+
+    bool PendingWriteStore::Apply(IChunk& a_Chunk)
+    {
+        const auto coordinates = a_Chunk.GetChunkCoordinates();
+        auto& region = GetRegion(coordinates);
+        const auto found = region.chunks.find(RegionFile::GetChunkIndex(coordinates));
+        if(found == region.chunks.end())
+        {
+            return false;
+        }
+
+        auto changed = false;
+        for(const auto& write : found->second)
+        {
+            changed |= Merge(a_Chunk, write.index, write.data);
+        }
+
+        m_Count -= found->second.size();
+        region.chunks.erase(found);
+        region.changed = true;
+
+        if(changed)
+        {
+            a_Chunk.SetDirty(true);
+        }
+        return changed;
+    }
+
+    bool PendingWriteStore::Save(bool a_Release)
+    {
+        auto success = true;
+        std::vector<std::uint8_t> data;
+        for(auto itr = m_Regions.begin(); itr != m_Regions.end();)
+        {
+            auto& region = itr->second;
+            if(region.changed)
+            {
+                data.clear();
+                Serialize(region, data);
+                if(!m_RegionStorage.SavePendingWrites(UnpackChunkCoordinates(itr->first) * RegionFile::REGION_SIZE, data))
+                {
+                    success = false;
+                    ++itr;
+                    continue;
+                }
+                region.changed = false;
+            }
+
+            if(!a_Release)
+            {
+                ++itr;
+                continue;
+            }
+
+            for(const auto& chunk : region.chunks)
+            {
+                m_Count -= chunk.second.size();
+            }
+            itr = m_Regions.erase(itr);
+        }
+
+        if(!success)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Could not save all pending writes to the region files.");
+        }
+        return success;
+    }
+
+    void PendingWriteStore::Release(ChunkStore& a_ChunkStore)
+    {
+        if(m_Regions.empty())
+        {
+            return;
+        }
+
+        std::unordered_set<std::uint64_t> loaded;
+        for(auto& chunk : a_ChunkStore)
+        {
+            loaded.insert(PackChunkCoordinates(RegionFile::GetRegionCoordinates(chunk.GetChunkCoordinates())));
+        }
+
+        for(auto itr = m_Regions.begin(); itr != m_Regions.end();)
+        {
+            if(itr->second.changed || loaded.count(itr->first) != 0)
+            {
+                ++itr;
+                continue;
+            }
+
+            for(const auto& chunk : itr->second.chunks)
+            {
+                m_Count -= chunk.second.size();
+            }
+            itr = m_Regions.erase(itr);
+        }
+    }
+
+    std::size_t PendingWriteStore::GetCount() const
+    {
+        return m_Count;
+    }
+
+    bool PendingWriteStore::Merge(IChunk& a_Chunk, std::uint32_t a_Index, const VoxelData& a_Data)
+    {
+        const auto current = a_Chunk.GetVoxel(a_Index);
+        if(current.id != 0 || a_Data.id == 0)
+        {
+            return false;
+        }
+
+        a_Chunk.SetVoxel(a_Index, a_Data);
+        return true;
+    }
+
+    PendingWriteStore::Region& PendingWriteStore::GetRegion(const glm::ivec3& a_ChunkCoordinates)
+    {
+        const auto key = PackChunkCoordinates(RegionFile::GetRegionCoordinates(a_ChunkCoordinates));
+        const auto found = m_Regions.find(key);
+        if(found != m_Regions.end())
+        {
+            return found->second;
+        }
+
+        auto& region = m_Regions[key];
+        std::vector<std::uint8_t> data;
+        if(m_RegionStorage.LoadPendingWrites(a_ChunkCoordinates, data))
+        {
+            if(Deserialize(data, region))
+            {
+                for(const auto& chunk : region.chunks)
+                {
+                    m_Count += chunk.second.size();
+                }
+            }
+            else
+            {
+                //Drop the broken record the next time the region is saved.
+                utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Region file contains invalid pending writes, they are discarded.");
+                region.chunks.clear();
+                region.changed = true;
+            }
+        }
+        return region;
+    }
+
+    void PendingWriteStore::Serialize(const Region& a_Region, std::vector<std::uint8_t>& a_Output)
+    {
+        //Empty regions are stored as no record at all.
+        if(a_Region.chunks.empty())
+        {
+            return;
+        }
+
+        Append(a_Output, static_cast<std::uint32_t>(a_Region.chunks.size()));
+        for(const auto& chunk : a_Region.chunks)
+        {
+            Append(a_Output, static_cast<std::uint16_t>(chunk.first));
+            Append(a_Output, static_cast<std::uint32_t>(chunk.second.size()));
+            a_Output.reserve(a_Output.size() + chunk.second.size() * WRITE_SIZE);
+            for(const auto& write : chunk.second)
+            {
+                Append(a_Output, write.index);
+                Append(a_Output, write.data.id);
+                Append(a_Output, write.data.metaData);
+            }
+        }
+    }
+
+    bool PendingWriteStore::Deserialize(const std::vector<std::uint8_t>& a_Data, Region& a_Region)
+    {
+        std::size_t offset = 0;
+        std::uint32_t chunkCount;
+        if(!Take(a_Data, offset, chunkCount))
+        {
+            return false;
+        }
+
+        for(std::uint32_t i = 0; i < chunkCount; ++i)
+        {
+            std::uint16_t chunkIndex;
+            std::uint32_t writeCount;
+            if(!Take(a_Data, offset, chunkIndex) || !Take(a_Data, offset, writeCount) || chunkIndex >= RegionFile::CHUNKS_PER_REGION || a_Data.size() - offset < static_cast<std::size_t>(writeCount) * WRITE_SIZE)
+            {
+                return false;
+            }
+
+            auto& writes = a_Region.chunks[chunkIndex];
+            writes.reserve(writes.size() + writeCount);
+            for(std::uint32_t j = 0; j < writeCount; ++j)
+            {
+                Write write;
+                Take(a_Data, offset, write.index);
+                Take(a_Data, offset, write.data.id);
+                Take(a_Data, offset, write.data.metaData);
+                if(write.index >= CHUNK_SIZE_CUBED)
+                {
+                    return false;
+                }
+                writes.push_back(write);
+            }
+        }
+        return offset == a_Data.size();
+    }
+}
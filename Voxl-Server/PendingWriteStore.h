@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "PopulateContext.h"
+
+namespace voxl
+{
+    class ChunkStore;
+    class IChunk;
+    class IVoxelEditor;
+    class RegionStorage;
+
+    /*
+     * Holds voxels that population placed in other chunks until those chunks are populated or loaded.
+     *
+     * Writes are grouped per region, and persisted in a record of the region file so that chunks that are not loaded, or not even generated, still receive them.
+     * The record of a region is read the first time the region is used, and written back by Save.
+     * Save is called before chunks are written, so a saved chunk never has its writes to other chunks only in memory.
+     * Population yields to everything else: its writes only fill voxels that are empty, see Merge.
+     * Only used from the tick thread.
+     */
+    class PendingWriteStore
+    {
+    public:
+        /*
+         * Writes to loaded chunks are queued on a_VoxelEditor with EditPriority::POPULATION, so that they are lit, logged and sent to clients like any other change.
+         * Without a voxel editor they are merged into the chunk directly, which is only right when nothing else follows the chunks, such as during pregeneration.
+         */
+        explicit PendingWriteStore(RegionStorage& a_RegionStorage, IVoxelEditor* a_VoxelEditor = nullptr);
+
+        /*
+         * Deliver the writes collected while populating a chunk.
+         * Writes to chunks in a_ChunkStore are applied with the next voxel editor apply, the others are kept until Apply is called for their chunk.
+         */
+        void Add(ChunkStore& a_ChunkStore, const std::vector<PendingWrite>& a_Writes);
+
+        /*
+         * Apply and forget the writes kept for a chunk. Call this for every populated or loaded chunk before it is added to the chunk store.
+         * Returns true if the chunk changed, in which case it is also marked dirty.
+         */
+        bool Apply(IChunk& a_Chunk);
+
+        /*
+         * Write the regions that changed to their region files. With a_Release the writes kept in memory are released as well, which full saves do.
+         * Autosaves keep them, as the regions around loaded chunks are likely used again soon, and call Release once in a while instead.
+         * Returns false if any region could not be written. Those stay in memory.
+         */
+        bool Save(bool a_Release = true);
+
+        /*
+         * Release the writes kept in memory for regions that are saved and hold none of the chunks in a_ChunkStore.
+         * They are read from the region file again when one of their chunks is used.
+         */
+        void Release(ChunkStore& a_ChunkStore);
+
+        /*
+         * Get the amount of writes kept in memory.
+         */
+        std::size_t GetCount() const;
+
+        /*
+         * Set a voxel written by the population of another chunk.
+         * Only empty voxels are set, so that population never replaces terrain or player edits. Where structures overlap, the one delivered first stays.
+         * Returns true if the voxel changed.
+         */
+        static bool Merge(IChunk& a_Chunk, std::uint32_t a_Index, const VoxelData& a_Data);
+
+    private:
+        struct Write
+        {
+            std::uint16_t index;
+            VoxelData data;
+        };
+
+        struct Region
+        {
+            //Writes by the index of their chunk within the region.
+            std::unordered_map<std::uint32_t, std::vector<Write>> chunks;
+            bool changed = false;
+        };
+
+        /*
+         * Get the writes for the region containing the given chunk, reading them from the region file on first use.
+         */
+        Region& GetRegion(const glm::ivec3& a_ChunkCoordinates);
+
+        static void Serialize(const Region& a_Region, std::vector<std::uint8_t>& a_Output);
+        static bool Deserialize(const std::vector<std::uint8_t>& a_Data, Region& a_Region);
+
+    private:
+        RegionStorage& m_RegionStorage;
+        IVoxelEditor* m_VoxelEditor;
+
+        //Regions in use, by packed region coordinates.
+        std::unordered_map<std::uint64_t, Region> m_Regions;
+        std::size_t m_Count;
+    };
+}
@@ -0,0 +1,28 @@
+#include "PopulateContext.h"
+
+#include <IChunk.h>
+#include <Utility.h>
+
+namespace voxl
+{
+    PopulateContext::PopulateContext(IChunk& a_Chunk, std::vector<PendingWrite>& a_Writes) : m_Chunk(a_Chunk), m_Coordinates(a_Chunk.GetChunkCoordinates()), m_Writes(a_Writes)
+    {
+
+    }
+
+    void PopulateContext::SetVoxel(const glm::ivec3& a_Position, const VoxelData& a_Data)
+    {
+        glm::ivec3 chunk;
+        std::uint32_t index;
+        VoxelToChunk(a_Position, chunk, index);
+
+        if(chunk == m_Coordinates)
+        {
+            m_Chunk.SetVoxel(index, a_Data);
+        }
+        else
+        {
+            m_Writes.push_back({ chunk, index, a_Data });
+        }
+    }
+}
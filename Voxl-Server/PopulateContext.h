@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <IPopulateContext.h>
+
+namespace voxl
+{
+    class IChunk;
+
+    /*
+     * A voxel placed by population in a chunk other than the one being populated.
+     */
+    struct PendingWrite
+    {
+        glm::ivec3 chunk;
+        std::uint32_t index;
+        VoxelData data;
+    };
+
+    /*
+     * Population context that sets voxels in the populated chunk, and collects writes to other chunks in a list.
+     * The list is handed to a PendingWriteStore after population, so population never touches other chunks or takes locks.
+     */
+    class PopulateContext : public IPopulateContext
+    {
+    public:
+        PopulateContext(IChunk& a_Chunk, std::vector<PendingWrite>& a_Writes);
+
+        void SetVoxel(const glm::ivec3& a_Position, const VoxelData& a_Data) override;
+
+    private:
+        IChunk& m_Chunk;
+        glm::ivec3 m_Coordinates;
+        std::vector<PendingWrite>& m_Writes;
+    };
+}
@@ -0,0 +1,365 @@
+#include "Pregenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <IWorldGenerator.h>
+#include <Utility.h>
+#include <file/FileUtilities.h>
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+#include <threads/ThreadPool.h>
+#include <time/Timer.h>
+
+#include "Chunk.h"
+#include "ChunkPipeline.h"
+#include "ChunkStore.h"
+#include "DefaultWorldGenerator.h"
+#include "JsonUtilities.h"
+#include "PendingWriteStore.h"
+#include "RegionFile.h"
+#include "RegionStorage.h"
+#include "World.h"
+
+namespace voxl
+{
+    Pregenerator::Pregenerator(const std::string& a_WorldName, const PregenerationArea& a_Area) : m_WorldName(a_WorldName), m_Directory("worlds/" + a_WorldName + "/"), m_Area(a_Area)
+    {
+
+    }
+
+    bool Pregenerator::Run(const std::function<std::shared_ptr<IWorldGenerator>(const WorldSettings&)>& a_GetGenerator, utilities::ThreadPool& a_ThreadPool, const std::atomic<bool>& a_Stop)
+    {
+        auto& logger = utilities::ServiceLocator<utilities::Logger>::getService();
+
+        //Only the settings needed for generation are read, the world is not loaded.
+        const auto levelDataPath = m_Directory + LEVEL_DATA_FILE_NAME;
+        if(!utilities::FileUtilities::FileExists(levelDataPath))
+        {
+            logger.log(utilities::Severity::Error, "Cannot pregenerate world '" + m_WorldName + "' because it does not have a valid levelData file.");
+            return false;
+        }
+
+        std::ifstream ifs(levelDataPath);
+        auto json = nlohmann::json::parse(ifs);
+        ifs.close();
+        WorldSettings settings;
+        if(!JsonUtilities::VerifyValue("generator", json, settings.generator) || !JsonUtilities::VerifyValue("seed", json, settings.seed))
+        {
+            logger.log(utilities::Severity::Error, "Cannot pregenerate world '" + m_WorldName + "' because it does not have a valid generator and seed defined.");
+            return false;
+        }
+        JsonUtilities::VerifyValue("chunksPerSlab", json, settings.chunksPerSlab);
+        JsonUtilities::VerifyValue("compressChunks", json, settings.compressChunks);
+        JsonUtilities::VerifyValue("climateSpacing", json, settings.climateSpacing);
+        settings.name = m_WorldName;
+
+        const auto generator = a_GetGenerator(settings);
+        if(generator == nullptr)
+        {
+            logger.log(utilities::Severity::Error, "World '" + m_WorldName + "' does not have a valid generator '" + settings.generator + "'.");
+            return false;
+        }
+
+        //Record the climate spacing the chunks are generated with, so that the server does not load the world with another one.
+        const auto* defaultGenerator = dynamic_cast<const DefaultWorldGenerator*>(generator.get());
+        if(defaultGenerator != nullptr)
+        {
+            const auto recorded = settings.climateSpacing != 0;
+            if(!defaultGenerator->CheckWorldSettings(settings))
+            {
+                return false;
+            }
+            if(!recorded)
+            {
+                json["climateSpacing"] = settings.climateSpacing;
+                std::ofstream(levelDataPath) << json;
+            }
+        }
+
+        const auto batches = CreateBatches();
+        std::size_t totalChunks = 0;
+        for(const auto& batch : batches)
+        {
+            totalChunks += batch.chunks.size();
+        }
+
+        auto completedBatches = std::min(LoadProgress(), static_cast<std::uint32_t>(batches.size()));
+        std::size_t doneChunks = 0;
+        for(std::uint32_t i = 0; i < completedBatches; ++i)
+        {
+            doneChunks += batches[i].chunks.size();
+        }
+
+        logger.log(utilities::Severity::Info, "Pregenerating " + std::to_string(totalChunks) + " chunks in " + std::to_string(batches.size()) + " regions of world '" + m_WorldName + "' on " + std::to_string(a_ThreadPool.numThreads()) + " threads.");
+        if(completedBatches != 0)
+        {
+            logger.log(utilities::Severity::Info, "Resuming after " + std::to_string(completedBatches) + " finished regions.");
+        }
+
+        ChunkStore chunkStore(settings.chunksPerSlab == 0 ? WorldSettings().chunksPerSlab : settings.chunksPerSlab);
+        RegionStorage regionStorage(m_Directory + "regions/");
+        PendingWriteStore pendingWrites(regionStorage);
+        auto pipeline = std::make_unique<ChunkPipeline>(a_ThreadPool, chunkStore, regionStorage, pendingWrites, generator, settings.seed);
+
+        //Regions that still have chunks to generate. Neighbour chunks kept for these are not discarded.
+        std::unordered_set<std::uint64_t> pendingRegions;
+        for(auto i = completedBatches; i < batches.size(); ++i)
+        {
+            pendingRegions.insert(PackChunkCoordinates(batches[i].region));
+        }
+
+        utilities::Timer timer;
+        const auto startChunks = doneChunks;
+        auto nextReport = REPORT_INTERVAL;
+        auto success = true;
+
+        for(auto i = completedBatches; i < batches.size() && !a_Stop; ++i)
+        {
+            const auto& batch = batches[i];
+
+            //Chunks saved by an interrupted run are kept as they are.
+            std::vector<glm::ivec3> requested;
+            for(const auto& coordinates : batch.chunks)
+            {
+                if(regionStorage.ContainsChunk(coordinates))
+                {
+                    ++doneChunks;
+                }
+                else
+                {
+                    requested.push_back(coordinates);
+                    pipeline->Request(coordinates);
+                }
+            }
+
+            std::size_t ready = 0;
+            while(ready < requested.size() && !a_Stop)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                pipeline->Update();
+
+                //Chunks published before are still in the store, so count from the start.
+                ready = static_cast<std::size_t>(std::count_if(requested.begin(), requested.end(), [&chunkStore](const glm::ivec3& a_Coordinates)
+                {
+                    return chunkStore.GetChunk(a_Coordinates) != nullptr;
+                }));
+
+                const auto elapsed = timer.measure(utilities::TimeUnit::SECONDS);
+                if(elapsed >= nextReport)
+                {
+                    nextReport = elapsed + REPORT_INTERVAL;
+                    const auto done = doneChunks + ready;
+                    logger.log(utilities::Severity::Info, "Pregenerated " + std::to_string(done) + "/" + std::to_string(totalChunks) + " chunks (" + std::to_string(done * 100 / std::max<std::size_t>(totalChunks, 1)) + "%), region " + std::to_string(i + 1) + "/" + std::to_string(batches.size()) + ", " + std::to_string(static_cast<std::uint64_t>((done - startChunks) / elapsed)) + " chunks/s.");
+                }
+            }
+
+            if(a_Stop)
+            {
+                //Keep the chunks that are done, they are skipped when resuming.
+                pipeline->WaitForJobs();
+                pipeline->Update();
+                doneChunks += ready;
+            }
+            else
+            {
+                doneChunks += requested.size();
+            }
+
+            //Writes into chunks of later regions are kept in the region files until those chunks are generated.
+            success = pendingWrites.Save() && success;
+            success = SaveAndUnload(chunkStore, regionStorage, a_ThreadPool, settings.compressChunks) && success;
+            regionStorage.Flush();
+
+            if(a_Stop)
+            {
+                break;
+            }
+
+            //Progress is only written once the region is on disk.
+            completedBatches = i + 1;
+            SaveProgress(completedBatches);
+
+            //Neighbours generated for this region are only useful if they border a region that is not done yet.
+            pendingRegions.erase(PackChunkCoordinates(batch.region));
+            pipeline->DiscardUnrequested([&pendingRegions](const glm::ivec3& a_Coordinates)
+            {
+                const auto low = RegionFile::GetRegionCoordinates(a_Coordinates - glm::ivec3(1));
+                const auto high = RegionFile::GetRegionCoordinates(a_Coordinates + glm::ivec3(1));
+                for(int y = low.y; y <= high.y; ++y)
+                {
+                    for(int z = low.z; z <= high.z; ++z)
+                    {
+                        for(int x = low.x; x <= high.x; ++x)
+                        {
+                            if(pendingRegions.count(PackChunkCoordinates(glm::ivec3(x, y, z))) != 0)
+                            {
+                                return false;
+                            }
+                        }
+                    }
+                }
+                return true;
+            });
+        }
+
+        //Jobs refer to the store and region storage.
+        pipeline.reset();
+        regionStorage.Close();
+
+        const auto elapsed = timer.measure(utilities::TimeUnit::SECONDS);
+        const auto rate = elapsed > 0.0 ? static_cast<std::uint64_t>((doneChunks - startChunks) / elapsed) : 0;
+        if(a_Stop && completedBatches < batches.size())
+        {
+            logger.log(utilities::Severity::Info, "Pregeneration of world '" + m_WorldName + "' stopped at " + std::to_string(doneChunks) + "/" + std::to_string(totalChunks) + " chunks (" + std::to_string(rate) + " chunks/s). Run it again to continue.");
+        }
+        else
+        {
+            logger.log(utilities::Severity::Info, "Pregenerated " + std::to_string(totalChunks) + " chunks of world '" + m_WorldName + "' in " + std::to_string(static_cast<std::uint64_t>(elapsed)) + " seconds (" + std::to_string(rate) + " chunks/s).");
+        }
+
+        if(!success)
+        {
+            logger.log(utilities::Severity::Error, "Some chunks of world '" + m_WorldName + "' could not be saved during pregeneration.");
+        }
+        return success;
+    }
+
+    std::vector<Pregenerator::Batch> Pregenerator::CreateBatches() const
+    {
+        std::vector<Batch> batches;
+        std::unordered_map<std::uint64_t, std::size_t> lookup;
+
+        const auto radius = std::max(m_Area.radius, 0);
+        for(int z = -radius; z <= radius; ++z)
+        {
+            for(int x = -radius; x <= radius; ++x)
+            {
+                if(x * x + z * z > radius * radius)
+                {
+                    continue;
+                }
+
+                for(int y = m_Area.minY; y <= m_Area.maxY; ++y)
+                {
+                    const glm::ivec3 coordinates(m_Area.center.x + x, y, m_Area.center.y + z);
+                    const auto region = RegionFile::GetRegionCoordinates(coordinates);
+                    const auto found = lookup.emplace(PackChunkCoordinates(region), batches.size());
+                    if(found.second)
+                    {
+                        batches.push_back({ region, {} });
+                    }
+                    batches[found.first->second].chunks.push_back(coordinates);
+                }
+            }
+        }
+
+        //Closest regions first, so that the area around the center is usable soonest. The order has to be stable for resuming.
+        const auto center = glm::vec2(m_Area.center);
+        std::sort(batches.begin(), batches.end(), [&center](const Batch& a_Left, const Batch& a_Right)
+        {
+            const auto size = static_cast<float>(RegionFile::REGION_SIZE);
+            const auto left = glm::vec2(a_Left.region.x, a_Left.region.z) * size + size / 2.0f - center;
+            const auto right = glm::vec2(a_Right.region.x, a_Right.region.z) * size + size / 2.0f - center;
+            const auto leftDistance = left.x * left.x + left.y * left.y;
+            const auto rightDistance = right.x * right.x + right.y * right.y;
+            if(leftDistance != rightDistance)
+            {
+                return leftDistance < rightDistance;
+            }
+            return PackChunkCoordinates(a_Left.region) < PackChunkCoordinates(a_Right.region);
+        });
+
+        return batches;
+    }
+
+    std::uint32_t Pregenerator::LoadProgress() const
+    {
+        const auto path = m_Directory + PROGRESS_FILE_NAME;
+        if(!utilities::FileUtilities::FileExists(path))
+        {
+            return 0;
+        }
+
+        std::ifstream ifs(path);
+        const auto json = nlohmann::json::parse(ifs, nullptr, false);
+        PregenerationArea area;
+        std::uint32_t completed = 0;
+        if(json.is_discarded()
+            || !JsonUtilities::VerifyValue("centerX", json, area.center.x) || !JsonUtilities::VerifyValue("centerZ", json, area.center.y)
+            || !JsonUtilities::VerifyValue("radius", json, area.radius) || !JsonUtilities::VerifyValue("minY", json, area.minY) || !JsonUtilities::VerifyValue("maxY", json, area.maxY)
+            || !JsonUtilities::VerifyValue("completedRegions", json, completed))
+        {
+            return 0;
+        }
+
+        //A different area has a different order of regions.
+        if(area.center != m_Area.center || area.radius != m_Area.radius || area.minY != m_Area.minY || area.maxY != m_Area.maxY)
+        {
+            return 0;
+        }
+        return completed;
+    }
+
+    void Pregenerator::SaveProgress(std::uint32_t a_CompletedBatches) const
+    {
+        nlohmann::json json;
+        json["centerX"] = m_Area.center.x;
+        json["centerZ"] = m_Area.center.y;
+        json["radius"] = m_Area.radius;
+        json["minY"] = m_Area.minY;
+        json["maxY"] = m_Area.maxY;
+        json["completedRegions"] = a_CompletedBatches;
+
+        const auto path = m_Directory + PROGRESS_FILE_NAME;
+        utilities::FileUtilities::CreateFile(path);
+        std::ofstream file(path);
+        file << json;
+    }
+
+    bool Pregenerator::SaveAndUnload(ChunkStore& a_ChunkStore, RegionStorage& a_RegionStorage, utilities::ThreadPool& a_ThreadPool, bool a_Compress)
+    {
+        std::vector<std::uint64_t> dirty;
+        a_ChunkStore.TakeDirtyChunks(dirty);
+
+        std::atomic<std::size_t> remaining(0);
+        std::atomic<std::size_t> failed(0);
+        for(const auto key : dirty)
+        {
+            auto* chunk = static_cast<Chunk*>(a_ChunkStore.GetChunk(UnpackChunkCoordinates(key)));
+            if(chunk == nullptr || !chunk->IsDirty())
+            {
+                continue;
+            }
+
+            ++remaining;
+            a_ThreadPool.enqueue([chunk, a_Compress, &a_RegionStorage, &remaining, &failed]()
+            {
+                std::vector<std::uint8_t> data;
+                chunk->Serialize(data);
+                if(a_Compress)
+                {
+                    Chunk::CompactSerialized(data);
+                }
+
+                if(!a_RegionStorage.SaveChunkData(chunk->GetChunkCoordinates(), data.data(), data.size()))
+                {
+                    ++failed;
+                }
+                --remaining;
+            });
+        }
+
+        while(remaining != 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        a_ChunkStore.UnloadAll();
+        return failed == 0;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+namespace utilities
+{
+    class ThreadPool;
+}
+
+namespace voxl
+{
+    class ChunkStore;
+    class IWorldGenerator;
+    class RegionStorage;
+    struct WorldSettings;
+
+    /*
+     * The chunks to pregenerate: a cylinder of chunk columns around a center.
+     */
+    struct PregenerationArea
+    {
+        glm::ivec2 center = glm::ivec2(0, 0);  //Chunk x and z of the center.
+        std::int32_t radius = 16;               //Columns at most this many chunks from the center are generated.
+        std::int32_t minY = -4;                 //Lowest chunk y to generate.
+        std::int32_t maxY = 8;                  //Highest chunk y to generate.
+    };
+
+    /*
+     * Generates, populates and saves the chunks in an area of a world without running the server, so players never wait for them.
+     *
+     * The area is processed one region file at a time, starting closest to the center.
+     * Only the chunks of the current region and the neighbours needed to populate them are in memory, which bounds memory use.
+     * All work is done on the thread pool, the calling thread only moves chunks along and reports progress.
+     *
+     * Progress is stored in the world directory after every finished region, so an interrupted run continues where it left off.
+     * Chunks that are already on disk are never generated again.
+     */
+    class Pregenerator
+    {
+    public:
+        //Seconds between progress reports.
+        static constexpr double REPORT_INTERVAL = 5.0;
+
+        //Name of the progress file in the world directory.
+        static constexpr const char* PROGRESS_FILE_NAME = "pregeneration.json";
+
+    public:
+        Pregenerator(const std::string& a_WorldName, const PregenerationArea& a_Area);
+
+        /*
+         * Pregenerate the area. a_GetGenerator creates the generator named in the world's settings, set up the way the world was created.
+         * Stops early, but keeps all finished chunks, when a_Stop is set.
+         * Returns false if the world could not be loaded or chunks could not be saved.
+         */
+        bool Run(const std::function<std::shared_ptr<IWorldGenerator>(const WorldSettings&)>& a_GetGenerator, utilities::ThreadPool& a_ThreadPool, const std::atomic<bool>& a_Stop);
+
+    private:
+        /*
+         * The chunks of the area that are in one region file.
+         */
+        struct Batch
+        {
+            glm::ivec3 region;
+            std::vector<glm::ivec3> chunks;
+        };
+
+        /*
+         * Split the area into batches, ordered by distance from the center.
+         */
+        std::vector<Batch> CreateBatches() const;
+
+        /*
+         * Read and write the amount of finished batches. Progress is only used when it was made for the same area.
+         */
+        std::uint32_t LoadProgress() const;
+        void SaveProgress(std::uint32_t a_CompletedBatches) const;
+
+        /*
+         * Save all changed chunks in the store on the thread pool and remove every chunk from the store.
+         * Returns false if any chunk could not be saved.
+         */
+        bool SaveAndUnload(ChunkStore& a_ChunkStore, RegionStorage& a_RegionStorage, utilities::ThreadPool& a_ThreadPool, bool a_Compress);
+
+    private:
+        std::string m_WorldName;
+        std::string m_Directory;
+        PregenerationArea m_Area;
+    };
+}
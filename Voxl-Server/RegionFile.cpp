@@ -0,0 +1,351 @@
+#include "RegionFile.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+
+#include <compression/LzCodec.h>
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+
+namespace voxl
+{
+    RegionFile::RegionFile(const std::string& a_Path) : m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr), m_View(nullptr), m_MappedSize(0), m_FileSize(0), m_Entries()
+    {
+        const auto path = std::filesystem::path(a_Path);
+        std::filesystem::create_directories(path.parent_path());
+
+        m_File = CreateFileW(path.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(m_File == INVALID_HANDLE_VALUE)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Could not open region file '" + a_Path + "'.");
+            return;
+        }
+
+        LARGE_INTEGER size;
+        GetFileSizeEx(m_File, &size);
+        m_FileSize = static_cast<std::uint64_t>(size.QuadPart);
+
+        //New file, write an empty header.
+        if(m_FileSize == 0)
+        {
+            std::vector<std::uint8_t> header(HEADER_SECTORS * SECTOR_SIZE, 0);
+            std::memcpy(header.data(), &MAGIC, sizeof(MAGIC));
+            std::memcpy(header.data() + 4, &VERSION, sizeof(VERSION));
+            if(!WriteAt(0, header.data(), header.size()))
+            {
+                CloseHandle(m_File);
+                m_File = INVALID_HANDLE_VALUE;
+                return;
+            }
+            m_FileSize = header.size();
+        }
+
+        if(m_FileSize < HEADER_SECTORS * SECTOR_SIZE || !Map())
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Region file '" + a_Path + "' is too small to contain a header.");
+            CloseHandle(m_File);
+            m_File = INVALID_HANDLE_VALUE;
+            return;
+        }
+
+        std::uint32_t magic, version;
+        std::memcpy(&magic, m_View, sizeof(magic));
+        std::memcpy(&version, m_View + 4, sizeof(version));
+        if(magic != MAGIC || version != VERSION)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Region file '" + a_Path + "' has an invalid header.");
+            Unmap();
+            CloseHandle(m_File);
+            m_File = INVALID_HANDLE_VALUE;
+            return;
+        }
+
+        //Rebuild the sector usage from the header. Entries pointing outside the file are dropped.
+        std::memcpy(m_Entries.data(), m_View + 8, ENTRY_COUNT * sizeof(std::uint32_t));
+        const auto sectorCount = static_cast<std::uint32_t>((m_FileSize + SECTOR_SIZE - 1) / SECTOR_SIZE);
+        m_UsedSectors.assign(sectorCount, false);
+        std::fill_n(m_UsedSectors.begin(), HEADER_SECTORS, true);
+        for(auto& entry : m_Entries)
+        {
+            if(entry == 0)
+            {
+                continue;
+            }
+
+            const auto offset = GetSectorOffset(entry);
+            const auto count = GetSectorCount(entry);
+            if(offset < HEADER_SECTORS || count == 0 || offset + count > sectorCount)
+            {
+                entry = 0;
+                continue;
+            }
+            std::fill_n(m_UsedSectors.begin() + offset, count, true);
+        }
+    }
+
+    RegionFile::~RegionFile()
+    {
+        Unmap();
+        if(m_File != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_File);
+        }
+    }
+
+    bool RegionFile::IsOpen() const
+    {
+        return m_File != INVALID_HANDLE_VALUE;
+    }
+
+    bool RegionFile::Contains(std::uint32_t a_Index)
+    {
+        assert(a_Index < ENTRY_COUNT);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Entries[a_Index] != 0;
+    }
+
+    bool RegionFile::Read(std::uint32_t a_Index, const std::function<bool(const std::uint8_t*, std::size_t)>& a_Reader)
+    {
+        assert(a_Index < ENTRY_COUNT);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        const auto entry = m_Entries[a_Index];
+        if(entry == 0 || !Map())
+        {
+            return false;
+        }
+
+        const auto start = static_cast<std::uint64_t>(GetSectorOffset(entry)) * SECTOR_SIZE;
+        const auto capacity = static_cast<std::uint64_t>(GetSectorCount(entry)) * SECTOR_SIZE;
+        const auto* record = m_View + start;
+
+        std::uint32_t length;
+        std::memcpy(&length, record, sizeof(length));
+        const auto compression = static_cast<RegionCompression>(record[4]);
+        if(length + RECORD_HEADER_SIZE > capacity || start + RECORD_HEADER_SIZE + length > m_MappedSize)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Region file contains a corrupt chunk record.");
+            return false;
+        }
+
+        const auto* payload = record + RECORD_HEADER_SIZE;
+        if(compression == RegionCompression::NONE)
+        {
+            return a_Reader(payload, length);
+        }
+        if(compression == RegionCompression::LZ)
+        {
+            m_Decompressed.clear();
+            utilities::LzDecoder decoder(m_Decompressed);
+            if(decoder.write(payload, length) && decoder.isFinished())
+            {
+                return a_Reader(m_Decompressed.data(), m_Decompressed.size());
+            }
+        }
+
+        utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Region file contains a chunk record that could not be decompressed.");
+        return false;
+    }
+
+    bool RegionFile::Write(std::uint32_t a_Index, const std::uint8_t* a_Data, std::size_t a_Size, bool a_Compress)
+    {
+        assert(a_Index < ENTRY_COUNT);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if(!IsOpen())
+        {
+            return false;
+        }
+
+        auto compression = RegionCompression::NONE;
+        const std::uint8_t* payload = a_Data;
+        std::size_t length = a_Size;
+
+        //Only keep the compressed version if it actually saves space.
+        if(a_Compress)
+        {
+            m_Compressed.clear();
+            utilities::LzEncoder encoder(m_Compressed);
+            encoder.write(a_Data, a_Size);
+            encoder.finish();
+            if(m_Compressed.size() < a_Size)
+            {
+                compression = RegionCompression::LZ;
+                payload = m_Compressed.data();
+                length = m_Compressed.size();
+            }
+        }
+
+        const auto sectors = static_cast<std::uint32_t>((length + RECORD_HEADER_SIZE + SECTOR_SIZE - 1) / SECTOR_SIZE);
+        if(sectors > 0xFF)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Chunk record is too large to store in a region file.");
+            return false;
+        }
+
+        //The old record stays intact until the header points to the new one, so a failed or interrupted write never loses it.
+        const auto oldEntry = m_Entries[a_Index];
+        const auto offset = AllocateSectors(sectors);
+
+        //Pad the record to whole sectors so the file size stays sector aligned.
+        std::vector<std::uint8_t> record(static_cast<std::size_t>(sectors) * SECTOR_SIZE, 0);
+        const auto length32 = static_cast<std::uint32_t>(length);
+        std::memcpy(record.data(), &length32, sizeof(length32));
+        record[4] = static_cast<std::uint8_t>(compression);
+        std::memcpy(record.data() + RECORD_HEADER_SIZE, payload, length);
+
+        if(!WriteAt(static_cast<std::uint64_t>(offset) * SECTOR_SIZE, record.data(), record.size()))
+        {
+            std::fill_n(m_UsedSectors.begin() + offset, sectors, false);
+            return false;
+        }
+        m_FileSize = std::max(m_FileSize, static_cast<std::uint64_t>(offset + sectors) * SECTOR_SIZE);
+
+        m_Entries[a_Index] = (offset << 8) | sectors;
+        if(!WriteEntry(a_Index))
+        {
+            m_Entries[a_Index] = oldEntry;
+            std::fill_n(m_UsedSectors.begin() + offset, sectors, false);
+            return false;
+        }
+
+        //Only now that nothing points to the old record anymore can its sectors be reused.
+        FreeSectors(oldEntry);
+        return true;
+    }
+
+    bool RegionFile::Erase(std::uint32_t a_Index)
+    {
+        assert(a_Index < ENTRY_COUNT);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if(m_Entries[a_Index] == 0)
+        {
+            return false;
+        }
+
+        FreeSectors(m_Entries[a_Index]);
+        m_Entries[a_Index] = 0;
+        return WriteEntry(a_Index);
+    }
+
+    void RegionFile::Flush()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(IsOpen())
+        {
+            FlushFileBuffers(m_File);
+        }
+    }
+
+    std::uint32_t RegionFile::GetChunkIndex(const glm::ivec3& a_ChunkCoordinates)
+    {
+        const auto x = static_cast<std::uint32_t>(a_ChunkCoordinates.x & (REGION_SIZE - 1));
+        const auto y = static_cast<std::uint32_t>(a_ChunkCoordinates.y & (REGION_SIZE - 1));
+        const auto z = static_cast<std::uint32_t>(a_ChunkCoordinates.z & (REGION_SIZE - 1));
+        return x + z * REGION_SIZE + y * REGION_SIZE * REGION_SIZE;
+    }
+
+    glm::ivec3 RegionFile::GetRegionCoordinates(const glm::ivec3& a_ChunkCoordinates)
+    {
+        //Arithmetic shift rounds towards negative infinity, so negative chunks end up in the right region.
+        return glm::ivec3(a_ChunkCoordinates.x >> 4, a_ChunkCoordinates.y >> 4, a_ChunkCoordinates.z >> 4);
+    }
+
+    bool RegionFile::Map()
+    {
+        if(m_View != nullptr && m_MappedSize == m_FileSize)
+        {
+            return true;
+        }
+
+        Unmap();
+
+        m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(m_Mapping == nullptr)
+        {
+            return false;
+        }
+
+        m_View = static_cast<const std::uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        if(m_View == nullptr)
+        {
+            CloseHandle(m_Mapping);
+            m_Mapping = nullptr;
+            return false;
+        }
+
+        m_MappedSize = m_FileSize;
+        return true;
+    }
+
+    void RegionFile::Unmap()
+    {
+        if(m_View != nullptr)
+        {
+            UnmapViewOfFile(m_View);
+            m_View = nullptr;
+        }
+        if(m_Mapping != nullptr)
+        {
+            CloseHandle(m_Mapping);
+            m_Mapping = nullptr;
+        }
+        m_MappedSize = 0;
+    }
+
+    bool RegionFile::WriteAt(std::uint64_t a_Offset, const void* a_Data, std::size_t a_Size)
+    {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(a_Offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(a_Offset >> 32);
+
+        DWORD written = 0;
+        if(!WriteFile(m_File, a_Data, static_cast<DWORD>(a_Size), &written, &overlapped) || written != a_Size)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Could not write to region file.");
+            return false;
+        }
+        return true;
+    }
+
+    bool RegionFile::WriteEntry(std::uint32_t a_Index)
+    {
+        return WriteAt(8 + static_cast<std::uint64_t>(a_Index) * sizeof(std::uint32_t), &m_Entries[a_Index], sizeof(std::uint32_t));
+    }
+
+    std::uint32_t RegionFile::AllocateSectors(std::uint32_t a_Count)
+    {
+        //First fit. Regions are small enough that a linear scan is cheap compared to the write itself.
+        std::uint32_t run = 0;
+        for(std::uint32_t i = HEADER_SECTORS; i < static_cast<std::uint32_t>(m_UsedSectors.size()); ++i)
+        {
+            run = m_UsedSectors[i] ? 0 : run + 1;
+            if(run == a_Count)
+            {
+                const auto offset = i + 1 - a_Count;
+                std::fill_n(m_UsedSectors.begin() + offset, a_Count, true);
+                return offset;
+            }
+        }
+
+        //No gap is large enough, so append. A free run at the end of the file is extended.
+        const auto offset = static_cast<std::uint32_t>(m_UsedSectors.size()) - run;
+        m_UsedSectors.resize(offset + a_Count, false);
+        std::fill_n(m_UsedSectors.begin() + offset, a_Count, true);
+        return offset;
+    }
+
+    void RegionFile::FreeSectors(std::uint32_t a_Entry)
+    {
+        if(a_Entry != 0)
+        {
+            std::fill_n(m_UsedSectors.begin() + GetSectorOffset(a_Entry), GetSectorCount(a_Entry), false);
+        }
+    }
+}
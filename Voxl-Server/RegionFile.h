@@ -0,0 +1,164 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+namespace voxl
+{
+    /*
+     * The way a chunk record is compressed inside a region file.
+     */
+    enum class RegionCompression : std::uint8_t
+    {
+        NONE = 0,   //Stored as is.
+        LZ = 1      //An LzEncoder stream.
+    };
+
+    /*
+     * A single file storing up to REGION_SIZE^3 chunks.
+     *
+     * The file starts with a fixed header containing one entry per chunk, followed by 4 KB sectors.
+     * Each entry holds the first sector and the amount of sectors of the chunk record, or 0 if the chunk is not stored.
+     * One extra entry after the chunks points to the record with writes waiting for chunks in this region, see PendingWriteStore.
+     * Sectors freed by chunks that moved or shrank are reused for later writes.
+     *
+     * Reads go through a read-only memory mapping of the file, so uncompressed records are handed out without copying.
+     * Writes go through the file handle, which stays coherent with the mapping.
+     */
+    class RegionFile
+    {
+    public:
+        //Amount of chunks along each axis of a region.
+        static constexpr std::int32_t REGION_SIZE = 16;
+        static constexpr std::uint32_t CHUNKS_PER_REGION = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+        static constexpr std::uint32_t SECTOR_SIZE = 4096;
+        static constexpr std::uint32_t MAGIC = 0x47525856;    //"VXRG"
+        static constexpr std::uint32_t VERSION = 1;
+
+        //Index of the record holding pending writes, which comes after the chunk entries in the header.
+        static constexpr std::uint32_t PENDING_WRITES_INDEX = CHUNKS_PER_REGION;
+        static constexpr std::uint32_t ENTRY_COUNT = CHUNKS_PER_REGION + 1;
+
+        //Magic and version, followed by one 32 bit entry per record. Rounded up to whole sectors.
+        static constexpr std::uint32_t HEADER_SIZE = 8 + ENTRY_COUNT * 4;
+        static constexpr std::uint32_t HEADER_SECTORS = (HEADER_SIZE + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+        //Every record starts with the payload length and the compression type.
+        static constexpr std::uint32_t RECORD_HEADER_SIZE = 5;
+
+    public:
+        /*
+         * Open or create the region file at the given path.
+         * Check IsOpen to see whether this succeeded.
+         */
+        explicit RegionFile(const std::string& a_Path);
+        ~RegionFile();
+
+        RegionFile(const RegionFile&) = delete;
+        RegionFile& operator=(const RegionFile&) = delete;
+
+        /*
+         * Returns true if the file was opened and has a valid header.
+         */
+        bool IsOpen() const;
+
+        /*
+         * Returns true if a record is stored at the given index.
+         */
+        bool Contains(std::uint32_t a_Index);
+
+        /*
+         * Read the record at the given index, a chunk index or PENDING_WRITES_INDEX, and pass the uncompressed bytes to a_Reader.
+         * The bytes are only valid during the call. Returns false if the chunk is not stored, the record is invalid, or a_Reader returns false.
+         */
+        bool Read(std::uint32_t a_Index, const std::function<bool(const std::uint8_t*, std::size_t)>& a_Reader);
+
+        /*
+         * Store a_Size bytes as the record at the given index, replacing the old record.
+         * With a_Compress set, the data is LZ compressed if that makes it smaller. Chunk records are encoded by ChunkCodec already, so they are stored as is.
+         * The new record is written to free sectors before the header points to it,
+         * so the old record is kept when the write fails.
+         */
+        bool Write(std::uint32_t a_Index, const std::uint8_t* a_Data, std::size_t a_Size, bool a_Compress);
+
+        /*
+         * Remove the record at the given index and free its sectors.
+         */
+        bool Erase(std::uint32_t a_Index);
+
+        /*
+         * Flush all written data to disk.
+         */
+        void Flush();
+
+        /*
+         * Get the index of a chunk within its region.
+         */
+        static std::uint32_t GetChunkIndex(const glm::ivec3& a_ChunkCoordinates);
+
+        /*
+         * Get the coordinates of the region containing the given chunk.
+         */
+        static glm::ivec3 GetRegionCoordinates(const glm::ivec3& a_ChunkCoordinates);
+
+    private:
+        /*
+         * Map the file for reading if it is not mapped yet, or if it grew since it was mapped.
+         */
+        bool Map();
+
+        /*
+         * Remove the current mapping.
+         */
+        void Unmap();
+
+        /*
+         * Write to the file at the given byte offset.
+         */
+        bool WriteAt(std::uint64_t a_Offset, const void* a_Data, std::size_t a_Size);
+
+        /*
+         * Write the header entry for the given chunk.
+         */
+        bool WriteEntry(std::uint32_t a_Index);
+
+        /*
+         * Find a_Count consecutive free sectors and mark them as used. The file is extended if needed.
+         */
+        std::uint32_t AllocateSectors(std::uint32_t a_Count);
+
+        /*
+         * Mark the sectors used by the given header entry as free.
+         */
+        void FreeSectors(std::uint32_t a_Entry);
+
+        static std::uint32_t GetSectorOffset(std::uint32_t a_Entry) { return a_Entry >> 8; }
+        static std::uint32_t GetSectorCount(std::uint32_t a_Entry) { return a_Entry & 0xFF; }
+
+    private:
+        std::mutex m_Mutex;
+
+        //Win32 handles, stored as void* to keep windows.h out of this header.
+        void* m_File;
+        void* m_Mapping;
+        const std::uint8_t* m_View;
+        std::uint64_t m_MappedSize;
+        std::uint64_t m_FileSize;
+
+        //Sector offset (upper 24 bits) and sector count (lower 8 bits) for every chunk, followed by the pending writes.
+        std::array<std::uint32_t, ENTRY_COUNT> m_Entries;
+
+        //One flag per sector in the file, true when the sector is in use.
+        std::vector<bool> m_UsedSectors;
+
+        //Scratch buffers reused between calls.
+        std::vector<std::uint8_t> m_Compressed;
+        std::vector<std::uint8_t> m_Decompressed;
+    };
+}
@@ -0,0 +1,159 @@
+#include "RegionStorage.h"
+
+#include <vector>
+
+#include <Utility.h>
+#include <file/FileUtilities.h>
+
+#include "Chunk.h"
+
+namespace voxl
+{
+    RegionStorage::RegionStorage(const std::string& a_Directory) : m_Directory(a_Directory), m_UseCounter(0)
+    {
+
+    }
+
+    bool RegionStorage::SaveChunk(Chunk& a_Chunk, bool a_Compress)
+    {
+        std::vector<std::uint8_t> data;
+        a_Chunk.Serialize(data);
+        if(a_Compress)
+        {
+            Chunk::CompactSerialized(data);
+        }
+        return SaveChunkData(a_Chunk.GetChunkCoordinates(), data.data(), data.size());
+    }
+
+    bool RegionStorage::SaveChunkData(const glm::ivec3& a_Coordinates, const std::uint8_t* a_Data, std::size_t a_Size)
+    {
+        const auto region = GetRegion(a_Coordinates, true);
+        if(region == nullptr)
+        {
+            return false;
+        }
+        return region->Write(RegionFile::GetChunkIndex(a_Coordinates), a_Data, a_Size, false);
+    }
+
+    bool RegionStorage::LoadChunk(Chunk& a_Chunk)
+    {
+        const auto coordinates = a_Chunk.GetChunkCoordinates();
+        const auto region = GetRegion(coordinates, false);
+        if(region == nullptr)
+        {
+            return false;
+        }
+
+        //Deserialize straight from the mapped file.
+        return region->Read(RegionFile::GetChunkIndex(coordinates), [&](const std::uint8_t* a_Data, std::size_t a_Size)
+        {
+            return a_Chunk.Deserialize(a_Data, a_Size);
+        });
+    }
+
+    bool RegionStorage::ContainsChunk(const glm::ivec3& a_Coordinates)
+    {
+        const auto region = GetRegion(a_Coordinates, false);
+        return region != nullptr && region->Contains(RegionFile::GetChunkIndex(a_Coordinates));
+    }
+
+    bool RegionStorage::LoadPendingWrites(const glm::ivec3& a_ChunkCoordinates, std::vector<std::uint8_t>& a_Data)
+    {
+        const auto region = GetRegion(a_ChunkCoordinates, false);
+        if(region == nullptr)
+        {
+            return false;
+        }
+
+        return region->Read(RegionFile::PENDING_WRITES_INDEX, [&](const std::uint8_t* a_Bytes, std::size_t a_Size)
+        {
+            a_Data.assign(a_Bytes, a_Bytes + a_Size);
+            return true;
+        });
+    }
+
+    bool RegionStorage::SavePendingWrites(const glm::ivec3& a_ChunkCoordinates, const std::vector<std::uint8_t>& a_Data)
+    {
+        //Do not create a region file just to record that nothing is pending.
+        const auto region = GetRegion(a_ChunkCoordinates, !a_Data.empty());
+        if(region == nullptr)
+        {
+            return a_Data.empty();
+        }
+
+        if(a_Data.empty())
+        {
+            return !region->Contains(RegionFile::PENDING_WRITES_INDEX) || region->Erase(RegionFile::PENDING_WRITES_INDEX);
+        }
+        return region->Write(RegionFile::PENDING_WRITES_INDEX, a_Data.data(), a_Data.size(), true);
+    }
+
+    void RegionStorage::Flush()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for(auto& region : m_Regions)
+        {
+            region.second.file->Flush();
+        }
+    }
+
+    void RegionStorage::Close()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for(auto& region : m_Regions)
+        {
+            region.second.file->Flush();
+        }
+        m_Regions.clear();
+    }
+
+    std::shared_ptr<RegionFile> RegionStorage::GetRegion(const glm::ivec3& a_ChunkCoordinates, bool a_Create)
+    {
+        const auto coordinates = RegionFile::GetRegionCoordinates(a_ChunkCoordinates);
+        const auto key = PackChunkCoordinates(coordinates);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_UseCounter;
+
+        const auto found = m_Regions.find(key);
+        if(found != m_Regions.end())
+        {
+            found->second.lastUse = m_UseCounter;
+            return found->second.file;
+        }
+
+        const auto path = m_Directory + "r." + std::to_string(coordinates.x) + "." + std::to_string(coordinates.y) + "." + std::to_string(coordinates.z) + ".vxr";
+        if(!a_Create && !utilities::FileUtilities::FileExists(path))
+        {
+            return nullptr;
+        }
+
+        //Close the least recently used region to stay within the limit.
+        //Regions that are still being read or written are skipped, as opening the file a second time would fail.
+        if(m_Regions.size() >= MAX_OPEN_REGIONS)
+        {
+            auto oldest = m_Regions.end();
+            for(auto itr = m_Regions.begin(); itr != m_Regions.end(); ++itr)
+            {
+                if(itr->second.file.use_count() == 1 && (oldest == m_Regions.end() || itr->second.lastUse < oldest->second.lastUse))
+                {
+                    oldest = itr;
+                }
+            }
+            if(oldest != m_Regions.end())
+            {
+                oldest->second.file->Flush();
+                m_Regions.erase(oldest);
+            }
+        }
+
+        auto file = std::make_shared<RegionFile>(path);
+        if(!file->IsOpen())
+        {
+            return nullptr;
+        }
+
+        m_Regions.emplace(key, OpenRegion{ file, m_UseCounter });
+        return file;
+    }
+}
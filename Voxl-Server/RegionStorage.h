@@ -0,0 +1,95 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "RegionFile.h"
+
+namespace voxl
+{
+    class Chunk;
+
+    /*
+     * Saves and loads the chunks of a world to region files in a single directory.
+     * A limited amount of region files is kept open. The least recently used one is closed when the limit is reached.
+     */
+    class RegionStorage
+    {
+    public:
+        //Maximum amount of region files that are open at the same time.
+        static constexpr std::size_t MAX_OPEN_REGIONS = 64;
+
+    public:
+        /*
+         * Create region storage for the given directory, for example "worlds/<name>/regions/".
+         */
+        explicit RegionStorage(const std::string& a_Directory);
+
+        /*
+         * Write the chunk to its region file. With a_Compress set, the record is compacted with Chunk::CompactSerialized first.
+         */
+        bool SaveChunk(Chunk& a_Chunk, bool a_Compress);
+
+        /*
+         * Write chunk data produced by Chunk::Serialize to the region file of the chunk at the given coordinates.
+         * The data is stored as is, compressing it is up to Chunk::CompactSerialized. This can be called from any thread.
+         */
+        bool SaveChunkData(const glm::ivec3& a_Coordinates, const std::uint8_t* a_Data, std::size_t a_Size);
+
+        /*
+         * Read the chunk at the chunk's coordinates from its region file.
+         * Returns false if the chunk was never saved or the stored data is invalid.
+         */
+        bool LoadChunk(Chunk& a_Chunk);
+
+        /*
+         * Returns true if a chunk is stored at the given coordinates.
+         */
+        bool ContainsChunk(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Read the pending writes record of the region containing the given chunk into a_Data.
+         * Returns false if the region has no such record or it could not be read.
+         */
+        bool LoadPendingWrites(const glm::ivec3& a_ChunkCoordinates, std::vector<std::uint8_t>& a_Data);
+
+        /*
+         * Replace the pending writes record of the region containing the given chunk. An empty record is removed.
+         */
+        bool SavePendingWrites(const glm::ivec3& a_ChunkCoordinates, const std::vector<std::uint8_t>& a_Data);
+
+        /*
+         * Flush all open region files to disk.
+         */
+        void Flush();
+
+        /*
+         * Flush and close all open region files.
+         */
+        void Close();
+
+    private:
+        /*
+         * Get the open region file containing the given chunk, opening it when needed.
+         * Missing files are only created when a_Create is true.
+         * Returns nullptr if the file does not exist or could not be opened.
+         */
+        std::shared_ptr<RegionFile> GetRegion(const glm::ivec3& a_ChunkCoordinates, bool a_Create);
+
+    private:
+        struct OpenRegion
+        {
+            std::shared_ptr<RegionFile> file;
+            std::uint64_t lastUse;
+        };
+
+        std::string m_Directory;
+
+        //Guards the open region map. Region files have their own lock for reading and writing.
+        std::mutex m_Mutex;
+        std::unordered_map<std::uint64_t, OpenRegion> m_Regions;
+        std::uint64_t m_UseCounter;
+    };
+}
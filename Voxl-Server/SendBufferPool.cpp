@@ -0,0 +1,52 @@
+#include "SendBufferPool.h"
+
+#include <algorithm>
+
+#include <enet/enet.h>
+
+namespace voxl
+{
+    SendBufferPool::SendBufferPool()
+    {
+        for(auto size = MIN_SIZE; size <= MAX_SIZE; size *= 2)
+        {
+            const auto blockSize = static_cast<std::uint32_t>(size + sizeof(Header));
+            const auto slotsPerSlab = static_cast<std::uint32_t>(std::max<std::size_t>(SLAB_SIZE / blockSize, 4));
+            m_Classes.push_back(std::make_unique<utilities::SlabPool>(slotsPerSlab, blockSize));
+        }
+    }
+
+    _ENetPacket* SendBufferPool::CreatePacket(std::size_t a_Size, std::uint32_t a_Flags)
+    {
+        if(a_Size > MAX_SIZE)
+        {
+            return enet_packet_create(nullptr, a_Size, a_Flags);
+        }
+
+        std::size_t sizeClass = 0;
+        while((MIN_SIZE << sizeClass) < a_Size)
+        {
+            ++sizeClass;
+        }
+
+        auto* header = static_cast<Header*>(m_Classes[sizeClass]->allocate());
+        header->pool = this;
+        header->sizeClass = sizeClass;
+
+        auto* packet = enet_packet_create(header + 1, a_Size, a_Flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+        if(packet == nullptr)
+        {
+            m_Classes[sizeClass]->free(header);
+            return nullptr;
+        }
+        packet->userData = header;
+        packet->freeCallback = &SendBufferPool::FreePacket;
+        return packet;
+    }
+
+    void SendBufferPool::FreePacket(_ENetPacket* a_Packet)
+    {
+        auto* header = static_cast<Header*>(a_Packet->userData);
+        header->pool->m_Classes[header->sizeClass]->free(header);
+    }
+}
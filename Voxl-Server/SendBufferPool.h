@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <memory/SlabPool.h>
+
+struct _ENetPacket;
+
+namespace voxl
+{
+    /*
+     * Recycles the buffers of outgoing ENet packets, so that sending does not allocate once the pool has warmed up.
+     *
+     * Buffers come in power of two size classes from MIN_SIZE to MAX_SIZE, each backed by a SlabPool.
+     * Packets are created without ENet allocating their data, and return their buffer to the pool when ENet destroys them.
+     * Larger packets are allocated by ENet itself.
+     *
+     * The pool has to outlive every packet created from it, so it should be destroyed after the ENet host.
+     */
+    class SendBufferPool
+    {
+    public:
+        //Smallest and largest pooled buffer. The largest fits a chunk with an incompressible palette.
+        static constexpr std::size_t MIN_SIZE = 64;
+        static constexpr std::size_t MAX_SIZE = 64 * 1024;
+
+        //Memory allocated at once per size class.
+        static constexpr std::size_t SLAB_SIZE = 256 * 1024;
+
+    public:
+        SendBufferPool();
+
+        SendBufferPool(const SendBufferPool&) = delete;
+        SendBufferPool& operator=(const SendBufferPool&) = delete;
+
+        /*
+         * Create a packet of a_Size bytes with the given ENet packet flags. The data is not initialized.
+         */
+        _ENetPacket* CreatePacket(std::size_t a_Size, std::uint32_t a_Flags);
+
+    private:
+        /*
+         * Stored in front of the data of every pooled buffer.
+         */
+        struct Header
+        {
+            SendBufferPool* pool;
+            std::size_t sizeClass;
+        };
+
+        /*
+         * Called by ENet when a pooled packet is destroyed.
+         */
+        static void FreePacket(_ENetPacket* a_Packet);
+
+    private:
+        std::vector<std::unique_ptr<utilities::SlabPool>> m_Classes;
+    };
+}
@@ -1,6 +1,8 @@
 #include "Server.h"
 
+#include <algorithm>
 #include <ctime>
+#include <thread>
 
 #include <file/FileUtilities.h>
 #include <IWorld.h>
@@ -65,6 +67,11 @@ namespace voxl
         {
             world.second->Tick(a_DeltaTime);
         }
+
+        /*
+         * Send the packets written to each client during this tick.
+         */
+        m_ConnectionManager->FlushClientConnections();
     }
 
     void Server::RegisterWorldGenerator(const std::string& a_Name, std::shared_ptr<IWorldGenerator>& a_Generator)
@@ -140,8 +147,13 @@ namespace voxl
 
             }
 
+            //Start the background workers before any world can use them.
+            m_ThreadPool = std::make_unique<utilities::ThreadPool>(std::max(2u, std::thread::hardware_concurrency()) - 1);
+
             //Register the default world generator and default gamemode.
-            std::shared_ptr<IWorldGenerator> generator = std::make_shared<DefaultWorldGenerator>();
+            DefaultGeneratorSettings generatorSettings;
+            generatorSettings.climateSpacing = m_Settings.climateSpacing;
+            std::shared_ptr<IWorldGenerator> generator = std::make_shared<DefaultWorldGenerator>(generatorSettings);
             RegisterWorldGenerator("default", generator);
             std::shared_ptr<IGameMode> defGm = std::make_shared<DefaultGameMode>();
             RegisterGameMode("default", defGm);
@@ -326,7 +338,7 @@ namespace voxl
         {
             if(a_Save)
             {
-                found->second->Save();
+                found->second->Save(false);
             }
 
             found->second->Unload();
@@ -485,7 +497,7 @@ namespace voxl
         {
             if (a_SaveAll)
             {
-                pair.second->Save();
+                pair.second->Save(false);
             }
             pair.second->Unload();
         }
@@ -551,6 +563,42 @@ namespace voxl
                 m_Settings.port = defaultSettings.port;
             }
 
+            if (!JsonUtilities::VerifyValue("autosaveInterval", file, m_Settings.autosaveInterval))
+            {
+                m_Logger->log(utilities::Severity::Warning, "Autosave interval not configured in settings. Default value restored.");
+                m_Settings.autosaveInterval = defaultSettings.autosaveInterval;
+            }
+
+            if (!JsonUtilities::VerifyValue("autosaveChunksPerTick", file, m_Settings.autosaveChunksPerTick) || m_Settings.autosaveChunksPerTick <= 0)
+            {
+                m_Logger->log(utilities::Severity::Warning, "Autosave chunks per tick not configured in settings. Default value restored.");
+                m_Settings.autosaveChunksPerTick = defaultSettings.autosaveChunksPerTick;
+            }
+
+            if (!JsonUtilities::VerifyValue("autosaveMicrosPerTick", file, m_Settings.autosaveMicrosPerTick))
+            {
+                m_Logger->log(utilities::Severity::Warning, "Autosave time per tick not configured in settings. Default value restored.");
+                m_Settings.autosaveMicrosPerTick = defaultSettings.autosaveMicrosPerTick;
+            }
+
+            if (!JsonUtilities::VerifyValue("chunkSendBytesPerTick", file, m_Settings.chunkSendBytesPerTick) || m_Settings.chunkSendBytesPerTick <= 0)
+            {
+                m_Logger->log(utilities::Severity::Warning, "Chunk send bytes per tick not configured in settings. Default value restored.");
+                m_Settings.chunkSendBytesPerTick = defaultSettings.chunkSendBytesPerTick;
+            }
+
+            if (!JsonUtilities::VerifyValue("chunkSendTotalBytesPerTick", file, m_Settings.chunkSendTotalBytesPerTick))
+            {
+                m_Logger->log(utilities::Severity::Warning, "Chunk send total bytes per tick not configured in settings. Default value restored.");
+                m_Settings.chunkSendTotalBytesPerTick = defaultSettings.chunkSendTotalBytesPerTick;
+            }
+
+            if (!JsonUtilities::VerifyValue("climateSpacing", file, m_Settings.climateSpacing) || m_Settings.climateSpacing <= 0)
+            {
+                m_Logger->log(utilities::Severity::Warning, "Climate spacing not configured in settings. Default value restored.");
+                m_Settings.climateSpacing = defaultSettings.climateSpacing;
+            }
+
             /*
              * Load gamemodes.
              */
@@ -582,6 +630,12 @@ namespace voxl
         file["maximumConnections"] = a_Settings.maximumConnections;
         file["ip"] = a_Settings.ip;
         file["port"] = a_Settings.port;
+        file["autosaveInterval"] = a_Settings.autosaveInterval;
+        file["autosaveChunksPerTick"] = a_Settings.autosaveChunksPerTick;
+        file["autosaveMicrosPerTick"] = a_Settings.autosaveMicrosPerTick;
+        file["chunkSendBytesPerTick"] = a_Settings.chunkSendBytesPerTick;
+        file["chunkSendTotalBytesPerTick"] = a_Settings.chunkSendTotalBytesPerTick;
+        file["climateSpacing"] = a_Settings.climateSpacing;
 
         //Create an array of gamemodes, containing gamemode objects which each contain a name and a list of worlds.
         auto gamemodes = nlohmann::json::array();
@@ -630,6 +684,7 @@ namespace voxl
             JsonUtilities::VerifyValue("id", value, info.id);
             JsonUtilities::VerifyValue("collision", value, info.collision);
             JsonUtilities::VerifyValue("emissiveLight", value, info.emissiveLight);
+            JsonUtilities::VerifyValue("opacity", value, info.opacity);
             JsonUtilities::VerifyValue("passThroughSpeed", value, info.passThroughSpeed);
             JsonUtilities::VerifyValue("strength", value, info.strength);
 
@@ -663,6 +718,7 @@ namespace voxl
         element["id"] = info.id;
         element["collision"] = info.collision;
         element["emissiveLight"] = info.emissiveLight;
+        element["opacity"] = info.opacity;
         element["passThroughSpeed"] = info.passThroughSpeed;
         element["strength"] = info.strength;
         element["animationFrames"] = info.graphics.animationFrames;
@@ -693,4 +749,9 @@ namespace voxl
     {
         return *m_ConnectionManager;
     }
+
+    utilities::ThreadPool& Server::GetThreadPool()
+    {
+        return *m_ThreadPool;
+    }
 }
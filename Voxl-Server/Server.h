@@ -1,6 +1,7 @@
 #pragma once
 #include <map>
 #include <IServer.h>
+#include <threads/ThreadPool.h>
 
 
 #include "VoxelRegistry.h"
@@ -36,6 +37,7 @@ namespace voxl
         std::shared_ptr<IGameMode> CreateGamemode(const std::string& a_Name) override;
         const ServerSettings& GetServerSettings() const override;
         IConnectionManager& GetConnectionManager() override;
+        utilities::ThreadPool& GetThreadPool() override;
         bool WorldExists(const std::string& a_Name) override;
         ServerState GetState() override;
 
@@ -65,6 +67,9 @@ namespace voxl
         std::unique_ptr<VoxelRegistry> m_VoxelRegistry;
         std::unique_ptr<ConnectionManager> m_ConnectionManager;
 
+        //Worker threads for background tasks. Keeps one hardware thread free for the tick loop.
+        std::unique_ptr<utilities::ThreadPool> m_ThreadPool;
+
         //The gamemode registry containing the actual gamemodes.
         std::map<std::string, std::shared_ptr<IGameMode>> m_GameModes;
 
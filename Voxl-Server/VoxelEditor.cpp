@@ -1,22 +1,492 @@
 #include "VoxelEditor.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include <IChunk.h>
+#include <IChunkStore.h>
+#include <Utility.h>
+#include <threads/ThreadPool.h>
+
+#include "VoxelJournal.h"
+
 namespace voxl
 {
+    namespace
+    {
+        constexpr std::uint64_t EMPTY_KEY = ~0ull;
+    }
+
+    VoxelEditor::VoxelEditor(VoxelJournal* a_Journal, utilities::ThreadPool* a_ThreadPool, const std::function<IChunk*(const glm::ivec3&)>& a_Loader) : m_Journal(a_Journal), m_ThreadPool(a_ThreadPool), m_Loader(a_Loader), m_BucketCount(0), m_UpdateCount(0),
+        m_Slots(INITIAL_SLOTS, Slot{ EMPTY_KEY, 0 }), m_LastKey(0), m_LastBucket(0), m_Scratch(CHUNK_SIZE_CUBED), m_Previous(CHUNK_SIZE_CUBED)
+    {
+    }
+
     void VoxelEditor::QueueUpdates(const glm::ivec3& a_Start, const glm::ivec3& a_End,
         const std::function<bool(const glm::ivec3&, VoxelData&)>& a_Function)
     {
-        //TODO
+        //The function is called when the changes are applied, so that it sees the voxels as they are at that point.
+        QueueChunkUpdates(a_Start, a_End, [a_Function](const glm::ivec3& a_ChunkOrigin, const glm::uvec3& a_Min, const glm::uvec3& a_Max, VoxelData* a_Voxels)
+        {
+            bool changed = false;
+            for(auto y = a_Min.y; y <= a_Max.y; ++y)
+            {
+                for(auto z = a_Min.z; z <= a_Max.z; ++z)
+                {
+                    for(auto x = a_Min.x; x <= a_Max.x; ++x)
+                    {
+                        auto& voxel = a_Voxels[GetVoxelIndex(glm::uvec3(x, y, z))];
+                        auto data = voxel;
+                        if(a_Function(a_ChunkOrigin + glm::ivec3(x, y, z), data))
+                        {
+                            voxel = data;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+            return changed;
+        });
+    }
+
+    void VoxelEditor::QueueChunkUpdates(const glm::ivec3& a_Start, const glm::ivec3& a_End, const ChunkFunction& a_Function)
+    {
+        m_RegionUpdates.push_back(RegionUpdate{ glm::min(a_Start, a_End), glm::max(a_Start, a_End), a_Function, VoxelData() });
+    }
+
+    void VoxelEditor::QueueFill(const glm::ivec3& a_Start, const glm::ivec3& a_End, const VoxelData& a_Data)
+    {
+        m_RegionUpdates.push_back(RegionUpdate{ glm::min(a_Start, a_End), glm::max(a_Start, a_End), nullptr, a_Data });
     }
 
-    void VoxelEditor::QueueUpdate(const glm::ivec3& a_Position, const VoxelData& a_Data)
+    void VoxelEditor::QueueUpdate(const glm::ivec3& a_Position, const VoxelData& a_Data, EditPriority a_Priority)
     {
-        //TODO
+        glm::ivec3 chunkCoordinates;
+        std::uint32_t index;
+        VoxelToChunk(a_Position, chunkCoordinates, index);
+
+        //Edits mostly come in runs within the same chunk, so the last bucket is checked before the table.
+        const auto key = PackChunkCoordinates(chunkCoordinates);
+        if(m_BucketCount == 0 || key != m_LastKey)
+        {
+            m_LastBucket = GetBucket(key, chunkCoordinates);
+            m_LastKey = key;
+        }
+
+        auto& bucket = m_Buckets[m_LastBucket];
+        bucket.indices.push_back(static_cast<std::uint16_t>(index));
+        bucket.data.push_back(a_Data);
+        bucket.priorities.push_back(a_Priority);
+        ++m_UpdateCount;
     }
 
     void VoxelEditor::ApplyPendingChanges(IChunkStore& a_ChunkStore)
     {
-        //TODO
+        m_AppliedChanges.clear();
+        m_EditedChunks.clear();
+        if(m_UpdateCount == 0 && m_RegionUpdates.empty())
+        {
+            return;
+        }
+
+        //Chunks are looked up and loaded here, so the workers never add chunks to the chunk store.
+        //Chunks mark themselves dirty when a voxel changes, which only locks the store's list of dirty chunks.
+        m_Loaded.clear();
+        std::size_t loadedUpdates = 0;
+        for(std::size_t i = 0; i < m_BucketCount; ++i)
+        {
+            auto& bucket = m_Buckets[i];
+            bucket.chunk = a_ChunkStore.GetChunk(bucket.coordinates);
+            if(bucket.chunk == nullptr && m_Loader)
+            {
+                bucket.chunk = m_Loader(bucket.coordinates);
+            }
+            if(bucket.chunk != nullptr)
+            {
+                m_Loaded.push_back(&bucket);
+                loadedUpdates += bucket.indices.size();
+            }
+        }
+
+        ApplyBuckets(loadedUpdates);
+
+        for(const auto& region : m_RegionUpdates)
+        {
+            glm::ivec3 first, last;
+            std::uint32_t index;
+            VoxelToChunk(region.start, first, index);
+            VoxelToChunk(region.end, last, index);
+
+            for(int y = first.y; y <= last.y; ++y)
+            {
+                for(int z = first.z; z <= last.z; ++z)
+                {
+                    for(int x = first.x; x <= last.x; ++x)
+                    {
+                        const glm::ivec3 coordinates(x, y, z);
+                        auto* chunk = a_ChunkStore.GetChunk(coordinates);
+                        if(chunk == nullptr)
+                        {
+                            continue;
+                        }
+
+                        //The part of the region inside this chunk, in local coordinates.
+                        const auto origin = coordinates * CHUNK_SIZE;
+                        const glm::uvec3 min(glm::max(region.start - origin, glm::ivec3(0)));
+                        const glm::uvec3 max(glm::min(region.end - origin, glm::ivec3(CHUNK_SIZE - 1)));
+                        const auto edited = region.function ? EditChunk(*chunk, coordinates, min, max, region.function) : FillChunk(*chunk, coordinates, min, max, region.fill);
+                        if(edited)
+                        {
+                            m_EditedChunks.push_back(coordinates);
+                        }
+                    }
+                }
+            }
+        }
+
+        m_RegionUpdates.clear();
+
+        //Report the final value of every voxel changed by single updates, except in chunks that region edits changed afterwards.
+        std::vector<std::uint64_t> editedKeys;
+        if(!m_EditedChunks.empty())
+        {
+            editedKeys.reserve(m_EditedChunks.size());
+            for(const auto& coordinates : m_EditedChunks)
+            {
+                editedKeys.push_back(PackChunkCoordinates(coordinates));
+            }
+            std::sort(editedKeys.begin(), editedKeys.end());
+            editedKeys.erase(std::unique(editedKeys.begin(), editedKeys.end()), editedKeys.end());
+
+            //Regions that overlap in a chunk would list it more than once.
+            m_EditedChunks.clear();
+            for(const auto key : editedKeys)
+            {
+                m_EditedChunks.push_back(UnpackChunkCoordinates(key));
+            }
+        }
+
+        for(const auto* bucket : m_Loaded)
+        {
+            if(!editedKeys.empty() && std::binary_search(editedKeys.begin(), editedKeys.end(), PackChunkCoordinates(bucket->coordinates)))
+            {
+                continue;
+            }
+
+            const auto origin = bucket->coordinates * CHUNK_SIZE;
+            for(std::size_t i = 0; i < bucket->applied; ++i)
+            {
+                m_AppliedChanges.push_back(VoxelChange{ origin + glm::ivec3(GetVoxelCoordinates(bucket->indices[i])), bucket->data[i] });
+            }
+        }
+
+        for(std::size_t i = 0; i < m_BucketCount; ++i)
+        {
+            m_Buckets[i].indices.clear();
+            m_Buckets[i].data.clear();
+            m_Buckets[i].priorities.clear();
+            m_Buckets[i].applied = 0;
+        }
+        if(m_BucketCount != 0)
+        {
+            std::fill(m_Slots.begin(), m_Slots.end(), Slot{ EMPTY_KEY, 0 });
+        }
+        m_BucketCount = 0;
+        m_UpdateCount = 0;
+
+        //All changes of this tick go to disk together.
+        if(m_Journal != nullptr)
+        {
+            m_Journal->Commit();
+        }
+    }
+
+    const std::vector<VoxelChange>& VoxelEditor::GetAppliedChanges() const
+    {
+        return m_AppliedChanges;
+    }
 
+    const std::vector<glm::ivec3>& VoxelEditor::GetEditedChunks() const
+    {
+        return m_EditedChunks;
+    }
+
+    std::size_t VoxelEditor::GetBucket(std::uint64_t a_Key, const glm::ivec3& a_Coordinates)
+    {
+        //Linear probing. The table is kept at most half full, so this always terminates quickly.
+        const auto mask = m_Slots.size() - 1;
+        auto index = static_cast<std::size_t>(Mix64(a_Key)) & mask;
+        while(m_Slots[index].key != EMPTY_KEY)
+        {
+            if(m_Slots[index].key == a_Key)
+            {
+                return m_Slots[index].bucket;
+            }
+            index = (index + 1) & mask;
+        }
+
+        //Reuse the memory of buckets from earlier ticks.
+        if(m_BucketCount == m_Buckets.size())
+        {
+            m_Buckets.emplace_back();
+        }
+        const auto bucket = m_BucketCount++;
+        m_Buckets[bucket].coordinates = a_Coordinates;
+        m_Slots[index] = Slot{ a_Key, bucket };
+
+        if(m_BucketCount * 2 > m_Slots.size())
+        {
+            GrowSlots();
+        }
+        return bucket;
     }
-}
 
+    void VoxelEditor::GrowSlots()
+    {
+        m_Slots.assign(m_Slots.size() * 2, Slot{ EMPTY_KEY, 0 });
+        const auto mask = m_Slots.size() - 1;
+        for(std::size_t bucket = 0; bucket < m_BucketCount; ++bucket)
+        {
+            const auto key = PackChunkCoordinates(m_Buckets[bucket].coordinates);
+            auto index = static_cast<std::size_t>(Mix64(key)) & mask;
+            while(m_Slots[index].key != EMPTY_KEY)
+            {
+                index = (index + 1) & mask;
+            }
+            m_Slots[index] = Slot{ key, bucket };
+        }
+    }
+
+    void VoxelEditor::ApplyBuckets(std::size_t a_UpdateCount)
+    {
+        const std::size_t threads = m_ThreadPool == nullptr ? 0 : m_ThreadPool->numThreads();
+        if(m_Coalescers.size() < threads + 1)
+        {
+            m_Coalescers.resize(threads + 1);
+        }
+
+        if(threads == 0 || a_UpdateCount < PARALLEL_THRESHOLD || m_Loaded.size() < 2)
+        {
+            for(auto* bucket : m_Loaded)
+            {
+                ApplyBucket(*bucket, m_Coalescers[0]);
+            }
+            return;
+        }
+
+        //Split the buckets into ranges of about the same amount of updates. The calling thread works along, so it counts as a thread.
+        m_Ranges.clear();
+        const auto taskCount = std::min(m_Loaded.size(), (threads + 1) * TASKS_PER_THREAD);
+        const auto perTask = (a_UpdateCount + taskCount - 1) / taskCount;
+        std::size_t start = 0;
+        std::size_t size = 0;
+        for(std::size_t i = 0; i < m_Loaded.size(); ++i)
+        {
+            size += m_Loaded[i]->indices.size();
+            if(size >= perTask || i + 1 == m_Loaded.size())
+            {
+                m_Ranges.emplace_back(start, i + 1);
+                start = i + 1;
+                size = 0;
+            }
+        }
+
+        //Every thread gets a coalescer of its own.
+        m_ThreadPool->parallelFor(m_Ranges.size(), [this](std::size_t a_Range, std::size_t a_Worker)
+        {
+            for(auto i = m_Ranges[a_Range].first; i < m_Ranges[a_Range].second; ++i)
+            {
+                ApplyBucket(*m_Loaded[i], m_Coalescers[a_Worker]);
+            }
+        });
+    }
+
+    void VoxelEditor::ApplyBucket(Bucket& a_Bucket, Coalescer& a_Coalescer)
+    {
+        if(a_Coalescer.stamps.empty())
+        {
+            a_Coalescer.stamps.assign(CHUNK_SIZE_CUBED, 0);
+            a_Coalescer.winners.resize(CHUNK_SIZE_CUBED);
+            a_Coalescer.generation = 0;
+        }
+
+        //Stamps of earlier buckets could match again after the generation wraps around.
+        if(++a_Coalescer.generation == 0)
+        {
+            std::fill(a_Coalescer.stamps.begin(), a_Coalescer.stamps.end(), 0);
+            a_Coalescer.generation = 1;
+        }
+
+        //Find the winning update of every voxel: the highest priority, and the last queued one between equal priorities.
+        auto& order = a_Coalescer.order;
+        order.clear();
+        const auto generation = a_Coalescer.generation;
+        const auto count = a_Bucket.indices.size();
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            const auto index = a_Bucket.indices[i];
+            if(a_Coalescer.stamps[index] != generation)
+            {
+                a_Coalescer.stamps[index] = generation;
+                a_Coalescer.winners[index] = static_cast<std::uint32_t>(i);
+                order.push_back(index);
+            }
+            else if(a_Bucket.priorities[i] >= a_Bucket.priorities[a_Coalescer.winners[index]])
+            {
+                a_Coalescer.winners[index] = static_cast<std::uint32_t>(i);
+            }
+        }
+
+        //Move the winners that change their voxel to the front, in the order their voxel was first touched.
+        //A winner is never queued before its voxel's position in the order, so no update is overwritten before it is read.
+        auto* chunk = a_Bucket.chunk;
+        std::size_t applied = 0;
+        for(const auto index : order)
+        {
+            //Light is kept, the light engine needs the old level to clear the light that came through this voxel.
+            //Population only fills empty voxels, see EditPriority.
+            const auto winner = a_Coalescer.winners[index];
+            const auto current = chunk->GetVoxel(index);
+            auto data = a_Bucket.data[winner];
+            data.lightLevel = current.lightLevel;
+            if(std::memcmp(&current, &data, sizeof(VoxelData)) == 0 || (a_Bucket.priorities[winner] == EditPriority::POPULATION && current.id != 0))
+            {
+                continue;
+            }
+
+            chunk->SetVoxel(index, data);
+            a_Bucket.indices[applied] = index;
+            a_Bucket.data[applied] = data;
+            ++applied;
+        }
+        a_Bucket.applied = applied;
+
+        if(m_Journal != nullptr && applied != 0)
+        {
+            m_Journal->Append(a_Bucket.coordinates, a_Bucket.indices.data(), a_Bucket.data.data(), applied);
+        }
+    }
+
+    bool VoxelEditor::EditChunk(IChunk& a_Chunk, const glm::ivec3& a_Coordinates, const glm::uvec3& a_Min, const glm::uvec3& a_Max, const ChunkFunction& a_Function)
+    {
+        auto* voxels = GetFlatVoxels(a_Chunk);
+
+        //Keep the old voxels to find out which ones the function changed.
+        if(m_Journal != nullptr)
+        {
+            std::copy_n(voxels, CHUNK_SIZE_CUBED, m_Previous.data());
+        }
+
+        if(!a_Function(a_Coordinates * CHUNK_SIZE, a_Min, a_Max, voxels))
+        {
+            return false;
+        }
+        StoreFlatVoxels(a_Chunk, voxels);
+
+        if(m_Journal == nullptr)
+        {
+            return true;
+        }
+
+        m_ChangedIndices.clear();
+        m_ChangedData.clear();
+        for(auto y = a_Min.y; y <= a_Max.y; ++y)
+        {
+            for(auto z = a_Min.z; z <= a_Max.z; ++z)
+            {
+                for(auto x = a_Min.x; x <= a_Max.x; ++x)
+                {
+                    const auto index = GetVoxelIndex(glm::uvec3(x, y, z));
+                    if(std::memcmp(&voxels[index], &m_Previous[index], sizeof(VoxelData)) != 0)
+                    {
+                        m_ChangedIndices.push_back(static_cast<std::uint16_t>(index));
+                        m_ChangedData.push_back(voxels[index]);
+                    }
+                }
+            }
+        }
+        m_Journal->Append(a_Coordinates, m_ChangedIndices.data(), m_ChangedData.data(), m_ChangedIndices.size());
+        return true;
+    }
+
+    bool VoxelEditor::FillChunk(IChunk& a_Chunk, const glm::ivec3& a_Coordinates, const glm::uvec3& a_Min, const glm::uvec3& a_Max, const VoxelData& a_Data)
+    {
+        //A chunk that is covered completely needs neither its old voxels nor a journal record per voxel.
+        if(a_Min == glm::uvec3(0) && a_Max == glm::uvec3(CHUNK_SIZE - 1))
+        {
+            a_Chunk.Fill(a_Data);
+            if(m_Journal != nullptr)
+            {
+                m_Journal->Append(a_Coordinates, VoxelJournal::FILL_INDEX, a_Data);
+            }
+            return true;
+        }
+
+        //Filling part of a uniform chunk with its own value changes nothing.
+        if(a_Chunk.GetStorage() == ChunkStorage::UNIFORM)
+        {
+            const auto current = a_Chunk.GetVoxel(0);
+            if(std::memcmp(&current, &a_Data, sizeof(VoxelData)) == 0)
+            {
+                return false;
+            }
+        }
+
+        auto* voxels = GetFlatVoxels(a_Chunk);
+        m_ChangedIndices.clear();
+        m_ChangedData.clear();
+
+        const auto count = a_Max.x - a_Min.x + 1;
+        for(auto y = a_Min.y; y <= a_Max.y; ++y)
+        {
+            for(auto z = a_Min.z; z <= a_Max.z; ++z)
+            {
+                auto* row = voxels + GetVoxelIndex(glm::uvec3(a_Min.x, y, z));
+                if(m_Journal != nullptr)
+                {
+                    for(std::uint32_t x = 0; x < count; ++x)
+                    {
+                        if(std::memcmp(&row[x], &a_Data, sizeof(VoxelData)) != 0)
+                        {
+                            m_ChangedIndices.push_back(static_cast<std::uint16_t>(row + x - voxels));
+                        }
+                    }
+                }
+                std::fill_n(row, count, a_Data);
+            }
+        }
+        StoreFlatVoxels(a_Chunk, voxels);
+
+        if(m_Journal != nullptr && !m_ChangedIndices.empty())
+        {
+            m_ChangedData.assign(m_ChangedIndices.size(), a_Data);
+            m_Journal->Append(a_Coordinates, m_ChangedIndices.data(), m_ChangedData.data(), m_ChangedIndices.size());
+        }
+        return true;
+    }
+
+    VoxelData* VoxelEditor::GetFlatVoxels(IChunk& a_Chunk)
+    {
+        auto* voxels = a_Chunk.GetVoxelData();
+        if(voxels != nullptr)
+        {
+            return voxels;
+        }
+
+        a_Chunk.GetVoxels(m_Scratch.data());
+        return m_Scratch.data();
+    }
+
+    void VoxelEditor::StoreFlatVoxels(IChunk& a_Chunk, VoxelData* a_Voxels)
+    {
+        //The chunk's own array was changed directly, so only the dirty flag is missing.
+        if(a_Voxels != m_Scratch.data())
+        {
+            a_Chunk.SetDirty(true);
+            return;
+        }
+
+        //Packs the voxels into a palette again where possible.
+        a_Chunk.SetVoxels(a_Voxels);
+    }
+}
@@ -1,13 +1,190 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include <IVoxelEditor.h>
+#include <VoxelData.h>
+
+namespace utilities
+{
+    class ThreadPool;
+}
 
 namespace voxl
 {
+    class IChunk;
+    class VoxelJournal;
+
+    /*
+     * Queues voxel changes and applies them once per tick.
+     *
+     * Single voxel updates are sorted into one bucket per chunk as they are queued.
+     * Chunks do not share any data, so large batches of buckets are applied on the thread pool without locking.
+     * Chunks that are not loaded are loaded first, and a chunk is only marked dirty when one of its voxels actually changed.
+     *
+     * Updates to the same voxel are coalesced before they are applied: only the winner by EditPriority is written, logged and reported,
+     * and only when it differs from the voxel's current value. The winner does not depend on how the buckets are split over threads.
+     *
+     * Region edits are applied after the single updates, in the order they were queued, one chunk at a time.
+     * They work on the flat voxel array of the chunk, so only the changed voxels are compared and logged afterwards.
+     */
     class VoxelEditor : public IVoxelEditor
     {
     public:
+        //Below this amount of updates in a tick, handing buckets to other threads costs more than it saves.
+        static constexpr std::size_t PARALLEL_THRESHOLD = 4096;
+
+        //Amount of tasks per thread the buckets are split into, so threads that finish early can take over work.
+        static constexpr std::size_t TASKS_PER_THREAD = 4;
+
+        //Initial size of the table used to find the bucket of a chunk. Always a power of two.
+        static constexpr std::size_t INITIAL_SLOTS = 256;
+
+    public:
+        /*
+         * Create a voxel editor that logs every applied change to the given journal.
+         * The journal may be nullptr, in which case changes are only kept in memory until the chunks are saved.
+         * Without a thread pool all changes are applied on the calling thread.
+         * a_Loader loads a chunk with single updates that is not in the chunk store, and returns nullptr when the chunk does not exist.
+         * Without a loader, or when the chunk does not exist, the updates to the chunk are dropped.
+         */
+        explicit VoxelEditor(VoxelJournal* a_Journal = nullptr, utilities::ThreadPool* a_ThreadPool = nullptr, const std::function<IChunk*(const glm::ivec3&)>& a_Loader = nullptr);
+
         void QueueUpdates(const glm::ivec3& a_Start, const glm::ivec3& a_End, const std::function<bool(const glm::ivec3&, VoxelData&)>& a_Function) override;
-        void QueueUpdate(const glm::ivec3& a_Position, const VoxelData& a_Data) override;
+        void QueueChunkUpdates(const glm::ivec3& a_Start, const glm::ivec3& a_End, const ChunkFunction& a_Function) override;
+        void QueueFill(const glm::ivec3& a_Start, const glm::ivec3& a_End, const VoxelData& a_Data) override;
+        void QueueUpdate(const glm::ivec3& a_Position, const VoxelData& a_Data, EditPriority a_Priority = EditPriority::SCRIPT) override;
         void ApplyPendingChanges(IChunkStore& a_ChunkStore) override;
+        const std::vector<VoxelChange>& GetAppliedChanges() const override;
+        const std::vector<glm::ivec3>& GetEditedChunks() const override;
+
+    private:
+        /*
+         * The updates queued for a single chunk.
+         */
+        struct Bucket
+        {
+            glm::ivec3 coordinates;
+            IChunk* chunk;
+            std::vector<std::uint16_t> indices;
+            std::vector<VoxelData> data;
+            std::vector<EditPriority> priorities;
+
+            //Amount of updates left after coalescing, which are moved to the front of indices and data.
+            std::size_t applied;
+        };
+
+        /*
+         * Per thread memory to find the winning update of every voxel in a bucket.
+         * A voxel's entry in winners is only valid when its stamp equals generation, so nothing has to be cleared between buckets.
+         */
+        struct Coalescer
+        {
+            std::vector<std::uint32_t> stamps;
+            std::vector<std::uint32_t> winners;
+            std::vector<std::uint16_t> order;
+            std::uint32_t generation;
+        };
+
+        /*
+         * Get the index of the bucket for the given chunk, adding a bucket if there is none yet.
+         */
+        std::size_t GetBucket(std::uint64_t a_Key, const glm::ivec3& a_Coordinates);
+
+        /*
+         * Double the size of the slot table and insert the buckets again.
+         */
+        void GrowSlots();
+
+        /*
+         * Apply the buckets of loaded chunks, holding a_UpdateCount updates in total. Runs in parallel when there are enough of them.
+         */
+        void ApplyBuckets(std::size_t a_UpdateCount);
+
+        /*
+         * Coalesce the updates of a bucket, apply the winners to its chunk and log them to the journal.
+         */
+        void ApplyBucket(Bucket& a_Bucket, Coalescer& a_Coalescer);
+
+        /*
+         * Run a region edit on the part of a chunk between a_Min and a_Max, and log the voxels it changed to the journal.
+         * Returns whether the edit changed the chunk.
+         */
+        bool EditChunk(IChunk& a_Chunk, const glm::ivec3& a_Coordinates, const glm::uvec3& a_Min, const glm::uvec3& a_Max, const ChunkFunction& a_Function);
+
+        /*
+         * Set the voxels of a chunk between a_Min and a_Max to a_Data. A chunk that is covered completely becomes uniform.
+         * Returns whether the chunk may have changed.
+         */
+        bool FillChunk(IChunk& a_Chunk, const glm::ivec3& a_Coordinates, const glm::uvec3& a_Min, const glm::uvec3& a_Max, const VoxelData& a_Data);
+
+        /*
+         * Get the voxels of a chunk as a flat array, which is the chunk's own array when it is stored flat, or m_Scratch otherwise.
+         * Changes to m_Scratch have to be written back with IChunk::SetVoxels.
+         */
+        VoxelData* GetFlatVoxels(IChunk& a_Chunk);
+
+        /*
+         * Mark a chunk changed after its voxels returned by GetFlatVoxels were edited.
+         */
+        void StoreFlatVoxels(IChunk& a_Chunk, VoxelData* a_Voxels);
+
+    private:
+        struct RegionUpdate
+        {
+            glm::ivec3 start;
+            glm::ivec3 end;
+
+            //Either a function, or the value to fill the region with.
+            ChunkFunction function;
+            VoxelData fill;
+        };
+
+        VoxelJournal* m_Journal;
+        utilities::ThreadPool* m_ThreadPool;
+        std::function<IChunk*(const glm::ivec3&)> m_Loader;
+
+        //Buckets in the order their chunk was first touched. Only the first m_BucketCount are in use, the rest keep their memory for later ticks.
+        std::vector<Bucket> m_Buckets;
+        std::size_t m_BucketCount;
+        std::size_t m_UpdateCount;
+
+        //Open addressing table from packed chunk coordinates to the index in m_Buckets, cleared by every apply.
+        //This is looked up for every queued update, which is noticeably faster without the allocations of a node based map.
+        struct Slot
+        {
+            std::uint64_t key;
+            std::size_t bucket;
+        };
+        std::vector<Slot> m_Slots;
+
+        //The bucket used by the last update.
+        std::uint64_t m_LastKey;
+        std::size_t m_LastBucket;
+
+        //Buckets of loaded chunks, rebuilt by every apply.
+        std::vector<Bucket*> m_Loaded;
+
+        //One coalescer for the calling thread and one for every thread in the pool.
+        std::vector<Coalescer> m_Coalescers;
+
+        //Buckets handed to the thread pool, split into ranges of about equal amounts of updates.
+        std::vector<std::pair<std::size_t, std::size_t>> m_Ranges;
+
+        //What the last apply changed.
+        std::vector<VoxelChange> m_AppliedChanges;
+        std::vector<glm::ivec3> m_EditedChunks;
+
+        std::vector<RegionUpdate> m_RegionUpdates;
+
+        //Chunk sized buffers for editing chunks that are not stored flat, and for finding the voxels a region edit changed.
+        std::vector<VoxelData> m_Scratch;
+        std::vector<VoxelData> m_Previous;
+
+        //Changes of a single chunk, logged to the journal at once.
+        std::vector<std::uint16_t> m_ChangedIndices;
+        std::vector<VoxelData> m_ChangedData;
     };
-}
\ No newline at end of file
+}
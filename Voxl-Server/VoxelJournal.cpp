@@ -0,0 +1,281 @@
+#include "VoxelJournal.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <Utility.h>
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+
+namespace voxl
+{
+    VoxelJournal::VoxelJournal(const std::string& a_Directory) : m_Directory(a_Directory), m_CommitCount(0), m_SyncedCount(0), m_Segment(0), m_OpenSegment(0), m_File(INVALID_HANDLE_VALUE), m_Stop(false)
+    {
+        std::filesystem::create_directories(m_Directory);
+
+        //Never append to an existing segment, its tail may be torn.
+        const auto segments = FindSegments();
+        m_Segment = segments.empty() ? 0 : segments.back() + 1;
+
+        m_Writer = std::thread(&VoxelJournal::WriterLoop, this);
+    }
+
+    VoxelJournal::~VoxelJournal()
+    {
+        Commit();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_WakeWriter.notify_one();
+        m_Writer.join();
+    }
+
+    void VoxelJournal::Append(const glm::ivec3& a_ChunkCoordinates, std::uint32_t a_Index, const VoxelData& a_Data)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Open.push_back(Record{ PackChunkCoordinates(a_ChunkCoordinates), static_cast<std::uint16_t>(a_Index), a_Data });
+    }
+
+    void VoxelJournal::Append(const glm::ivec3& a_ChunkCoordinates, const std::uint16_t* a_Indices, const VoxelData* a_Data, std::size_t a_Count)
+    {
+        const auto chunk = PackChunkCoordinates(a_ChunkCoordinates);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for(std::size_t i = 0; i < a_Count; ++i)
+        {
+            m_Open.push_back(Record{ chunk, a_Indices[i], a_Data[i] });
+        }
+    }
+
+    void VoxelJournal::Commit()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if(m_Open.empty())
+            {
+                return;
+            }
+
+            //Batch layout: record count, checksum of the records, records.
+            const auto count = static_cast<std::uint32_t>(m_Open.size());
+            const auto size = m_Open.size() * sizeof(Record);
+            const auto checksum = Checksum(reinterpret_cast<const std::uint8_t*>(m_Open.data()), size);
+
+            Batch batch{ m_Segment, std::vector<std::uint8_t>(8 + size) };
+            std::memcpy(batch.data.data(), &count, sizeof(count));
+            std::memcpy(batch.data.data() + 4, &checksum, sizeof(checksum));
+            std::memcpy(batch.data.data() + 8, m_Open.data(), size);
+
+            m_Sealed.emplace_back(std::move(batch));
+            m_Open.clear();
+            ++m_CommitCount;
+        }
+        m_WakeWriter.notify_one();
+    }
+
+    void VoxelJournal::Sync()
+    {
+        Commit();
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        const auto commit = m_CommitCount;
+        m_Written.wait(lock, [&]()
+        {
+            return m_SyncedCount >= commit;
+        });
+    }
+
+    std::uint32_t VoxelJournal::Rotate()
+    {
+        //Changes made before the rotation belong in the old segment.
+        Commit();
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return ++m_Segment;
+    }
+
+    void VoxelJournal::DeleteBefore(std::uint32_t a_Segment)
+    {
+        //Segments are opened with delete sharing, so this also works while the writer still has the last old segment open.
+        for(const auto segment : FindSegments())
+        {
+            if(segment < a_Segment)
+            {
+                std::error_code error;
+                std::filesystem::remove(GetSegmentPath(segment), error);
+            }
+        }
+    }
+
+    std::uint64_t VoxelJournal::Replay(const std::function<void(const glm::ivec3&, std::uint32_t, const VoxelData&)>& a_Function)
+    {
+        std::uint64_t replayed = 0;
+        for(const auto segment : FindSegments())
+        {
+            std::ifstream file(GetSegmentPath(segment), std::ios::binary);
+            const std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+            std::uint32_t magic = 0, version = 0;
+            if(data.size() >= 8)
+            {
+                std::memcpy(&magic, data.data(), sizeof(magic));
+                std::memcpy(&version, data.data() + 4, sizeof(version));
+            }
+            if(magic != MAGIC || version != VERSION)
+            {
+                utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Warning, "Skipping journal segment '" + GetSegmentPath(segment) + "' with an invalid header.");
+                continue;
+            }
+
+            std::size_t offset = 8;
+            while(data.size() - offset >= 8)
+            {
+                std::uint32_t count, checksum;
+                std::memcpy(&count, data.data() + offset, sizeof(count));
+                std::memcpy(&checksum, data.data() + offset + 4, sizeof(checksum));
+
+                //A batch that is cut off or does not match its checksum was being written during a crash. Nothing after it is valid.
+                const auto size = static_cast<std::size_t>(count) * sizeof(Record);
+                if(data.size() - offset - 8 < size || Checksum(data.data() + offset + 8, size) != checksum)
+                {
+                    utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Warning, "Journal segment '" + GetSegmentPath(segment) + "' ends with an incomplete batch, which was ignored.");
+                    break;
+                }
+
+                for(std::uint32_t i = 0; i < count; ++i)
+                {
+                    Record record;
+                    std::memcpy(&record, data.data() + offset + 8 + i * sizeof(Record), sizeof(Record));
+                    if(record.index < CHUNK_SIZE_CUBED || record.index == FILL_INDEX)
+                    {
+                        a_Function(UnpackChunkCoordinates(record.chunk), record.index, record.data);
+                        ++replayed;
+                    }
+                }
+                offset += 8 + size;
+            }
+        }
+        return replayed;
+    }
+
+    void VoxelJournal::WriterLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while(true)
+        {
+            m_WakeWriter.wait(lock, [this]()
+            {
+                return m_Stop || !m_Sealed.empty();
+            });
+
+            if(m_Sealed.empty())
+            {
+                break;
+            }
+
+            //Take every batch committed so far, so that they all share a single sync.
+            auto batches = std::move(m_Sealed);
+            m_Sealed.clear();
+            const auto commit = m_CommitCount;
+            lock.unlock();
+
+            for(const auto& batch : batches)
+            {
+                if(m_File == INVALID_HANDLE_VALUE || batch.segment != m_OpenSegment)
+                {
+                    CloseSegment();
+                    if(!OpenSegment(batch.segment))
+                    {
+                        continue;
+                    }
+                }
+
+                DWORD written = 0;
+                if(!WriteFile(m_File, batch.data.data(), static_cast<DWORD>(batch.data.size()), &written, nullptr) || written != batch.data.size())
+                {
+                    utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Could not write to voxel journal.");
+                }
+            }
+
+            if(m_File != INVALID_HANDLE_VALUE)
+            {
+                FlushFileBuffers(m_File);
+            }
+
+            lock.lock();
+            m_SyncedCount = commit;
+            m_Written.notify_all();
+        }
+        lock.unlock();
+
+        CloseSegment();
+    }
+
+    std::string VoxelJournal::GetSegmentPath(std::uint32_t a_Segment) const
+    {
+        return m_Directory + "journal." + std::to_string(a_Segment) + ".vxj";
+    }
+
+    std::vector<std::uint32_t> VoxelJournal::FindSegments() const
+    {
+        std::vector<std::uint32_t> segments;
+        std::error_code error;
+        for(const auto& entry : std::filesystem::directory_iterator(m_Directory, error))
+        {
+            //Names look like journal.<number>.vxj.
+            const auto name = entry.path().filename().string();
+            if(name.size() > 12 && name.compare(0, 8, "journal.") == 0 && name.compare(name.size() - 4, 4, ".vxj") == 0)
+            {
+                const auto number = name.substr(8, name.size() - 12);
+                if(std::all_of(number.begin(), number.end(), [](char a_Char) { return a_Char >= '0' && a_Char <= '9'; }))
+                {
+                    segments.push_back(static_cast<std::uint32_t>(std::stoul(number)));
+                }
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+    bool VoxelJournal::OpenSegment(std::uint32_t a_Segment)
+    {
+        const auto path = std::filesystem::path(GetSegmentPath(a_Segment));
+        m_File = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(m_File == INVALID_HANDLE_VALUE)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Could not create voxel journal segment '" + path.string() + "'.");
+            return false;
+        }
+
+        std::uint32_t header[2] = { MAGIC, VERSION };
+        DWORD written = 0;
+        WriteFile(m_File, header, sizeof(header), &written, nullptr);
+        m_OpenSegment = a_Segment;
+        return true;
+    }
+
+    void VoxelJournal::CloseSegment()
+    {
+        if(m_File != INVALID_HANDLE_VALUE)
+        {
+            FlushFileBuffers(m_File);
+            CloseHandle(m_File);
+            m_File = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    std::uint32_t VoxelJournal::Checksum(const std::uint8_t* a_Data, std::size_t a_Size)
+    {
+        //FNV-1a. Only needs to catch torn writes, not deliberate tampering.
+        std::uint32_t hash = 2166136261u;
+        for(std::size_t i = 0; i < a_Size; ++i)
+        {
+            hash = (hash ^ a_Data[i]) * 16777619u;
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <VoxelData.h>
+
+namespace voxl
+{
+    /*
+     * Append-only log of voxel changes, used to recover edits made since the last full save after a crash.
+     *
+     * Changes are appended in memory and sealed into a batch by Commit.
+     * A background thread writes all sealed batches at once and syncs the file a single time for all of them (group commit).
+     * Every batch carries a checksum, so a batch that was only partially written before a crash is ignored on replay.
+     *
+     * The journal is split into numbered segment files. A full save, and every autosave cycle, calls Rotate when it starts.
+     * Once the save has finished, DeleteBefore removes the segments that only contain changes that are now in the region files.
+     */
+    class VoxelJournal
+    {
+    public:
+        static constexpr std::uint32_t MAGIC = 0x4A585856;    //"VXXJ"
+        static constexpr std::uint32_t VERSION = 1;
+
+        //Voxel index of a change that sets every voxel of the chunk to the same value.
+        static constexpr std::uint32_t FILL_INDEX = 0xFFFF;
+
+    public:
+        /*
+         * Open the journal in the given directory, for example "worlds/<name>/journal/".
+         * New changes are written to a new segment after the existing ones.
+         */
+        explicit VoxelJournal(const std::string& a_Directory);
+        ~VoxelJournal();
+
+        VoxelJournal(const VoxelJournal&) = delete;
+        VoxelJournal& operator=(const VoxelJournal&) = delete;
+
+        /*
+         * Record a voxel change. Nothing is written until Commit is called.
+         */
+        void Append(const glm::ivec3& a_ChunkCoordinates, std::uint32_t a_Index, const VoxelData& a_Data);
+
+        /*
+         * Record a_Count changes to the same chunk, taking the lock only once. This can be called from multiple threads.
+         */
+        void Append(const glm::ivec3& a_ChunkCoordinates, const std::uint16_t* a_Indices, const VoxelData* a_Data, std::size_t a_Count);
+
+        /*
+         * Seal the changes appended so far into a batch and wake the writer thread. Does not wait for the write.
+         */
+        void Commit();
+
+        /*
+         * Block until every committed batch is on disk.
+         */
+        void Sync();
+
+        /*
+         * Start a new segment for changes committed after this call. Returns the number of the new segment.
+         */
+        std::uint32_t Rotate();
+
+        /*
+         * Delete all segments numbered below a_Segment.
+         */
+        void DeleteBefore(std::uint32_t a_Segment);
+
+        /*
+         * Call a_Function for every change stored in the existing segments, oldest first.
+         * The index passed is FILL_INDEX for changes to a whole chunk.
+         * Returns the amount of changes replayed.
+         */
+        std::uint64_t Replay(const std::function<void(const glm::ivec3&, std::uint32_t, const VoxelData&)>& a_Function);
+
+    private:
+        /*
+         * Compact on-disk form of a single change.
+         */
+#pragma pack(push, 1)
+        struct Record
+        {
+            std::uint64_t chunk;    //Packed chunk coordinates.
+            std::uint16_t index;    //Voxel index within the chunk.
+            VoxelData data;
+        };
+#pragma pack(pop)
+
+        /*
+         * Encoded batch of records together with the segment it belongs in.
+         */
+        struct Batch
+        {
+            std::uint32_t segment;
+            std::vector<std::uint8_t> data;
+        };
+
+        /*
+         * Write sealed batches until the journal is destroyed.
+         */
+        void WriterLoop();
+
+        /*
+         * Get the file name of the given segment.
+         */
+        std::string GetSegmentPath(std::uint32_t a_Segment) const;
+
+        /*
+         * Find the numbers of all segments on disk, sorted.
+         */
+        std::vector<std::uint32_t> FindSegments() const;
+
+        /*
+         * Open a new segment file for writing and write its header. Called by the writer thread.
+         */
+        bool OpenSegment(std::uint32_t a_Segment);
+
+        /*
+         * Close the current segment file. Called by the writer thread.
+         */
+        void CloseSegment();
+
+        static std::uint32_t Checksum(const std::uint8_t* a_Data, std::size_t a_Size);
+
+    private:
+        std::string m_Directory;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_WakeWriter;
+        std::condition_variable m_Written;
+
+        //Changes appended since the last commit.
+        std::vector<Record> m_Open;
+
+        //Batches waiting to be written.
+        std::vector<Batch> m_Sealed;
+
+        //Commits are numbered. The writer reports the last one that reached the disk.
+        std::uint64_t m_CommitCount;
+        std::uint64_t m_SyncedCount;
+
+        //Segment that new batches go to, and the one the writer currently has open.
+        std::uint32_t m_Segment;
+        std::uint32_t m_OpenSegment;
+
+        //Win32 file handle of the open segment, stored as void* to keep windows.h out of this header.
+        void* m_File;
+
+        bool m_Stop;
+        std::thread m_Writer;
+    };
+}
@@ -0,0 +1,219 @@
+#include "VoxelPalette.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace voxl
+{
+    VoxelPalette::VoxelPalette() : m_BitsPerVoxel(1), m_Mask(1)
+    {
+
+    }
+
+    bool VoxelPalette::Build(const VoxelData* a_Voxels)
+    {
+        //Find the unique values by sorting a copy of the voxels.
+        std::vector<std::uint32_t> keys(CHUNK_SIZE_CUBED);
+        for(std::uint32_t i = 0; i < CHUNK_SIZE_CUBED; ++i)
+        {
+            keys[i] = ToKey(a_Voxels[i]);
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        if(keys.size() > MAX_PALETTE_SIZE)
+        {
+            Clear();
+            return false;
+        }
+
+        m_Palette.assign(keys.begin(), keys.end());
+        m_Palette.shrink_to_fit();
+        m_BitsPerVoxel = GetRequiredBits(m_Palette.size());
+        m_Mask = (1ull << m_BitsPerVoxel) - 1;
+        m_Indices.assign((CHUNK_SIZE_CUBED * m_BitsPerVoxel) / 64, 0);
+        m_Indices.shrink_to_fit();
+
+        //The palette is sorted at this point, so indices can be found with a binary search.
+        for(std::uint32_t i = 0; i < CHUNK_SIZE_CUBED; ++i)
+        {
+            const auto paletteIndex = static_cast<std::uint64_t>(std::lower_bound(m_Palette.begin(), m_Palette.end(), ToKey(a_Voxels[i])) - m_Palette.begin());
+            const auto bit = i * m_BitsPerVoxel;
+            m_Indices[bit >> 6] |= paletteIndex << (bit & 63);
+        }
+
+        return true;
+    }
+
+    void VoxelPalette::Unpack(VoxelData* a_Destination) const
+    {
+        for(std::uint32_t i = 0; i < CHUNK_SIZE_CUBED; ++i)
+        {
+            a_Destination[i] = Get(i);
+        }
+    }
+
+    bool VoxelPalette::Set(std::uint32_t a_Index, const VoxelData& a_Data)
+    {
+        assert(a_Index < CHUNK_SIZE_CUBED);
+        const auto key = ToKey(a_Data);
+
+        auto found = std::find(m_Palette.begin(), m_Palette.end(), key);
+        if(found == m_Palette.end())
+        {
+            //Palette is full. Rebuilding drops entries that are no longer used, which may make room.
+            if(m_Palette.size() >= MAX_PALETTE_SIZE)
+            {
+                std::vector<VoxelData> voxels(CHUNK_SIZE_CUBED);
+                Unpack(voxels.data());
+                Build(voxels.data());
+                if(m_Palette.size() >= MAX_PALETTE_SIZE)
+                {
+                    return false;
+                }
+            }
+
+            //Widen the indices when the new entry would not be addressable.
+            const auto requiredBits = GetRequiredBits(m_Palette.size() + 1);
+            if(requiredBits != m_BitsPerVoxel)
+            {
+                Repack(requiredBits);
+            }
+
+            m_Palette.push_back(key);
+            found = m_Palette.end() - 1;
+        }
+
+        const auto paletteIndex = static_cast<std::uint64_t>(found - m_Palette.begin());
+        const auto bit = a_Index * m_BitsPerVoxel;
+        auto& word = m_Indices[bit >> 6];
+        word = (word & ~(m_Mask << (bit & 63))) | (paletteIndex << (bit & 63));
+        return true;
+    }
+
+    void VoxelPalette::Serialize(std::vector<std::uint8_t>& a_Output) const
+    {
+        //Layout: palette size (u16), palette entries (u32 each), bits per voxel (u8), packed index words (u64 each).
+        const auto paletteSize = static_cast<std::uint16_t>(m_Palette.size());
+        const auto bits = static_cast<std::uint8_t>(m_BitsPerVoxel);
+        const auto start = a_Output.size();
+        a_Output.resize(start + sizeof(paletteSize) + m_Palette.size() * sizeof(std::uint32_t) + sizeof(bits) + m_Indices.size() * sizeof(std::uint64_t));
+
+        auto* out = a_Output.data() + start;
+        std::memcpy(out, &paletteSize, sizeof(paletteSize));
+        out += sizeof(paletteSize);
+        std::memcpy(out, m_Palette.data(), m_Palette.size() * sizeof(std::uint32_t));
+        out += m_Palette.size() * sizeof(std::uint32_t);
+        std::memcpy(out, &bits, sizeof(bits));
+        out += sizeof(bits);
+        std::memcpy(out, m_Indices.data(), m_Indices.size() * sizeof(std::uint64_t));
+    }
+
+    bool VoxelPalette::Deserialize(const std::uint8_t*& a_Data, const std::uint8_t* a_End)
+    {
+        Clear();
+
+        std::uint16_t paletteSize;
+        if(a_End - a_Data < static_cast<std::ptrdiff_t>(sizeof(paletteSize)))
+        {
+            return false;
+        }
+        std::memcpy(&paletteSize, a_Data, sizeof(paletteSize));
+
+        const auto paletteBytes = static_cast<std::ptrdiff_t>(paletteSize) * static_cast<std::ptrdiff_t>(sizeof(std::uint32_t));
+        if(paletteSize == 0 || paletteSize > MAX_PALETTE_SIZE || a_End - a_Data < static_cast<std::ptrdiff_t>(sizeof(paletteSize)) + paletteBytes + 1)
+        {
+            return false;
+        }
+
+        const auto* in = a_Data + sizeof(paletteSize);
+        const std::uint32_t bits = in[paletteBytes];
+        if((bits != 1 && bits != 2 && bits != 4 && bits != 8 && bits != 16) || (1ull << bits) < paletteSize)
+        {
+            return false;
+        }
+
+        const auto indexBytes = static_cast<std::ptrdiff_t>((CHUNK_SIZE_CUBED * bits) / 64 * sizeof(std::uint64_t));
+        if(a_End - in < paletteBytes + 1 + indexBytes)
+        {
+            return false;
+        }
+
+        m_Palette.resize(paletteSize);
+        std::memcpy(m_Palette.data(), in, static_cast<std::size_t>(paletteBytes));
+        in += paletteBytes + 1;
+        m_Indices.resize(static_cast<std::size_t>(indexBytes) / sizeof(std::uint64_t));
+        std::memcpy(m_Indices.data(), in, static_cast<std::size_t>(indexBytes));
+        in += indexBytes;
+        m_BitsPerVoxel = bits;
+        m_Mask = (1ull << bits) - 1;
+
+        //Make sure no index points outside of the palette.
+        for(std::uint32_t i = 0; i < CHUNK_SIZE_CUBED; ++i)
+        {
+            const auto bit = i * m_BitsPerVoxel;
+            if(((m_Indices[bit >> 6] >> (bit & 63)) & m_Mask) >= paletteSize)
+            {
+                Clear();
+                return false;
+            }
+        }
+
+        a_Data = in;
+        return true;
+    }
+
+    void VoxelPalette::Clear()
+    {
+        m_Palette.clear();
+        m_Palette.shrink_to_fit();
+        m_Indices.clear();
+        m_Indices.shrink_to_fit();
+        m_BitsPerVoxel = 1;
+        m_Mask = 1;
+    }
+
+    std::uint32_t VoxelPalette::GetPaletteSize() const
+    {
+        return static_cast<std::uint32_t>(m_Palette.size());
+    }
+
+    std::uint32_t VoxelPalette::GetBitsPerVoxel() const
+    {
+        return m_BitsPerVoxel;
+    }
+
+    std::size_t VoxelPalette::GetMemoryUsage() const
+    {
+        return sizeof(VoxelPalette) + m_Palette.capacity() * sizeof(std::uint32_t) + m_Indices.capacity() * sizeof(std::uint64_t);
+    }
+
+    void VoxelPalette::Repack(std::uint32_t a_BitsPerVoxel)
+    {
+        const auto mask = (1ull << a_BitsPerVoxel) - 1;
+        std::vector<std::uint64_t> indices((CHUNK_SIZE_CUBED * a_BitsPerVoxel) / 64, 0);
+
+        for(std::uint32_t i = 0; i < CHUNK_SIZE_CUBED; ++i)
+        {
+            const auto oldBit = i * m_BitsPerVoxel;
+            const auto paletteIndex = (m_Indices[oldBit >> 6] >> (oldBit & 63)) & m_Mask;
+            const auto newBit = i * a_BitsPerVoxel;
+            indices[newBit >> 6] |= (paletteIndex & mask) << (newBit & 63);
+        }
+
+        m_Indices = std::move(indices);
+        m_BitsPerVoxel = a_BitsPerVoxel;
+        m_Mask = mask;
+    }
+
+    std::uint32_t VoxelPalette::GetRequiredBits(std::size_t a_PaletteSize)
+    {
+        //Only widths that divide 64 are used, so an index never straddles two words.
+        if(a_PaletteSize <= 2) return 1;
+        if(a_PaletteSize <= 4) return 2;
+        if(a_PaletteSize <= 16) return 4;
+        if(a_PaletteSize <= 256) return 8;
+        return 16;
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <vector>
+
+#include <Utility.h>
+#include <VoxelData.h>
+
+namespace voxl
+{
+    /*
+     * Palette compressed storage for the voxels of a single chunk.
+     * Every unique voxel value is stored once in the palette.
+     * Each voxel is a 1, 2, 4, 8 or 16 bit index into the palette, packed into 64 bit words.
+     * The index width is chosen from the palette size, and grows automatically when new values are added.
+     */
+    class VoxelPalette
+    {
+    public:
+        //Beyond this many unique values a flat array is about as small, and a lot faster.
+        static constexpr std::uint32_t MAX_PALETTE_SIZE = 1024;
+
+    public:
+        VoxelPalette();
+
+        /*
+         * Build the palette from CHUNK_SIZE_CUBED voxels.
+         * Returns false if the voxels contain more than MAX_PALETTE_SIZE unique values. The palette is left empty in that case.
+         */
+        bool Build(const VoxelData* a_Voxels);
+
+        /*
+         * Write all CHUNK_SIZE_CUBED voxels into a_Destination.
+         */
+        void Unpack(VoxelData* a_Destination) const;
+
+        /*
+         * Get the voxel at the given index.
+         */
+        VoxelData Get(std::uint32_t a_Index) const
+        {
+            const auto bit = a_Index * m_BitsPerVoxel;
+            const auto paletteIndex = (m_Indices[bit >> 6] >> (bit & 63)) & m_Mask;
+            return FromKey(m_Palette[static_cast<std::size_t>(paletteIndex)]);
+        }
+
+        /*
+         * Set the voxel at the given index.
+         * Returns false if this would grow the palette beyond MAX_PALETTE_SIZE. Nothing is changed in that case.
+         */
+        bool Set(std::uint32_t a_Index, const VoxelData& a_Data);
+
+        /*
+         * Append the palette and the packed indices to a_Output.
+         */
+        void Serialize(std::vector<std::uint8_t>& a_Output) const;
+
+        /*
+         * Read a palette written by Serialize, starting at a_Data and advancing it past the palette.
+         * Returns false if the data is truncated or invalid. The palette is left empty in that case.
+         */
+        bool Deserialize(const std::uint8_t*& a_Data, const std::uint8_t* a_End);
+
+        /*
+         * Remove all data and free the memory used.
+         */
+        void Clear();
+
+        /*
+         * Get the amount of unique values in the palette.
+         * This may include values that are no longer used by any voxel.
+         */
+        std::uint32_t GetPaletteSize() const;
+
+        /*
+         * Get the amount of bits used per voxel.
+         */
+        std::uint32_t GetBitsPerVoxel() const;
+
+        /*
+         * Get the amount of memory in bytes used by this palette.
+         */
+        std::size_t GetMemoryUsage() const;
+
+    private:
+        /*
+         * Change the index width to the given amount of bits, keeping all voxels.
+         */
+        void Repack(std::uint32_t a_BitsPerVoxel);
+
+        /*
+         * Get the smallest supported index width that can address the given amount of palette entries.
+         */
+        static std::uint32_t GetRequiredBits(std::size_t a_PaletteSize);
+
+        /*
+         * Convert between voxels and palette keys. Keys hold the fields in the order they have in memory, so they match the raw bits of the voxel.
+         */
+        static std::uint32_t ToKey(const VoxelData& a_Data)
+        {
+            return a_Data.id | (static_cast<std::uint32_t>(a_Data.metaData) << 16) | (static_cast<std::uint32_t>(a_Data.lightLevel) << 24);
+        }
+
+        static VoxelData FromKey(std::uint32_t a_Key)
+        {
+            VoxelData data;
+            data.id = static_cast<std::uint16_t>(a_Key);
+            data.metaData = static_cast<std::uint8_t>(a_Key >> 16);
+            data.lightLevel = static_cast<std::uint8_t>(a_Key >> 24);
+            return data;
+        }
+
+    private:
+        static_assert(sizeof(VoxelData) == sizeof(std::uint32_t), "VoxelData is expected to be 4 bytes for palette compression.");
+
+        //The unique voxel values, stored as their raw bits for fast comparison.
+        std::vector<std::uint32_t> m_Palette;
+
+        //The bit-packed palette indices.
+        std::vector<std::uint64_t> m_Indices;
+
+        std::uint32_t m_BitsPerVoxel;
+        std::uint64_t m_Mask;
+    };
+}
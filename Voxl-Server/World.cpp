@@ -2,20 +2,34 @@
 
 #include <IGameMode.h>
 #include <IChunkStore.h>
+#include <IConnectionManager.h>
+#include <IEntity.h>
 #include <IWorldGenerator.h>
 #include <IVoxelEditor.h>
 #include <IServer.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <initializer_list>
+#include <limits>
+#include <thread>
 
 #include <logging/Logger.h>
 #include <other/ServiceLocator.h>
+#include <other/Transform.h>
+#include <threads/ThreadPool.h>
 
 #include "ClientConnection.h"
+#include "DefaultWorldGenerator.h"
 
+#include "Chunk.h"
+#include "ChunkPackets.h"
 #include "ChunkStore.h"
 #include "file/FileUtilities.h"
 #include "JsonUtilities.h"
+#include "PlayerController.h"
+#include "PopulateContext.h"
 #include "VoxelEditor.h"
 
 #undef CreateFile
@@ -23,7 +37,7 @@
 namespace voxl
 {
 
-    World::World(const std::string& a_Name) : m_State(WorldState::UNLOADED)
+    World::World(const std::string& a_Name) : m_State(WorldState::UNLOADED), m_ThreadPool(nullptr), m_ConnectionManager(nullptr), m_ChunkSendBytesPerTick(0), m_ChunksUnloaded(false)
     {
         m_Settings.name = a_Name;
     }
@@ -37,33 +51,122 @@ namespace voxl
         return m_Settings.name;
     }
 
-    void World::Save()
+    World::~World()
     {
-        if(m_State != WorldState::UNLOADED)
+        //Save tasks refer to this world, so they have to finish first.
+        WaitForSave();
+    }
+
+    void World::Save(bool a_Async)
+    {
+        if(m_State == WorldState::UNLOADED)
         {
             utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Can't save world that was not yet loaded.");
             return;
         }
 
+        //Only one save can run at a time. A synchronous save finishes the running one first.
+        if(IsSaving())
+        {
+            if(a_Async)
+            {
+                utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Warning, "World '" + m_Settings.name + "' is already being saved.");
+                return;
+            }
+            WaitForSave();
+        }
+        if(m_SaveJob != nullptr)
+        {
+            FinishSave(*m_SaveJob);
+            m_SaveJob.reset();
+        }
+
         //Mark as saving so that no tick will happen if checked.
         m_State = WorldState::SAVING;
 
-        //TODO add a_Async bool to function and then run in other thread after changing state.
-
         SaveWorldSettings(m_Settings);
 
-        //Save each chunk as well.
+        //The writes that population placed in unloaded chunks go first, so that no saved chunk is missing them after a crash.
+        m_PendingWrites->Save(false);
+
+        //Snapshot every changed chunk on this thread, so that the chunks can keep changing while the snapshots are written.
+        //Snapshots are a plain copy of the chunk's current storage, which is cheap enough to not cause a tick spike.
+        auto job = std::make_shared<SaveJob>();
+
+        //Changes made from now on are not in the snapshots, so they go to a new journal segment.
+        job->journalSegment = m_Journal->Rotate();
+        std::vector<std::shared_ptr<std::vector<ChunkSnapshot>>> batches;
         for (auto& chunk : *m_ChunkStore)
         {
-            chunk.Save(*this);
+            if(!chunk.IsDirty())
+            {
+                continue;
+            }
+
+            //Saved chunks are unlikely to change soon, so compress them in memory too.
+            //Asynchronous saves skip this as building palettes is too slow for the tick thread. Only the snapshot is compressed in that case.
+            if(m_Settings.compressChunks && !a_Async)
+            {
+                chunk.Compact();
+            }
+
+            if(batches.empty() || batches.back()->size() == SAVE_BATCH_SIZE)
+            {
+                batches.emplace_back(std::make_shared<std::vector<ChunkSnapshot>>());
+                batches.back()->reserve(SAVE_BATCH_SIZE);
+            }
+
+            auto& snapshot = batches.back()->emplace_back();
+            snapshot.coordinates = chunk.GetChunkCoordinates();
+            static_cast<Chunk&>(chunk).Serialize(snapshot.data);
+            chunk.SetDirty(false);
+            ++job->totalChunks;
+
+            //Until the snapshot is written, unloading the chunk would lose its changes. Loading it again would read older data.
+            if(a_Async)
+            {
+                static_cast<Chunk&>(chunk).SetSaving(true);
+                job->chunks.push_back(snapshot.coordinates);
+            }
+        }
+        job->remainingBatches = static_cast<std::uint32_t>(batches.size());
+
+        //Compression and disk access happen on the thread pool for asynchronous saves.
+        for(auto& batch : batches)
+        {
+            if(a_Async)
+            {
+                m_ThreadPool->enqueue([this, job, batch]()
+                {
+                    WriteSnapshots(*job, *batch);
+                });
+            }
+            else
+            {
+                WriteSnapshots(*job, *batch);
+            }
+        }
+
+        if(a_Async && !batches.empty())
+        {
+            m_SaveJob = std::move(job);
+        }
+        else
+        {
+            FinishSave(*job);
         }
 
         m_State = WorldState::RUNNING;
     }
 
+    bool World::IsSaving() const
+    {
+        return m_SaveJob != nullptr && m_SaveJob->remainingBatches != 0;
+    }
+
     void World::Unload()
     {
-        if (m_State != WorldState::UNLOADED)
+        if (m_State == WorldState::UNLOADED)
         {
             utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Can't unload a world that was not yet loaded.");
             return;
@@ -71,8 +174,26 @@ namespace voxl
 
         //TODO ensure players are added to another world.
 
+        //Finish writing any chunks that are still being saved.
+        WaitForSave();
+        if(m_SaveJob != nullptr)
+        {
+            FinishSave(*m_SaveJob);
+            m_SaveJob.reset();
+        }
+
+        //Make sure every logged change is on disk.
+        m_Journal->Sync();
+
+        //Stop loading and generating chunks. Chunks that were not finished are dropped, they are generated again when needed.
+        m_Pipeline.reset();
+        m_PlayerChunks.clear();
+
         //Unload all the chunks.
+        m_Autosave->Clear();
         m_ChunkStore->UnloadAll();
+        m_PendingWrites->Save();
+        m_RegionStorage->Close();
 
         m_State = WorldState::UNLOADED;
     }
@@ -122,6 +243,28 @@ namespace voxl
                 m_State = WorldState::UNLOADED;
                 return false;
             }
+
+            //Optional, older worlds use the default.
+            if (!JsonUtilities::VerifyValue("chunksPerSlab", json, m_Settings.chunksPerSlab) || m_Settings.chunksPerSlab == 0)
+            {
+                m_Settings.chunksPerSlab = WorldSettings().chunksPerSlab;
+            }
+
+            if (!JsonUtilities::VerifyValue("compressChunks", json, m_Settings.compressChunks))
+            {
+                m_Settings.compressChunks = WorldSettings().compressChunks;
+            }
+
+            if (!JsonUtilities::VerifyValue("chunkMemoryBudget", json, m_Settings.chunkMemoryBudget))
+            {
+                m_Settings.chunkMemoryBudget = WorldSettings().chunkMemoryBudget;
+            }
+
+            //Recorded when the world is first loaded with the default generator.
+            if (!JsonUtilities::VerifyValue("climateSpacing", json, m_Settings.climateSpacing))
+            {
+                m_Settings.climateSpacing = WorldSettings().climateSpacing;
+            }
         }
         else
         {
@@ -141,9 +284,81 @@ namespace voxl
             return false;
         }
 
+        //Chunks generated with other settings than the saved ones would not fit together.
+        const auto* defaultGenerator = dynamic_cast<const DefaultWorldGenerator*>(m_Generator.get());
+        if(defaultGenerator != nullptr)
+        {
+            const auto recorded = m_Settings.climateSpacing != 0;
+            if(!defaultGenerator->CheckWorldSettings(m_Settings))
+            {
+                m_State = WorldState::UNLOADED;
+                return false;
+            }
+            if(!recorded)
+            {
+                SaveWorldSettings(m_Settings);
+            }
+        }
+
         //Create the right types of voxel editor and chunk store.
-        m_VoxelEditor = std::make_unique<VoxelEditor>();
-        m_ChunkStore = std::make_unique<ChunkStore>();
+        m_Journal = std::make_unique<VoxelJournal>("worlds/" + m_Settings.name + "/journal/");
+        m_ThreadPool = &a_Server.GetThreadPool();
+        m_ConnectionManager = &a_Server.GetConnectionManager();
+        m_VoxelEditor = std::make_unique<VoxelEditor>(m_Journal.get(), m_ThreadPool, [this](const glm::ivec3& a_Coordinates)
+        {
+            return GetOrLoadChunk(a_Coordinates);
+        });
+        m_LightEngine = std::make_unique<LightEngine>(a_Server.GetVoxelRegistry(), m_ThreadPool);
+        m_Heightmaps = std::make_unique<HeightmapStore>(a_Server.GetVoxelRegistry());
+        m_ChunkStore = std::make_unique<ChunkStore>(m_Settings.chunksPerSlab);
+
+        //Chunks change the heights of their columns when they are added, however they were loaded. Chunks below lose their sky light right away.
+        m_ChunkStore->SetListener([this](IChunk& a_Chunk, bool a_Loaded)
+        {
+            if(a_Loaded)
+            {
+                m_Heightmaps->AddChunk(*m_ChunkStore, a_Chunk, m_HeightChanges);
+                OnChunkPublished(static_cast<Chunk&>(a_Chunk));
+            }
+            else
+            {
+                m_Heightmaps->RemoveChunk(a_Chunk.GetChunkCoordinates());
+                m_ChunksUnloaded = true;
+            }
+        });
+        m_RegionStorage = std::make_unique<RegionStorage>("worlds/" + m_Settings.name + "/regions/");
+        m_PendingWrites = std::make_unique<PendingWriteStore>(*m_RegionStorage, m_VoxelEditor.get());
+
+        const auto& serverSettings = a_Server.GetServerSettings();
+        m_Autosave = std::make_unique<AutosaveScheduler>(serverSettings.autosaveInterval, serverSettings.autosaveChunksPerTick, serverSettings.autosaveMicrosPerTick, m_Journal.get());
+        m_ChunkSendBytesPerTick = serverSettings.chunkSendTotalBytesPerTick;
+        m_Residency = std::make_unique<ChunkResidencyManager>(static_cast<std::uint64_t>(m_Settings.chunkMemoryBudget) * 1024 * 1024, m_Settings.renderDistance, [this](const glm::ivec3& a_Coordinates)
+        {
+            return LoadChunk(a_Coordinates);
+        });
+
+        m_Pipeline = std::make_unique<ChunkPipeline>(*m_ThreadPool, *m_ChunkStore, *m_RegionStorage, *m_PendingWrites, m_Generator, m_Settings.seed);
+
+        //Chunks around players are requested in order of distance, so that the closest ones are ready first.
+        const auto distance = static_cast<int>(m_Settings.renderDistance);
+        m_LoadOrder.clear();
+        for(int y = -distance; y <= distance; ++y)
+        {
+            for(int z = -distance; z <= distance; ++z)
+            {
+                for(int x = -distance; x <= distance; ++x)
+                {
+                    m_LoadOrder.emplace_back(x, y, z);
+                }
+            }
+        }
+        std::stable_sort(m_LoadOrder.begin(), m_LoadOrder.end(), [](const glm::ivec3& a_Left, const glm::ivec3& a_Right)
+        {
+            return a_Left.x * a_Left.x + a_Left.y * a_Left.y + a_Left.z * a_Left.z < a_Right.x * a_Right.x + a_Right.y * a_Right.y + a_Right.z * a_Right.z;
+        });
+
+        //Recover changes made after the last save, in case the server did not shut down properly.
+        ReplayJournal();
 
         //Done!
         m_State = WorldState::RUNNING;
@@ -154,14 +369,35 @@ namespace voxl
 
     void World::Tick(double a_DeltaTime)
     {
-        if (m_State != WorldState::UNLOADED)
+        if (m_State == WorldState::UNLOADED)
         {
             utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Can't tick world '" + m_Settings.name + "' that was not yet loaded.");
             return;
         }
 
+        //Report a finished asynchronous save.
+        if(m_SaveJob != nullptr && !IsSaving())
+        {
+            FinishSave(*m_SaveJob);
+            m_SaveJob.reset();
+        }
+
+        //Add chunks that finished loading or generating on the thread pool. Generated chunks are lit for the first time.
+        m_Pipeline->Update(&m_GeneratedChunks);
+        for(const auto& chunk : m_GeneratedChunks)
+        {
+            m_LightEngine->QueueChunk(chunk);
+        }
+        m_GeneratedChunks.clear();
+
         //Apply pending updates to the world.
         m_VoxelEditor->ApplyPendingChanges(*m_ChunkStore);
+        TouchEditedChunks();
+
+        //Relight around everything that changed, and send the changes with their new light.
+        QueueLightChanges();
+        m_LightEngine->Update(*m_ChunkStore, *m_Heightmaps);
+        SendVoxelChanges();
 
         //Spawn entities queued for spawning.
         for(auto& entity : m_EntityQueue)
@@ -210,13 +446,58 @@ namespace voxl
             //TODO Check if still controlling an entity that is near the chunk (world render distance).
             //TODO if not remove the player.
 
-            //Tick all chunks that are ready to be ticked.
-            if(chunk.GetState() == ChunkState::READY)
+            //Tick all chunks that are ready to be ticked. Uniform chunks have nothing to update, so skip the call entirely.
+            if(chunk.GetState() == ChunkState::READY && chunk.GetStorage() != ChunkStorage::UNIFORM)
             {
                 //Tick the chunk.
                 chunk.Tick(a_DeltaTime);
             }
         }
+
+        //Save some of the changed chunks. Skipped during an asynchronous save, as it could write a chunk before an older snapshot of it.
+        if(!IsSaving())
+        {
+            m_Autosave->Tick(a_DeltaTime, *m_ChunkStore, *m_RegionStorage, *m_PendingWrites, m_Settings.compressChunks);
+        }
+
+        //Players that moved into another chunk request the chunks around them, nearest first.
+        std::vector<glm::ivec3> playerChunks;
+        playerChunks.reserve(m_Players.size());
+        std::unordered_map<std::uint64_t, glm::ivec3> previousPlayerChunks;
+        previousPlayerChunks.swap(m_PlayerChunks);
+        for(auto& entry : m_Players)
+        {
+            const auto position = glm::floor(entry.second->GetTransform().GetTranslation() / static_cast<float>(CHUNK_SIZE));
+            const auto chunk = glm::ivec3(position);
+            playerChunks.emplace_back(chunk);
+            m_PlayerChunks.emplace(entry.first, chunk);
+
+            const auto previous = previousPlayerChunks.find(entry.first);
+            if(previous == previousPlayerChunks.end() || previous->second != chunk)
+            {
+                for(const auto& offset : m_LoadOrder)
+                {
+                    m_Pipeline->Request(chunk + offset);
+                }
+            }
+        }
+
+        //Unload chunks that are not used when over the memory budget. Dirty chunks are kept during a save for the same reason as above, and chunks in the save until it is written.
+        //Generated neighbours in the pipeline cannot be evicted, but use memory all the same.
+        m_Residency->Tick(*m_ChunkStore, *m_RegionStorage, *m_PendingWrites, playerChunks, m_Pipeline->GetMemoryUsage(), !IsSaving(), m_Settings.compressChunks);
+
+        //Generated neighbours are only needed while a chunk next to them is requested or loaded, so unloading chunks can make them useless.
+        if(m_ChunksUnloaded)
+        {
+            m_ChunksUnloaded = false;
+            m_Pipeline->DiscardUnrequested([this](const glm::ivec3& a_Coordinates)
+            {
+                return !HasNeighbourInUse(a_Coordinates);
+            });
+        }
+
+        //Chunks are sent after they were lit and before they can be unloaded by the next tick.
+        SendQueuedChunks(a_DeltaTime);
     }
 
     void World::SetWorldGenerator(std::shared_ptr<IWorldGenerator>& a_Generator)
@@ -265,6 +546,16 @@ namespace voxl
         return *m_VoxelEditor;
     }
 
+    std::int32_t World::GetSurfaceHeight(std::int32_t a_X, std::int32_t a_Z) const
+    {
+        if (m_State == WorldState::UNLOADED)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "Can't retrieve surface height for world that was not yet loaded.");
+            return HeightmapStore::NO_HEIGHT;
+        }
+        return m_Heightmaps->GetHeight(a_X, a_Z);
+    }
+
     const WorldSettings& World::GetSettings() const
     {
         if (m_State == WorldState::UNLOADED)
@@ -283,6 +574,10 @@ namespace voxl
         json["generator"] = m_Settings.generator;
         json["seed"] = m_Settings.seed;
         json["renderDistance"] = m_Settings.renderDistance;
+        json["chunksPerSlab"] = m_Settings.chunksPerSlab;
+        json["compressChunks"] = m_Settings.compressChunks;
+        json["chunkMemoryBudget"] = m_Settings.chunkMemoryBudget;
+        json["climateSpacing"] = m_Settings.climateSpacing;
 
         //Write to disk.
         const std::string path = "worlds/" + m_Settings.name + "/" + LEVEL_DATA_FILE_NAME;
@@ -336,4 +631,366 @@ namespace voxl
     {
         return m_State;
     }
-}
+
+    IChunk* World::LoadChunk(const glm::ivec3& a_Coordinates)
+    {
+        auto chunk = std::make_unique<Chunk>(a_Coordinates, *m_ChunkStore);
+        if(!m_RegionStorage->LoadChunk(*chunk))
+        {
+            return nullptr;
+        }
+
+        //Saved chunks were fully generated and populated, but neighbours populated later may have placed voxels in them.
+        const auto changed = m_PendingWrites->Apply(*chunk);
+        chunk->SetState(ChunkState::READY);
+        auto* loaded = m_ChunkStore->LoadChunk(std::move(chunk));
+        if(changed)
+        {
+            m_ChunkStore->MarkDirty(a_Coordinates);
+        }
+        return loaded;
+    }
+
+    IChunk* World::GetOrLoadChunk(const glm::ivec3& a_Coordinates)
+    {
+        return m_Residency->GetChunk(*m_ChunkStore, a_Coordinates);
+    }
+
+    RegionStorage& World::GetRegionStorage()
+    {
+        return *m_RegionStorage;
+    }
+
+    float World::GetSaveProgress() const
+    {
+        if(m_SaveJob == nullptr || m_SaveJob->totalChunks == 0)
+        {
+            return 1.f;
+        }
+        return static_cast<float>(m_SaveJob->writtenChunks) / static_cast<float>(m_SaveJob->totalChunks);
+    }
+
+    void World::WriteSnapshots(SaveJob& a_Job, std::vector<ChunkSnapshot>& a_Snapshots)
+    {
+        for(auto& snapshot : a_Snapshots)
+        {
+            if(m_Settings.compressChunks)
+            {
+                Chunk::CompactSerialized(snapshot.data);
+            }
+
+            if(!m_RegionStorage->SaveChunkData(snapshot.coordinates, snapshot.data.data(), snapshot.data.size()))
+            {
+                std::lock_guard<std::mutex> lock(a_Job.failedMutex);
+                a_Job.failedChunks.push_back(snapshot.coordinates);
+            }
+            ++a_Job.writtenChunks;
+        }
+
+        //The last batch makes sure everything actually reached the disk.
+        if(--a_Job.remainingBatches == 0)
+        {
+            m_RegionStorage->Flush();
+        }
+    }
+
+    void World::WaitForSave()
+    {
+        while(IsSaving())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void World::FinishSave(SaveJob& a_Job)
+    {
+        //Write what population placed in unloaded chunks during the save, and release the writes from memory.
+        m_PendingWrites->Save();
+
+        //No batches means nothing was written, so nothing was flushed either.
+        if(a_Job.totalChunks == 0)
+        {
+            m_RegionStorage->Flush();
+        }
+
+        for(const auto& coordinates : a_Job.chunks)
+        {
+            auto* chunk = m_ChunkStore->GetChunk(coordinates);
+            if(chunk != nullptr)
+            {
+                static_cast<Chunk*>(chunk)->SetSaving(false);
+            }
+        }
+
+        //Chunks that failed to save still need saving, as long as they are loaded.
+        for(const auto& coordinates : a_Job.failedChunks)
+        {
+            auto* chunk = m_ChunkStore->GetChunk(coordinates);
+            if(chunk != nullptr)
+            {
+                chunk->SetDirty(true);
+            }
+        }
+
+        //The journal is still needed to recover the failed chunks, also by the autosave checkpoint.
+        if(!a_Job.failedChunks.empty())
+        {
+            m_Autosave->InvalidateCheckpoint();
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Error, "World '" + m_Settings.name + "' failed to save " + std::to_string(a_Job.failedChunks.size()) + " chunks.");
+        }
+        else
+        {
+            m_Journal->DeleteBefore(a_Job.journalSegment);
+        }
+
+        //Report chunk memory usage so that the pool can be sized for this world.
+        const auto poolStats = m_ChunkStore->GetDataPool().getStats();
+        utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Info, "World '" + m_Settings.name + "' saved " + std::to_string(a_Job.totalChunks) + " chunks in " + std::to_string(a_Job.timer.measure(utilities::TimeUnit::MILLIS)) + " milliseconds.");
+        utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Info, "World '" + m_Settings.name + "' chunk pool: " + std::to_string(poolStats.used) + "/" + std::to_string(poolStats.capacity) + " chunks in use (peak " + std::to_string(poolStats.peakUsed) + ") across " + std::to_string(poolStats.slabCount) + " slabs.");
+
+        const auto& residency = m_Residency->GetStats();
+        utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Info, "World '" + m_Settings.name + "' chunk residency: " + std::to_string(residency.residentChunks) + " chunks using " + std::to_string(residency.residentBytes / 1024) + " KB (" + std::to_string(residency.pendingBytes / 1024) + " KB more in the pipeline), " + std::to_string(residency.hits) + " hits, " + std::to_string(residency.misses) + " misses, " + std::to_string(residency.evictions) + " evictions (" + std::to_string(residency.evictionSaves) + " saved first).");
+    }
+
+    void World::ReplayJournal()
+    {
+        const auto replayed = m_Journal->Replay([this](const glm::ivec3& a_ChunkCoordinates, std::uint32_t a_Index, const VoxelData& a_Data)
+        {
+            auto* chunk = GetOrLoadChunk(a_ChunkCoordinates);
+
+            //The chunk was changed before it was ever saved, so recreate it the same way.
+            if(chunk == nullptr)
+            {
+                std::vector<PendingWrite> writes;
+                auto generated = std::make_unique<Chunk>(a_ChunkCoordinates, *m_ChunkStore);
+                PopulateContext context(*generated, writes);
+                m_Generator->Generate(m_Settings.seed, *generated);
+                m_Generator->Populate(m_Settings.seed, *generated, context);
+                m_PendingWrites->Apply(*generated);
+                generated->SetState(ChunkState::READY);
+                chunk = m_ChunkStore->LoadChunk(std::move(generated));
+                m_PendingWrites->Add(*m_ChunkStore, writes);
+            }
+
+            if(a_Index == VoxelJournal::FILL_INDEX)
+            {
+                chunk->Fill(a_Data);
+                m_Heightmaps->UpdateChunk(*m_ChunkStore, *chunk, m_HeightChanges);
+                m_LightEngine->QueueChunk(a_ChunkCoordinates);
+            }
+            else
+            {
+                chunk->SetVoxel(a_Index, a_Data);
+                const auto position = a_ChunkCoordinates * CHUNK_SIZE + glm::ivec3(GetVoxelCoordinates(a_Index));
+                m_Heightmaps->UpdateVoxel(*m_ChunkStore, position, m_HeightChanges);
+                m_LightEngine->QueueVoxel(position);
+            }
+        });
+
+        if(replayed != 0)
+        {
+            utilities::ServiceLocator<utilities::Logger>::getService().log(utilities::Severity::Info, "World '" + m_Settings.name + "' recovered " + std::to_string(replayed) + " voxel changes from the journal.");
+
+            //The journal only holds the voxels, so light them again before they are saved.
+            QueueLightChanges();
+            m_LightEngine->Update(*m_ChunkStore, *m_Heightmaps);
+
+            //Write the recovered chunks, which also removes the replayed journal segments.
+            Save(false);
+        }
+    }
+
+    void World::SendVoxelChanges()
+    {
+        const auto& changes = m_VoxelEditor->GetAppliedChanges();
+        const auto& chunks = m_VoxelEditor->GetEditedChunks();
+        const auto& relitVoxels = m_LightEngine->GetRelitVoxels();
+        const auto& relitChunks = m_LightEngine->GetRelitChunks();
+        if(m_ConnectionManager == nullptr || (changes.empty() && chunks.empty() && relitVoxels.empty() && relitChunks.empty()))
+        {
+            return;
+        }
+
+        //Clients are only sent changes to the chunks they subscribed to.
+        for(auto* client : m_ConnectionManager->GetConnectedClients())
+        {
+            auto* connection = static_cast<ClientConnection*>(client);
+
+            //Changed voxels still hold their light from before the relight. The relit voxels are sent after them, so their new light wins.
+            m_ClientUpdates.clear();
+            for(const auto* updates : { &changes, &relitVoxels })
+            {
+                for(const auto& change : *updates)
+                {
+                    glm::ivec3 chunk;
+                    std::uint32_t index;
+                    VoxelToChunk(change.position, chunk, index);
+                    if(connection->IsSubscribed(chunk))
+                    {
+                        m_ClientUpdates.push_back(change);
+                    }
+                }
+            }
+            SendVoxelUpdates(m_ClientUpdates, *client);
+
+            //Whole chunks are large, so they wait their turn with the other chunks. They are read when sent, so later changes are included.
+            auto& queue = connection->GetChunkQueue();
+            for(const auto* coordinates : { &chunks, &relitChunks })
+            {
+                for(const auto& chunk : *coordinates)
+                {
+                    if(connection->IsSubscribed(chunk))
+                    {
+                        queue.Push(chunk);
+                    }
+                }
+            }
+        }
+    }
+
+    void World::SendQueuedChunks(double a_DeltaTime)
+    {
+        if(m_ConnectionManager == nullptr)
+        {
+            return;
+        }
+
+        std::vector<ClientConnection*> waiting;
+        for(auto* client : m_ConnectionManager->GetConnectedClients())
+        {
+            auto* connection = static_cast<ClientConnection*>(client);
+            auto& queue = connection->GetChunkQueue();
+
+            //Send the chunks around the controlled entity first, in the direction it looks.
+            const auto controller = connection->GetController();
+            auto* entity = controller != nullptr ? controller->GetEntity() : nullptr;
+            if(entity != nullptr)
+            {
+                auto& transform = entity->GetTransform();
+                queue.SetFocus(glm::ivec3(glm::floor(transform.GetTranslation() / static_cast<float>(CHUNK_SIZE))), transform.GetForward());
+            }
+
+            //The rate follows the link even while idle, so that it is known when chunks are queued.
+            queue.UpdateBudget(connection->GetLinkStats(), a_DeltaTime);
+            if(queue.GetPendingCount() != 0)
+            {
+                waiting.push_back(connection);
+            }
+        }
+
+        //Share the server's budget evenly. What a client does not use is left for the clients after it.
+        auto remaining = m_ChunkSendBytesPerTick == 0 ? std::numeric_limits<std::uint64_t>::max() : static_cast<std::uint64_t>(m_ChunkSendBytesPerTick);
+        for(std::size_t i = 0; i < waiting.size() && remaining > 0; ++i)
+        {
+            const auto share = remaining / (waiting.size() - i);
+            const auto sent = waiting[i]->GetChunkQueue().Send(*m_ChunkStore, *waiting[i], share, &m_SentChunks);
+            remaining -= std::min(sent, remaining);
+        }
+
+        //Sent chunks are in use by a client.
+        for(const auto& coordinates : m_SentChunks)
+        {
+            auto* chunk = m_ChunkStore->GetChunk(coordinates);
+            if(chunk != nullptr)
+            {
+                m_Residency->Touch(static_cast<Chunk&>(*chunk));
+            }
+        }
+        m_SentChunks.clear();
+    }
+
+    void World::OnChunkPublished(Chunk& a_Chunk)
+    {
+        //Clients may have subscribed before the chunk was loaded, or while it was unloaded.
+        if(m_ConnectionManager != nullptr)
+        {
+            const auto coordinates = a_Chunk.GetChunkCoordinates();
+            for(auto* client : m_ConnectionManager->GetConnectedClients())
+            {
+                if(static_cast<ClientConnection*>(client)->IsSubscribed(coordinates))
+                {
+                    a_Chunk.AddSubscriber();
+                }
+            }
+        }
+
+        //Chunks are published while the world loads, before there is a residency manager.
+        if(m_Residency != nullptr)
+        {
+            m_Residency->Touch(a_Chunk);
+        }
+    }
+
+    void World::TouchEditedChunks()
+    {
+        //Changes are grouped by chunk, so only look a chunk up when it differs from the last one.
+        Chunk* chunk = nullptr;
+        for(const auto& change : m_VoxelEditor->GetAppliedChanges())
+        {
+            glm::ivec3 coordinates;
+            std::uint32_t index;
+            VoxelToChunk(change.position, coordinates, index);
+            if(chunk == nullptr || chunk->GetChunkCoordinates() != coordinates)
+            {
+                chunk = static_cast<Chunk*>(m_ChunkStore->GetChunk(coordinates));
+                if(chunk == nullptr)
+                {
+                    continue;
+                }
+                m_Residency->Touch(*chunk);
+            }
+        }
+        for(const auto& coordinates : m_VoxelEditor->GetEditedChunks())
+        {
+            auto* edited = m_ChunkStore->GetChunk(coordinates);
+            if(edited != nullptr)
+            {
+                m_Residency->Touch(static_cast<Chunk&>(*edited));
+            }
+        }
+    }
+
+    bool World::HasNeighbourInUse(const glm::ivec3& a_Coordinates) const
+    {
+        for(int y = -1; y <= 1; ++y)
+        {
+            for(int z = -1; z <= 1; ++z)
+            {
+                for(int x = -1; x <= 1; ++x)
+                {
+                    const auto neighbour = a_Coordinates + glm::ivec3(x, y, z);
+                    if((x != 0 || y != 0 || z != 0) && (m_ChunkStore->GetChunk(neighbour) != nullptr || m_Pipeline->IsRequested(neighbour)))
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void World::QueueLightChanges()
+    {
+        for(const auto& change : m_VoxelEditor->GetAppliedChanges())
+        {
+            m_Heightmaps->UpdateVoxel(*m_ChunkStore, change.position, m_HeightChanges);
+            m_LightEngine->QueueVoxel(change.position);
+        }
+        for(const auto& coordinates : m_VoxelEditor->GetEditedChunks())
+        {
+            auto* chunk = m_ChunkStore->GetChunk(coordinates);
+            if(chunk != nullptr)
+            {
+                m_Heightmaps->UpdateChunk(*m_ChunkStore, *chunk, m_HeightChanges);
+            }
+            m_LightEngine->QueueChunk(coordinates);
+        }
+
+        //Includes the changes of chunks that were added since the last call.
+        for(const auto& change : m_HeightChanges)
+        {
+            m_LightEngine->QueueHeightChange(change);
+        }
+        m_HeightChanges.clear();
+    }
+}
\ No newline at end of file
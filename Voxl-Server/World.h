@@ -1,23 +1,46 @@
 #pragma once
+#include <atomic>
 #include <IWorld.h>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <unordered_map>
+#include <vector>
 
+#include <time/Timer.h>
+
+#include "AutosaveScheduler.h"
+#include "ChunkPipeline.h"
+#include "ChunkResidencyManager.h"
+#include "ChunkStore.h"
+#include "HeightmapStore.h"
+#include "LightEngine.h"
+#include "PendingWriteStore.h"
 #include "Player.h"
+#include "RegionStorage.h"
+#include "VoxelJournal.h"
 
 #define LEVEL_DATA_FILE_NAME "leveldata.json"
 
+namespace utilities
+{
+    class ThreadPool;
+}
+
 namespace voxl
 {
+    class Chunk;
     class IClientConnection;
+    class IConnectionManager;
 
     class World : public IWorld
 	{
     public:
         World(const std::string& a_Name);
+        ~World() override;
 
         const std::string& GetName() override;
-        void Save() override;
+        void Save(bool a_Async) override;
+        bool IsSaving() const override;
         void Unload() override;
         bool Load(IServer& a_Server) override;
         void Tick(double a_DeltaTime) override;
@@ -26,6 +49,7 @@ namespace voxl
         IGameMode& GetGameMode() override;
         IChunkStore& GetChunkStore() override;
         IVoxelEditor& GetVoxelEditor() override;
+        std::int32_t GetSurfaceHeight(std::int32_t a_X, std::int32_t a_Z) const override;
         const WorldSettings& GetSettings() const override;
         void SaveWorldSettings(const WorldSettings& a_Settings) override;
         IEntity& AddEntity(std::unique_ptr<IEntity>&& a_Entity) override;
@@ -34,12 +58,159 @@ namespace voxl
         IEntity* GetEntity(std::uint64_t a_Id) override;
         IPlayer* GetPlayer(std::uint64_t a_Id) override;
         WorldState GetWorldState() const override;
+
+        /*
+         * Load the chunk at the given coordinates from disk and add it to the chunk store.
+         * Returns nullptr if the chunk was never saved.
+         */
+        IChunk* LoadChunk(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Get the chunk at the given coordinates, loading it from disk if needed.
+         * The chunk is marked as used, so that it is not evicted soon.
+         */
+        IChunk* GetOrLoadChunk(const glm::ivec3& a_Coordinates);
+
+        /*
+         * Get the region files that chunks in this world are saved to.
+         */
+        RegionStorage& GetRegionStorage();
+
+        /*
+         * Get the fraction of chunks written by the running save, between 0 and 1.
+         * Returns 1 when no save is running.
+         */
+        float GetSaveProgress() const;
 	private:
+        /*
+         * The serialized voxels of a chunk, taken when a save starts.
+         */
+        struct ChunkSnapshot
+        {
+            glm::ivec3 coordinates;
+            std::vector<std::uint8_t> data;
+        };
+
+        /*
+         * Progress of a save. Shared between the world and the tasks writing the snapshots.
+         */
+        struct SaveJob
+        {
+            std::uint32_t totalChunks = 0;
+            std::atomic<std::uint32_t> writtenChunks{ 0 };
+            std::atomic<std::uint32_t> remainingBatches{ 0 };
+
+            //Journal segment started when the snapshots were taken. Older segments are no longer needed once the save succeeded.
+            std::uint32_t journalSegment = 0;
+
+            //Chunks with a snapshot in an asynchronous save. They are kept loaded until the save finishes.
+            std::vector<glm::ivec3> chunks;
+
+            //Chunks that could not be written. They are marked dirty again when the save finishes.
+            std::mutex failedMutex;
+            std::vector<glm::ivec3> failedChunks;
+
+            utilities::Timer timer;
+        };
+
+        /*
+         * Compress and write a batch of snapshots to the region files. Runs on the thread pool for asynchronous saves.
+         */
+        void WriteSnapshots(SaveJob& a_Job, std::vector<ChunkSnapshot>& a_Snapshots);
+
+        /*
+         * Block until all batches of the running save have been written.
+         */
+        void WaitForSave();
+
+        /*
+         * Handle the results of a save after all batches were written. Called on the tick thread.
+         */
+        void FinishSave(SaveJob& a_Job);
+
+        /*
+         * Apply the changes in the journal that did not make it into the region files, and save the affected chunks.
+         */
+        void ReplayJournal();
+
+        /*
+         * Send the voxels changed and relit in this tick to the clients subscribed to their chunks. Chunks that changed or were relit as a whole are queued.
+         */
+        void SendVoxelChanges();
+
+        /*
+         * Send the chunks queued for every client, nearest to the client first and within the bandwidth of each client and the server.
+         */
+        void SendQueuedChunks(double a_DeltaTime);
+
+        /*
+         * Restore the subscriber count of a chunk that was added to the store, and mark it as used.
+         */
+        void OnChunkPublished(Chunk& a_Chunk);
+
+        /*
+         * Mark the chunks changed by the voxel editor in this tick as used.
+         */
+        void TouchEditedChunks();
+
+        /*
+         * Returns true if any of the 26 chunks around the given one is loaded or requested from the pipeline.
+         */
+        bool HasNeighbourInUse(const glm::ivec3& a_Coordinates) const;
+
+        /*
+         * Update the heightmaps for the voxels changed in this tick, and queue relighting everything that changed.
+         */
+        void QueueLightChanges();
+
+    private:
+        //Amount of chunks written per thread pool task.
+        static constexpr std::size_t SAVE_BATCH_SIZE = 64;
+
         WorldSettings m_Settings;
         WorldState m_State;
 
+        //Log of voxel changes since the last save. Declared before the voxel editor, which writes to it.
+        std::unique_ptr<VoxelJournal> m_Journal;
         std::unique_ptr<IVoxelEditor> m_VoxelEditor;
-        std::unique_ptr<IChunkStore> m_ChunkStore;
+        std::unique_ptr<ChunkStore> m_ChunkStore;
+        std::unique_ptr<RegionStorage> m_RegionStorage;
+        utilities::ThreadPool* m_ThreadPool;
+
+        //The clients that are sent the changes made to the world, and the most bytes of chunks sent to all of them per tick.
+        IConnectionManager* m_ConnectionManager;
+        std::uint32_t m_ChunkSendBytesPerTick;
+        std::vector<glm::ivec3> m_SentChunks;
+        std::vector<VoxelChange> m_ClientUpdates;
+
+        //Keeps the light of the loaded chunks up to date with the changes made by the voxel editor.
+        //The heightmaps follow the chunk store, and tell the light engine where sky light comes in.
+        std::unique_ptr<LightEngine> m_LightEngine;
+        std::unique_ptr<HeightmapStore> m_Heightmaps;
+        std::vector<HeightChange> m_HeightChanges;
+        std::vector<glm::ivec3> m_GeneratedChunks;
+
+        //Voxels placed by population in chunks that were not available yet.
+        std::unique_ptr<PendingWriteStore> m_PendingWrites;
+
+        //The save that is currently running, or nullptr.
+        std::shared_ptr<SaveJob> m_SaveJob;
+
+        //Saves dirty chunks a few at a time between full saves.
+        std::unique_ptr<AutosaveScheduler> m_Autosave;
+
+        //Unloads unused chunks when they use more memory than allowed.
+        std::unique_ptr<ChunkResidencyManager> m_Residency;
+
+        //Loads, generates and populates chunks on the thread pool. Declared after the stores, as it holds chunks that use them.
+        std::unique_ptr<ChunkPipeline> m_Pipeline;
+
+        //Set when chunks left the store, after which generated neighbours in the pipeline may no longer be needed.
+        bool m_ChunksUnloaded;
+
+        //The chunk every player was in during the last tick, and the offsets of the chunks to request around a player.
+        std::unordered_map<std::uint64_t, glm::ivec3> m_PlayerChunks;
+        std::vector<glm::ivec3> m_LoadOrder;
         std::shared_ptr<IWorldGenerator> m_Generator;
         std::shared_ptr<IGameMode> m_GameMode;
 
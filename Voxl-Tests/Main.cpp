@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ChunkRandom.h>
+#include <IChunk.h>
+#include <IWorld.h>
+#include <Utility.h>
+#include <logging/Logger.h>
+#include <other/ServiceLocator.h>
+#include <threads/ThreadPool.h>
+
+#include "ChunkPipeline.h"
+#include "ChunkStore.h"
+#include "DefaultWorldGenerator.h"
+#include "PendingWriteStore.h"
+#include "RegionStorage.h"
+
+namespace
+{
+    //Seed of the generated region. Any seed works.
+    constexpr std::uint64_t SEED = 0x5EED;
+
+    //The region that is generated, in chunks. Large enough that neighbouring chunks end up on different threads.
+    const glm::ivec3 REGION_MIN(-4, -2, -4);
+    const glm::ivec3 REGION_MAX(4, 2, 4);
+
+    //Region files are written here, one directory per run.
+    const std::string TEST_DIRECTORY = "tests/determinism/";
+
+    /*
+     * Get the chunks of the test region, in a fixed order.
+     */
+    std::vector<glm::ivec3> GetRegionChunks()
+    {
+        std::vector<glm::ivec3> chunks;
+        for(int y = REGION_MIN.y; y < REGION_MAX.y; ++y)
+        {
+            for(int z = REGION_MIN.z; z < REGION_MAX.z; ++z)
+            {
+                for(int x = REGION_MIN.x; x < REGION_MAX.x; ++x)
+                {
+                    chunks.emplace_back(x, y, z);
+                }
+            }
+        }
+        return chunks;
+    }
+
+    /*
+     * Generate and populate the test region through the chunk pipeline on a_Threads threads, and hash the voxels of all its chunks.
+     */
+    std::uint64_t HashGeneratedRegion(std::uint32_t a_Threads)
+    {
+        const auto directory = TEST_DIRECTORY + std::to_string(a_Threads) + "/";
+        std::filesystem::remove_all(directory);
+
+        utilities::ThreadPool threadPool(a_Threads);
+        voxl::ChunkStore chunkStore(voxl::WorldSettings().chunksPerSlab);
+        voxl::RegionStorage regionStorage(directory);
+        voxl::PendingWriteStore pendingWrites(regionStorage);
+        voxl::ChunkPipeline pipeline(threadPool, chunkStore, regionStorage, pendingWrites, std::make_shared<voxl::DefaultWorldGenerator>(), SEED);
+
+        const auto chunks = GetRegionChunks();
+        for(const auto& coordinates : chunks)
+        {
+            pipeline.Request(coordinates);
+        }
+
+        std::size_t ready = 0;
+        while(ready < chunks.size())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            pipeline.Update();
+            ready = static_cast<std::size_t>(std::count_if(chunks.begin(), chunks.end(), [&chunkStore](const glm::ivec3& a_Coordinates)
+            {
+                return chunkStore.GetChunk(a_Coordinates) != nullptr;
+            }));
+        }
+        pipeline.WaitForJobs();
+
+        std::uint64_t hash = voxl::Mix64(SEED);
+        std::vector<voxl::VoxelData> voxels(CHUNK_SIZE_CUBED);
+        for(const auto& coordinates : chunks)
+        {
+            chunkStore.GetChunk(coordinates)->GetVoxels(voxels.data());
+            for(const auto& voxel : voxels)
+            {
+                hash = voxl::Mix64(hash ^ (voxel.id | (static_cast<std::uint64_t>(voxel.metaData) << 16) | (static_cast<std::uint64_t>(voxel.lightLevel) << 24)));
+            }
+        }
+
+        std::filesystem::remove_all(directory);
+        return hash;
+    }
+
+    /*
+     * Generating the same region on a single thread and on all threads has to give the same voxels.
+     */
+    bool TestGenerationDeterminism(std::uint32_t a_Threads)
+    {
+        const auto single = HashGeneratedRegion(1);
+        const auto parallel = HashGeneratedRegion(a_Threads);
+        std::cout << "Region hash on 1 thread: " << std::hex << single << ", on " << std::dec << a_Threads << " threads: " << std::hex << parallel << std::dec << std::endl;
+        return single == parallel;
+    }
+
+    /*
+     * Chunk random streams drawn from all threads in reverse order have to match the ones drawn in order on one thread.
+     */
+    bool TestChunkRandomDeterminism(std::uint32_t a_Threads)
+    {
+        static constexpr std::size_t DRAWS = 64;
+
+        const auto chunks = GetRegionChunks();
+        const auto draw = [&chunks](std::size_t a_Chunk, std::uint64_t* a_Output)
+        {
+            voxl::ChunkRandom random(SEED, chunks[a_Chunk], voxl::DefaultWorldGenerator::STAGE_BOULDERS);
+            for(std::size_t i = 0; i < DRAWS; ++i)
+            {
+                a_Output[i] = random.NextUInt64();
+            }
+        };
+
+        std::vector<std::uint64_t> serial(chunks.size() * DRAWS);
+        for(std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            draw(i, &serial[i * DRAWS]);
+        }
+
+        utilities::ThreadPool threadPool(a_Threads);
+        std::vector<std::uint64_t> parallel(chunks.size() * DRAWS);
+        threadPool.parallelFor(chunks.size(), [&](std::size_t a_Index, std::size_t)
+        {
+            const auto chunk = chunks.size() - 1 - a_Index;
+            draw(chunk, &parallel[chunk * DRAWS]);
+        });
+
+        return serial == parallel;
+    }
+}
+
+int main()
+{
+    utilities::Logger logger("logs/Tests.txt");
+    logger.setConsoleLogging(true);
+    utilities::ServiceLocator<utilities::Logger>::setService(&logger);
+
+    const auto threads = std::max(2u, std::thread::hardware_concurrency());
+    auto failed = 0;
+
+    const auto run = [&failed](const std::string& a_Name, bool a_Passed)
+    {
+        std::cout << (a_Passed ? "PASSED " : "FAILED ") << a_Name << std::endl;
+        if(!a_Passed)
+        {
+            ++failed;
+        }
+    };
+
+    run("ChunkRandom determinism", TestChunkRandomDeterminism(threads));
+    run("Generation determinism", TestGenerationDeterminism(threads));
+
+    return failed == 0 ? 0 : 1;
+}